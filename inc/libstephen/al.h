@@ -13,6 +13,10 @@
   the linked list ones.  It also supports the use of the generic list interface,
   so both array lists and linked lists can be used interchangeably, in C!
 
+  The items are kept in the middle of the allocated space, so adding and
+  removing at the front is as cheap as at the back.  Inserting or removing in
+  the middle moves whichever side of the list is shorter.
+
   @copyright    Copyright (c) 2013-2016, Stephen Brennan.  Released under the
                 Revised BSD License.  See the LICENSE.txt file for details.
 
@@ -24,6 +28,12 @@
 #include "base.h"  /* DATA     */
 #include "list.h"  /* smb_list */
 
+/**
+   @brief The number of items per thread that the parallel operations use when
+   they aren't given a grain size.
+ */
+#define SMB_AL_PAR_GRAIN 16384
+
 /**
    @brief The actual array list data type.
 
@@ -34,9 +44,18 @@ typedef struct smb_al
 {
   /**
      @brief The area of memory containing the data.
+
+     Items are stored contiguously from data[start] to data[start + length - 1].
+     The free space on either side lets items be added and removed at both ends
+     without moving the rest of the list.
    */
   DATA *data;
 
+  /**
+     @brief The index in data of the first item in the list.
+   */
+  int start;
+
   /**
      @brief The number of items in the list.
    */
@@ -44,6 +63,10 @@ typedef struct smb_al
 
   /**
      @brief The space allocated for the list.
+
+     When one end runs out of room, the items are moved back to the middle if
+     the list is at most half full, and otherwise this doubles.  Either way,
+     pushes and pops at both ends are amortized constant time.
    */
   int allocated;
 
@@ -56,11 +79,26 @@ typedef struct smb_al
    stack and initialize it, rather than allocating space on the heap.
  */
 void al_init(smb_al *list);
+/**
+   @brief Initialize an empty array list with room for a given number of items.
+
+   Appending up to capacity items to the list will not reallocate it.
+   @param list The list to initialize.
+   @param capacity The number of items to allocate space for.
+ */
+void al_init_capacity(smb_al *list, int capacity);
 /**
    @brief Allocate and initialize an empty array list.
    @returns A pointer to the new array list.
  */
 smb_al *al_create();
+/**
+   @brief Allocate and initialize an empty array list with room for a given
+   number of items.
+   @param capacity The number of items to allocate space for.
+   @returns A pointer to the new array list.
+ */
+smb_al *al_create_capacity(int capacity);
 /**
    @brief Free the resources used by the array list, but don't actually free the
    pointer given.
@@ -87,6 +125,27 @@ smb_list al_create_list();
  */
 smb_list al_cast_to_list(smb_al *list);
 
+/**
+   @brief Make sure the list has room for at least capacity items.
+
+   This never shrinks the list.  When the final size of a list is known ahead of
+   time, reserving it first means that the appends will only allocate once.
+   @param list The list to reserve space in.
+   @param capacity The number of items the list should have room for.
+ */
+void al_reserve(smb_al *list, int capacity);
+/**
+   @brief Release any space allocated beyond the current length of the list.
+   @param list The list to shrink.
+ */
+void al_shrink_to_fit(smb_al *list);
+/**
+   @brief Return the number of items the list has room for without growing.
+   @param list A pointer to the list.
+   @returns The capacity of the list.
+ */
+int al_capacity(const smb_al *list);
+
 /**
    @brief Append an item to the end of a list.
    @param list A pointer to the list to append to.
@@ -128,6 +187,48 @@ void al_remove(smb_al *list, int index, smb_status *status);
    @param newData The data to insert.
  */
 void al_insert(smb_al *list, int index, DATA newData);
+/**
+   @brief Append an array of items to the end of the list.
+
+   This grows the list at most once, and copies the items in one go.
+   @param list A pointer to the list to append to.
+   @param items The items to append.  They may be items of the list itself.
+   @param n The number of items.
+ */
+void al_extend(smb_al *list, const DATA *items, int n);
+/**
+   @brief Insert an array of items at the specified location in the list.
+
+   The items already in the list from index on end up after the new ones.  As
+   with al_insert(), an index less than 0 is treated as 0, and an index greater
+   than the length of the list is treated as the length.  Only the shorter side
+   of the list is moved, and only once.
+   @param list A pointer to the list to insert into.
+   @param index The index the first new item will have.
+   @param items The items to insert.  They may be items of the list itself.
+   @param n The number of items.
+ */
+void al_insert_range(smb_al *list, int index, const DATA *items, int n);
+/**
+   @brief Remove n items from the list, starting at the given index.
+   @param list A pointer to the list to remove from.
+   @param index The index of the first item to remove.
+   @param n The number of items to remove.
+   @param[out] status Status variable.
+   @exception SMB_INDEX_ERROR If any of the items is out of range.
+ */
+void al_remove_range(smb_al *list, int index, int n, smb_status *status);
+/**
+   @brief Copy n items, starting at the given index, into a new array list.
+   @param list A pointer to the list to copy from.
+   @param index The index of the first item to copy.
+   @param n The number of items to copy.
+   @param[out] status Status variable.
+   @returns A new array list, which the caller must al_delete(), or NULL on
+   error.
+   @exception SMB_INDEX_ERROR If any of the items is out of range.
+ */
+smb_al *al_slice(const smb_al *list, int index, int n, smb_status *status);
 /**
    @brief Sets the item at the given index.
 
@@ -206,6 +307,73 @@ int al_length(const smb_al *list);
  */
 int al_index_of(const smb_al *list, DATA d, DATA_COMPARE comp);
 
+/**
+   @brief Sort the list in place.
+
+   This is an introsort, so it takes O(n log n) time for any input, but it is
+   not stable.  When cmp is data_compare_int() or data_compare_float(), large
+   lists are sorted with a radix sort on the integers or doubles instead, which
+   is linear and never calls the comparator.  NaNs are not ordered.
+   @param list A pointer to the list to sort.
+   @param cmp Comparator to order by.
+ */
+void al_sort(smb_al *list, DATA_COMPARE cmp);
+
+/**
+   @brief Apply a function to every item in the list, using several threads.
+
+   Like ll_map(), this replaces each item with the result of map_function.  The
+   list is split into one contiguous piece per thread, with one thread for each
+   processor, but no more than leaves every thread grain items.  So
+   map_function may be called from several threads at once.
+   @param list The list to map over.
+   @param map_function Function to apply.
+   @param grain The fewest items worth giving a thread.  If this is 0 or less,
+   SMB_AL_PAR_GRAIN is used.
+ */
+void al_par_map(smb_al *list, DATA (*map_function)(DATA), int grain);
+/**
+   @brief Remove every item for which test_function returns true, using
+   several threads.
+
+   Like ll_filter(), the remaining items keep their order.  The threads are
+   split up as in al_par_map().
+   @param list The list to filter.
+   @param test_function Returns true if an item should be removed.
+   @param grain The fewest items worth giving a thread, or 0 or less for
+   SMB_AL_PAR_GRAIN.
+ */
+void al_par_filter(smb_al *list, bool (*test_function)(DATA), int grain);
+/**
+   @brief Reduce the list with a function, using several threads.
+
+   Each thread reduces its piece of the list from left to right, and then the
+   pieces' results are reduced into start_value in order.  So this is the same
+   as a left fold (see ll_foldl()) whenever reduction is associative, and
+   start_value is an identity for it.
+   @param list The list to reduce.
+   @param start_value Initial value of the reduction.
+   @param reduction An associative function to reduce with.
+   @param grain The fewest items worth giving a thread, or 0 or less for
+   SMB_AL_PAR_GRAIN.
+   @returns The result of the reduction.
+ */
+DATA al_par_reduce(const smb_al *list, DATA start_value,
+                   DATA (*reduction)(DATA, DATA), int grain);
+/**
+   @brief Sort the list using several threads.
+
+   Each thread sorts its piece of the list like al_sort(), and then pairs of
+   sorted pieces are merged in parallel until one is left.  This uses a
+   temporary buffer the size of the list.
+   @param list The list to sort.
+   @param cmp Comparator to order by.  It may be called from several threads at
+   once.
+   @param grain The fewest items worth giving a thread, or 0 or less for
+   SMB_AL_PAR_GRAIN.
+ */
+void al_par_sort(smb_al *list, DATA_COMPARE cmp, int grain);
+
 /**
    @brief Return an iterator on the array list.
    @param list A pointer to the list.
@@ -213,4 +381,10 @@ int al_index_of(const smb_al *list, DATA d, DATA_COMPARE comp);
  */
 smb_iter al_get_iter(const smb_al *list);
 
+/**
+   Sort an array of n DATA, as al_sort() does.  Not really public, but shared
+   for the parallel operations.
+ */
+void al_sort_array(DATA *a, int n, DATA_COMPARE cmp);
+
 #endif // LIBSTEPHEN_AL_H
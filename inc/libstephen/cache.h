@@ -0,0 +1,246 @@
+/***************************************************************************//**
+
+  @file         libstephen/cache.h
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        A bounded least recently used (LRU) cache.
+
+  @copyright    Copyright (c) 2013-2016, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+  The cache holds at most a fixed number of key, value pairs.  When it is full,
+  putting a new key evicts the least recently used one.  Entries are allocated
+  once, up front, and each is both a hash table entry and a node in a doubly
+  linked list ordered by recency, so gets, puts and evictions are all constant
+  time.
+
+*******************************************************************************/
+
+#ifndef LIBSTEPHEN_CACHE_H
+#define LIBSTEPHEN_CACHE_H
+
+#include "base.h"
+#include "ht.h"  /* HASH_FUNCTION */
+
+/**
+   @brief Index slot which holds no entry.
+ */
+#define CACHE_EMPTY (-1)
+
+/**
+   @brief An entry of the cache.
+ */
+typedef struct smb_cache_entry
+{
+  /**
+     @brief The key of this entry.
+   */
+  DATA key;
+
+  /**
+     @brief The value of this entry.
+   */
+  DATA value;
+
+  /**
+     @brief The seeded hash of the key.
+   */
+  unsigned int hash;
+
+  /**
+     @brief The next more recently used entry (or the next free entry).
+   */
+  struct smb_cache_entry *prev;
+
+  /**
+     @brief The next less recently used entry.
+   */
+  struct smb_cache_entry *next;
+
+} smb_cache_entry;
+
+/**
+   @brief A bounded LRU cache.
+ */
+typedef struct smb_cache
+{
+  /**
+     @brief The number of items in the cache.
+   */
+  unsigned int length;
+
+  /**
+     @brief The maximum number of items in the cache.
+   */
+  unsigned int capacity;
+
+  /**
+     @brief The number of index slots (a power of two, at least twice the
+     capacity).
+   */
+  unsigned int allocated;
+
+  /**
+     @brief The hash function for keys.
+   */
+  HASH_FUNCTION hash;
+
+  /**
+     @brief Function to use to compare keys.
+   */
+  DATA_COMPARE equal;
+
+  /**
+     @brief Action performed on the value of each evicted entry, or NULL.
+   */
+  DATA_ACTION evict;
+
+  /**
+     @brief Linear probing index: the position of an entry, or CACHE_EMPTY.
+   */
+  int *index;
+
+  /**
+     @brief All capacity entries, used or free.
+   */
+  smb_cache_entry *entries;
+
+  /**
+     @brief The most recently used entry.
+   */
+  smb_cache_entry *head;
+
+  /**
+     @brief The least recently used entry (the next to be evicted).
+   */
+  smb_cache_entry *tail;
+
+  /**
+     @brief Unused entries, linked through their prev pointers.
+   */
+  smb_cache_entry *free;
+
+  /**
+     @brief Random seed mixed into every hash (see ht_seed_hash()).
+   */
+  unsigned int seed;
+
+  /**
+     @brief The number of gets which found their key.
+   */
+  unsigned long hits;
+
+  /**
+     @brief The number of gets which did not find their key.
+   */
+  unsigned long misses;
+
+  /**
+     @brief The number of entries evicted to make room for new ones.
+   */
+  unsigned long evictions;
+
+} smb_cache;
+
+/**
+   @brief Initialize a cache in memory already allocated.
+   @param cache A pointer to the cache to initialize.
+   @param capacity The maximum number of items (at least one, and at most
+   HASH_TABLE_MAX_SIZE / 2).
+   @param hash_func A hash function for keys.
+   @param equal A comparison function for keys.
+   @param evict An action to perform on the value of each evicted entry (e.g.
+   freeing it), or NULL.
+ */
+void cache_init(smb_cache *cache, unsigned int capacity,
+                HASH_FUNCTION hash_func, DATA_COMPARE equal, DATA_ACTION evict);
+/**
+   @brief Allocate and initialize a cache.
+   @param capacity The maximum number of items (at least one, and at most
+   HASH_TABLE_MAX_SIZE / 2).
+   @param hash_func A hash function for keys.
+   @param equal A comparison function for keys.
+   @param evict An action to perform on the value of each evicted entry, or
+   NULL.
+   @returns A pointer to the new cache.
+ */
+smb_cache *cache_create(unsigned int capacity, HASH_FUNCTION hash_func,
+                        DATA_COMPARE equal, DATA_ACTION evict);
+/**
+   @brief Free resources used by the cache, but not the pointer itself.
+   Perform an action on each value first.
+   @param cache The cache to destroy.
+   @param deleter The action to perform on each value.
+ */
+void cache_destroy_act(smb_cache *cache, DATA_ACTION deleter);
+/**
+   @brief Free resources used by the cache, but not the pointer itself.
+   @param cache The cache to destroy.
+ */
+void cache_destroy(smb_cache *cache);
+/**
+   @brief Free the cache and its resources.  Perform an action on each value
+   first.
+   @param cache The cache to free.
+   @param deleter The action to perform on each value.
+ */
+void cache_delete_act(smb_cache *cache, DATA_ACTION deleter);
+/**
+   @brief Free the cache and its resources.
+   @param cache The cache to free.
+ */
+void cache_delete(smb_cache *cache);
+
+/**
+   @brief Put a key, value pair in the cache, making it the most recently used.
+
+   If the key is already present, its value is replaced (without calling the
+   eviction action on the old one).  Otherwise, if the cache is full, the least
+   recently used entry is evicted first.
+   @param cache The cache.
+   @param key The key.
+   @param value The value.
+ */
+void cache_put(smb_cache *cache, DATA key, DATA value);
+/**
+   @brief Get the value of a key, making it the most recently used.
+
+   This counts a hit or a miss.
+   @param cache The cache.
+   @param key The key.
+   @param[out] status Status variable.
+   @returns The value.
+   @exception SMB_NOT_FOUND_ERROR If the key is not in the cache.
+ */
+DATA cache_get(smb_cache *cache, DATA key, smb_status *status);
+/**
+   @brief Return true when a key is in the cache.
+
+   This neither changes the recency of the key, nor counts a hit or miss.
+   @param cache The cache.
+   @param key The key.
+ */
+bool cache_contains(smb_cache const *cache, DATA key);
+/**
+   @brief Remove a key from the cache, performing an action on its value.
+   @param cache The cache.
+   @param key The key.
+   @param deleter The action to perform on the value, or NULL.
+   @param[out] status Status variable.
+   @exception SMB_NOT_FOUND_ERROR If the key is not in the cache.
+ */
+void cache_remove_act(smb_cache *cache, DATA key, DATA_ACTION deleter,
+                      smb_status *status);
+/**
+   @brief Remove a key from the cache.
+   @param cache The cache.
+   @param key The key.
+   @param[out] status Status variable.
+   @exception SMB_NOT_FOUND_ERROR If the key is not in the cache.
+ */
+void cache_remove(smb_cache *cache, DATA key, smb_status *status);
+
+#endif // LIBSTEPHEN_CACHE_H
@@ -0,0 +1,178 @@
+/***************************************************************************//**
+
+  @file         libstephen/cht.h
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        A concurrent hash table, built from locked hash tables.
+
+  @copyright    Copyright (c) 2013-2016, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#ifndef LIBSTEPHEN_CHT_H
+#define LIBSTEPHEN_CHT_H
+
+#include <pthread.h>
+
+#include "base.h"
+#include "ht.h"
+
+/**
+   @brief The number of segments used when none is specified.
+ */
+#define SMB_CHT_DEFAULT_SEGMENTS 16
+
+/**
+   @brief One independently locked part of a concurrent hash table.
+ */
+typedef struct smb_cht_seg
+{
+  /**
+     @brief Lock protecting the table.  Lookups take it for reading, so they
+     only wait on writers to the same segment.
+   */
+  pthread_rwlock_t lock;
+
+  /**
+     @brief The keys in this segment.
+   */
+  smb_ht table;
+
+} smb_cht_seg;
+
+/**
+   @brief A thread safe hash table.
+
+   Keys are divided among several segments by their hash, and each segment is a
+   regular smb_ht with its own read-write lock.  Threads only contend when they
+   use the same segment at the same time, and readers never block each other.
+ */
+typedef struct smb_cht
+{
+  /**
+     @brief The number of segments (a power of two).
+   */
+  unsigned int nsegments;
+
+  /**
+     @brief The hash function for this hash table.
+   */
+  HASH_FUNCTION hash;
+
+  /**
+     @brief Random seed used to choose segments.
+   */
+  unsigned int seed;
+
+  /**
+     @brief The segments.
+   */
+  smb_cht_seg *segments;
+
+} smb_cht;
+
+/**
+   @brief Initialize a concurrent hash table in memory already allocated.
+   @param table A pointer to the table to initialize.
+   @param hash_func A hash function for the table.
+   @param equal A comparison function for DATA.
+   @param nsegments The number of segments (rounded up to a power of two).  A
+   few times the number of threads is a good choice.  Zero selects
+   SMB_CHT_DEFAULT_SEGMENTS.
+ */
+void cht_init(smb_cht *table, HASH_FUNCTION hash_func, DATA_COMPARE equal,
+              unsigned int nsegments);
+/**
+   @brief Allocate and initialize a concurrent hash table.
+   @param hash_func A hash function for the table.
+   @param equal A comparison function for DATA.
+   @param nsegments The number of segments, see cht_init().
+   @returns A pointer to the new hash table.
+ */
+smb_cht *cht_create(HASH_FUNCTION hash_func, DATA_COMPARE equal,
+                    unsigned int nsegments);
+/**
+   @brief Free resources used by the hash table, but not the pointer itself.
+   Perform an action on the values as they are deleted.
+
+   No other thread may be using the table.
+   @param table The table to destroy.
+   @param deleter The deletion action on the data.
+ */
+void cht_destroy_act(smb_cht *table, DATA_ACTION deleter);
+/**
+   @brief Free resources used by the hash table, but not the pointer itself.
+   @param table The table to destroy.
+ */
+void cht_destroy(smb_cht *table);
+/**
+   @brief Free the hash table and its resources, performing an action on each
+   value.
+   @param table The table to free.
+   @param deleter The action to perform on each value.
+ */
+void cht_delete_act(smb_cht *table, DATA_ACTION deleter);
+/**
+   @brief Free the hash table and its resources.
+   @param table The table to free.
+ */
+void cht_delete(smb_cht *table);
+
+/**
+   @brief Insert data into the hash table, overwriting any existing value.
+   @param table A pointer to the hash table.
+   @param key The key to insert.
+   @param value The value to insert at the key.
+ */
+void cht_insert(smb_cht *table, DATA key, DATA value);
+/**
+   @brief Remove the key, value pair stored in the hash table.
+
+   The deleter is called while the key's segment is locked.
+   @param table A pointer to the hash table.
+   @param key The key to delete.
+   @param deleter The action to perform on the value before removing it.
+   @param[out] status Status variable.
+   @exception SMB_NOT_FOUND_ERROR If an item with the given key is not found.
+ */
+void cht_remove_act(smb_cht *table, DATA key, DATA_ACTION deleter,
+                    smb_status *status);
+/**
+   @brief Remove the key, value pair stored in the hash table.
+   @param table A pointer to the hash table.
+   @param key The key to delete.
+   @param[out] status Status variable.
+   @exception SMB_NOT_FOUND_ERROR If an item with the given key is not found.
+ */
+void cht_remove(smb_cht *table, DATA key, smb_status *status);
+/**
+   @brief Return the value associated with the key provided.
+   @param table A pointer to the hash table.
+   @param key The key whose value to retrieve.
+   @param[out] status Status variable.
+   @returns The value associated the key.
+   @exception SMB_NOT_FOUND_ERROR If an item with the given key is not found.
+ */
+DATA cht_get(smb_cht *table, DATA key, smb_status *status);
+/**
+   @brief Return true when a key is contained in the table.
+   @param table A pointer to the hash table.
+   @param key The key to search for.
+   @returns Whether the key is present.
+ */
+bool cht_contains(smb_cht *table, DATA key);
+/**
+   @brief Return the number of items in the table.
+
+   Each segment is counted under its lock, but the segments are not locked all
+   at once, so with concurrent writers this is only a snapshot.
+   @param table A pointer to the hash table.
+   @returns The number of items.
+ */
+unsigned int cht_length(smb_cht *table);
+
+#endif // LIBSTEPHEN_CHT_H
@@ -16,20 +16,64 @@
 #ifndef LIBSTEPHEN_HT_H
 #define LIBSTEPHEN_HT_H
 
+#include <stdint.h>
+
 #include "base.h"  /* DATA, DATA_ACTION */
 #include "list.h"  /* DATA, DATA_ACTION */
 
 /**
-   @brief An initial amount of rows in the hash table.  Something just off of a
-   power of 2.
+   @brief An initial amount of rows in the hash table.  This must be a power of
+   two, since the table is indexed by masking the hash rather than taking it
+   modulo the size.
+ */
+#define HASH_TABLE_INITIAL_SIZE 32
+
+/**
+   @brief The largest size a hash table will grow to: the largest power of two
+   that fits in an unsigned int.
  */
-#define HASH_TABLE_INITIAL_SIZE 31
+#define HASH_TABLE_MAX_SIZE (1u << (sizeof(unsigned int) * 8 - 1))
 
 /**
    @brief The maximum load factor that can be allowed in the hash table.
  */
 #define HASH_TABLE_MAX_LOAD_FACTOR 0.5
 
+/**
+   @brief The load factor below which the hash table is shrunk after a removal.
+ */
+#define HASH_TABLE_MIN_LOAD_FACTOR 0.125
+
+/**
+   @brief The fraction of slots which may be graves before the hash table is
+   rehashed in place after a removal.
+
+   Together with the maximum load factor, this guarantees that there are always
+   empty slots to terminate a probe.
+ */
+#define HASH_TABLE_MAX_GRAVE_FACTOR 0.25
+
+/**
+   @brief The number of old buckets migrated by each insert or remove while an
+   incremental resize is in progress.
+
+   This must be at least 2, so that the old table has been drained by the time
+   the new one needs to grow again.
+ */
+#define HASH_TABLE_REHASH_STEP 4
+
+/**
+   @brief The number of keys hashed (and prefetched) ahead of insertion by the
+   bulk insert functions.
+ */
+#define HASH_TABLE_BATCH_SIZE 16
+
+/**
+   @brief The number of probe lengths counted separately in the histogram of a
+   smb_ht_stats.  Longer probes are all counted in the last bucket.
+ */
+#define HT_STATS_HISTOGRAM_SIZE 16
+
 /**
    @brief A hash function declaration.
 
@@ -67,6 +111,13 @@ typedef struct smb_ht_bckt
    */
   DATA value;
 
+  /**
+     @brief The full hash of the key, cached so that most mismatches can be
+     rejected without calling the comparator, and so that resizing does not
+     need to rehash any keys.
+   */
+  unsigned int hash;
+
   /**
      @brief Marker for whether or not the table is full or empty.
    */
@@ -85,7 +136,8 @@ typedef struct smb_ht
   unsigned int length;
 
   /**
-     @brief The number of slots allocated in the hash table.
+     @brief The number of slots allocated in the hash table.  Always a power of
+     two.
    */
   unsigned int allocated;
 
@@ -104,8 +156,109 @@ typedef struct smb_ht
    */
   struct smb_ht_bckt *table;
 
+  /**
+     @brief Whether resizes are spread across later operations.
+   */
+  bool incremental;
+
+  /**
+     @brief The table being drained by an incremental resize, or NULL.
+   */
+  struct smb_ht_bckt *old_table;
+
+  /**
+     @brief The number of slots in old_table.
+   */
+  unsigned int old_allocated;
+
+  /**
+     @brief The next slot of old_table to migrate.
+   */
+  unsigned int rehash_index;
+
+  /**
+     @brief The number of graves in the table.
+   */
+  unsigned int graves;
+
+  /**
+     @brief The number of times the table has been rehashed in place to clear
+     out graves.
+   */
+  unsigned int compactions;
+
+  /**
+     @brief The number of times the table has shrunk.
+   */
+  unsigned int shrinks;
+
+  /**
+     @brief Random seed mixed into every hash (see ht_seed_hash()).
+   */
+  unsigned int seed;
+
 } smb_ht;
 
+/**
+   @brief Memory and load statistics of a hash table (smb_ht or smb_hta).
+
+   The fields down to load_factor are read from counters the table maintains,
+   so they are cheap to get (except graves, which smb_hta only counts during a
+   scan).  The probe statistics require a scan of the table.
+   The probe length of an entry is the number of slots (groups, for a Swiss mode
+   smb_hta) a successful lookup of it examines, so it is at least one.
+ */
+typedef struct smb_ht_stats
+{
+  /**
+     @brief The number of items in the table.
+   */
+  unsigned int length;
+
+  /**
+     @brief The number of slots allocated.
+   */
+  unsigned int allocated;
+
+  /**
+     @brief The number of slots in the old table of an incremental resize (or
+     zero).
+   */
+  unsigned int old_allocated;
+
+  /**
+     @brief The number of graves in the table (not counting the old table).
+   */
+  unsigned int graves;
+
+  /**
+     @brief Total bytes used by the table, including the struct itself.
+   */
+  size_t bytes;
+
+  /**
+     @brief length / allocated.
+   */
+  double load_factor;
+
+  /**
+     @brief Mean probe length over every entry (zero without a scan).
+   */
+  double avg_probe;
+
+  /**
+     @brief Longest probe length of any entry (zero without a scan).
+   */
+  unsigned int max_probe;
+
+  /**
+     @brief histogram[i] is the number of entries with probe length i + 1.
+     The last bucket also counts every longer probe.  Zero without a scan.
+   */
+  unsigned int histogram[HT_STATS_HISTOGRAM_SIZE];
+
+} smb_ht_stats;
+
 /**
    @brief Initialize a hash table in memory already allocated.
    @param table A pointer to the table to initialize.
@@ -155,6 +308,22 @@ void ht_delete_act(smb_ht *table, DATA_ACTION deleter);
  */
 void ht_delete(smb_ht *table);
 
+/**
+   @brief Enable or disable incremental resizing.
+
+   Normally, an insert which pushes the table over its maximum load factor
+   rehashes every entry before it returns.  With incremental resizing, that
+   insert only allocates the new table.  Entries are then migrated a few buckets
+   at a time (HASH_TABLE_REHASH_STEP) by each following insert and remove, and
+   lookups search both tables in the meantime.  This trades a little lookup
+   speed during a resize for a flat worst case insertion latency.
+
+   Disabling incremental resizing finishes any resize in progress.
+   @param table The table.
+   @param incremental Whether to resize incrementally.
+ */
+void ht_set_incremental(smb_ht *table, bool incremental);
+
 /**
    @brief Insert data into the hash table.
 
@@ -166,8 +335,36 @@ void ht_delete(smb_ht *table);
    @param value The value to insert at the key.
  */
 void ht_insert(smb_ht *table, DATA key, DATA value);
+/**
+   @brief Grow the hash table so that it can hold n items without resizing.
+
+   This never shrinks the table.  Note that removals may still shrink it later.
+   The table doesn't grow past HASH_TABLE_MAX_SIZE, so a larger n only reserves
+   that much.
+   @param table A pointer to the hash table.
+   @param n The number of items the table should be able to hold.
+ */
+void ht_reserve(smb_ht *table, unsigned int n);
+/**
+   @brief Insert many key, value pairs into the hash table.
+
+   The table is grown once up front (see ht_reserve()), rather than several
+   times along the way.  Keys are hashed in batches of HASH_TABLE_BATCH_SIZE,
+   and their buckets prefetched before any of them are inserted.  Otherwise,
+   this is equivalent to calling ht_insert() on each pair in order.
+   @param table A pointer to the hash table.
+   @param keys Array of n keys.
+   @param values Array of n values, corresponding to the keys.
+   @param n The number of pairs.
+ */
+void ht_insert_many(smb_ht *table, const DATA *keys, const DATA *values,
+                    unsigned int n);
 /**
    @brief Remove the key, value pair stored in the hash table.
+
+   Removal leaves a grave in the table.  If too many graves accumulate, the
+   table is rehashed in place, and if the table becomes sparse enough, it
+   shrinks.  See HASH_TABLE_MAX_GRAVE_FACTOR and HASH_TABLE_MIN_LOAD_FACTOR.
    @param table A pointer to the hash table.
    @param key The key to delete.
    @param deleter The action to perform on the value before removing it.
@@ -210,10 +407,58 @@ bool ht_contains(smb_ht const *table, DATA key);
 smb_iter ht_get_iter(const smb_ht *ht);
 /**
    @brief Return the hash of the data, interpreting it as a string.
+
+   This is ht_string_hash_len() of the string, so it is randomized per process.
    @param data The string to hash, assuming that the value contained is a char*.
    @returns The hash value of the string.
  */
 unsigned int ht_string_hash(DATA data);
+/**
+   @brief Return the hash of a string of known length.
+
+   The string is hashed with ht_hash_bytes(), using a secret seed which is
+   chosen randomly once per process.  So, string hashes are not stable between
+   runs, and sets of colliding strings can't be computed ahead of time.
+   @param str The string to hash.
+   @param len The length of the string.
+   @returns The hash value of the string.
+ */
+unsigned int ht_string_hash_len(const char *str, size_t len);
+/**
+   @brief Return the hash of the data, interpreting it as an integer.
+
+   Unlike using the integer itself as its hash, this spreads sequential or
+   strided integers evenly over the table.
+   @param data The integer to hash (data_llint).
+   @returns The hash value of the integer.
+ */
+unsigned int ht_int_hash(DATA data);
+/**
+   @brief Return a fast, high quality, seeded hash of a block of memory.
+
+   This is wyhash, which consumes eight bytes at a time.
+   @param data The memory to hash.
+   @param len The number of bytes to hash.
+   @param seed The seed.  Different seeds give unrelated hash functions.
+   @returns The hash value.
+ */
+unsigned int ht_hash_bytes(const void *data, size_t len, uint64_t seed);
+/**
+   @brief Combine a hash with a table's seed.
+
+   Hash tables pass the result of their hash function through this before
+   using it.  This scrambles poor hash functions (such as the identity on
+   integers), which would otherwise cluster in a power of two sized table, and
+   makes the placement of keys differ from table to table.
+   @param hash The hash value.
+   @param seed The seed.
+   @returns The seeded hash value.
+ */
+unsigned int ht_seed_hash(unsigned int hash, unsigned int seed);
+/**
+   @brief Return a new random seed for a hash table.
+ */
+unsigned int ht_new_seed(void);
 /**
    @brief Print the entire hash table.
 
@@ -224,9 +469,32 @@ unsigned int ht_string_hash(DATA data);
    @param full_mode Whether to print every row in the hash table.
  */
 void ht_print(smb_ht const *table, int full_mode);
+/**
+   @brief Get memory and load statistics for a hash table.
+
+   Without a scan, only the counters are filled in, which is constant time.
+   With a scan, every slot is visited to compute the probe statistics, which
+   takes time proportional to the capacity of the table.
+   @param table The table.
+   @param[out] stats Where to store the statistics.
+   @param scan Whether to scan the table for probe statistics.
+ */
+void ht_stats(smb_ht const *table, smb_ht_stats *stats, bool scan);
 
 /**
-   The next hash table size.  Not really public, but shared for hta.
+   The next hash table size (the next power of two, but no more than
+   HASH_TABLE_MAX_SIZE).  Not really public, but shared for hta.
+ */
+unsigned int ht_next_size(unsigned int current);
+/**
+   The probe length of the entry at index, for a triangular probe of a power of
+   two sized table.  Not really public, but shared for hta.
+ */
+unsigned int ht_probe_length(unsigned int hash, unsigned int index,
+                             unsigned int allocated);
+/**
+   Count an entry's probe length in stats.  While scanning, avg_probe holds the
+   sum of the probe lengths.  Not really public, but shared for hta.
  */
-int ht_next_size(int current);
+void ht_stats_record(smb_ht_stats *stats, unsigned int probe);
 #endif // LIBSTEPHEN_HT_H
@@ -17,11 +17,95 @@
 #ifndef LIBSTEPHEN_HTA_H
 #define LIBSTEPHEN_HTA_H
 
+#include <stdint.h>
+
 #include "base.h"
+#include "ht.h"  /* smb_ht_stats */
 
 #define HTA_KEY_OFFSET 1
 
-#define HTA_MARK(t, i) ((int8_t*)t->table)[i]
+/**
+   @brief The largest alignment given to keys and values in an aligned table.
+ */
+#define HTA_MAX_ALIGN 16
+
+/**
+   @brief Number of control bytes examined at once by a Swiss mode probe.
+ */
+#define HTA_GROUP_SIZE 16
+
+/**
+   @brief Control byte of an empty Swiss mode slot.
+ */
+#define HTA_CTRL_EMPTY ((uint8_t)0x80)
+
+/**
+   @brief Control byte of a deleted Swiss mode slot (a grave stone).
+ */
+#define HTA_CTRL_GRAVE ((uint8_t)0xFE)
+
+/**
+   @brief The maximum load factor allowed in Swiss mode.
+
+   Since a probe rejects sixteen slots at a time, long probe sequences are cheap,
+   and the table can be allowed to get much fuller than in quadratic mode.
+ */
+#define HTA_SWISS_MAX_LOAD_FACTOR 0.875
+
+/**
+   @brief The maximum load factor allowed in Robin Hood mode.
+
+   Robin Hood insertion keeps the variance of probe lengths low, so even at this
+   load, probes are short runs of adjacent slots.
+ */
+#define HTA_ROBIN_HOOD_MAX_LOAD_FACTOR 0.9
+
+/**
+   @brief Mark of a Robin Hood mode slot whose probe distance is too large to
+   store, and must be recomputed from the key's hash.
+ */
+#define HTA_RH_DIST_SATURATED ((uint8_t)0xFF)
+
+/**
+   @brief First bytes of a hash table image file.
+ */
+#define HTA_IMAGE_MAGIC "SMBHTA\0"
+
+/**
+   @brief Version of the hash table image format written by hta_save().
+ */
+#define HTA_IMAGE_VERSION 1
+
+/**
+   @brief Alignment of the arrays in a hash table image, relative to the start
+   of the file.
+ */
+#define HTA_IMAGE_ALIGN 64
+
+/**
+   @brief Probing engine used by a hash table.
+ */
+typedef enum smb_hta_mode {
+  /**
+     @brief Each slot is a mark byte followed by the key and value, and slots
+     are probed one at a time.
+   */
+  HTA_QUADRATIC=0,
+  /**
+     @brief Control bytes live in an array separate from the keys and values.
+     Each full slot's control byte holds seven bits of its hash, and slots are
+     probed in groups of HTA_GROUP_SIZE (with SSE2, when available).
+   */
+  HTA_SWISS,
+  /**
+     @brief Slots are laid out as in quadratic mode, but probed linearly, and
+     the mark byte holds one plus the slot's distance from its home slot (zero
+     when empty).  Insertion moves entries that are closer to home out of the
+     way of entries that are further from home, and removal shifts the
+     following entries back, so there are no graves.
+   */
+  HTA_ROBIN_HOOD
+} smb_hta_mode;
 
 /**
    @brief A hash function declaration.
@@ -88,18 +172,182 @@ typedef struct smb_hta
    */
   void *table;
 
+  /**
+     @brief The probing engine for this table.
+   */
+  smb_hta_mode mode;
+
+  /**
+     @brief Control bytes, one per slot, for Swiss mode and aligned tables.
+     NULL for packed tables, which keep each mark in its slot.
+   */
+  uint8_t *ctrl;
+
+  /**
+     @brief Whether resizes are spread across later operations.
+   */
+  bool incremental;
+
+  /**
+     @brief The table being drained by an incremental resize, or NULL.
+   */
+  void *old_table;
+
+  /**
+     @brief Control bytes of old_table, for Swiss mode and aligned tables.
+   */
+  uint8_t *old_ctrl;
+
+  /**
+     @brief The number of slots in old_table.
+   */
+  unsigned int old_allocated;
+
+  /**
+     @brief The next slot of old_table to migrate.
+   */
+  unsigned int rehash_index;
+
+  /**
+     @brief Random seed mixed into every hash (see ht_seed_hash()).
+   */
+  unsigned int seed;
+
+  /**
+     @brief Whether slots are padded so keys and values are aligned (see
+     hta_set_aligned()).
+   */
+  bool aligned;
+
+  /**
+     @brief Offset of the key within a slot.
+   */
+  unsigned int key_offset;
+
+  /**
+     @brief Offset of the value within a slot.
+   */
+  unsigned int value_offset;
+
+  /**
+     @brief Size of a slot, including its mark (if inline) and any padding.
+   */
+  unsigned int slot_size;
+
+  /**
+     @brief The memory mapped image file backing a table from hta_map(), or
+     NULL.
+   */
+  void *image;
+
+  /**
+     @brief Size of the memory mapped image.
+   */
+  size_t image_size;
+
 } smb_hta;
 
+/**
+   @brief The header of a hash table image file (see hta_save()).
+
+   The header is followed by the slots, starting at table_offset, and then the
+   control bytes (for Swiss mode and aligned tables) at ctrl_offset.  Both are
+   stored exactly as they are in memory, in native byte order.
+ */
+typedef struct smb_hta_image_header
+{
+  /**
+     @brief HTA_IMAGE_MAGIC.
+   */
+  char magic[8];
+
+  /**
+     @brief HTA_IMAGE_VERSION.
+   */
+  uint32_t version;
+
+  /**
+     @brief 0x01020304, as written by the machine that wrote the image.
+   */
+  uint32_t byte_order;
+
+  /**
+     @brief The table's smb_hta_mode.
+   */
+  uint32_t mode;
+
+  /**
+     @brief Whether the table uses the aligned layout.
+   */
+  uint32_t aligned;
+
+  /**
+     @brief The table's seed.
+   */
+  uint32_t seed;
+
+  /**
+     @brief Size of keys.
+   */
+  uint32_t key_size;
+
+  /**
+     @brief Size of values.
+   */
+  uint32_t value_size;
+
+  /**
+     @brief Size of a slot.
+   */
+  uint32_t slot_size;
+
+  /**
+     @brief Number of slots.
+   */
+  uint32_t allocated;
+
+  /**
+     @brief Number of items.
+   */
+  uint32_t length;
+
+  /**
+     @brief File offset of the slots.
+   */
+  uint64_t table_offset;
+
+  /**
+     @brief File offset of the control bytes, or zero if there are none.
+   */
+  uint64_t ctrl_offset;
+
+} smb_hta_image_header;
+
 /**
    @brief Initialize a hash table in memory already allocated.
    @param table A pointer to the table to initialize.
-   @param hash_func A hash function for the table.
-   @param equal A comparison function for DATA.
+   @param hash_func A hash function for the table, or NULL to hash the bytes of
+   each key with ht_hash_bytes().
+   @param equal A comparison function for keys, or NULL to compare the bytes of
+   each key.  Comparing bytes (or using hta_int_comp() on int keys) takes a
+   fast path which doesn't call through a function pointer.
    @param key_size Size of keys.
    @param value_size Size of values.
  */
 void hta_init(smb_hta *table, HTA_HASH hash_func, HTA_COMP equal,
               unsigned int key_size, unsigned int value_size);
+/**
+   @brief Initialize a hash table which uses a particular probing engine.
+   @param table A pointer to the table to initialize.
+   @param hash_func A hash function for the table.
+   @param equal A comparison function for DATA.
+   @param key_size Size of keys.
+   @param value_size Size of values.
+   @param mode The probing engine to use.
+ */
+void hta_init_mode(smb_hta *table, HTA_HASH hash_func, HTA_COMP equal,
+                   unsigned int key_size, unsigned int value_size,
+                   smb_hta_mode mode);
 /**
    @brief Allocate and initialize a hash table.
    @param hash_func A function that takes one DATA and returns a hash value
@@ -111,6 +359,30 @@ void hta_init(smb_hta *table, HTA_HASH hash_func, HTA_COMP equal,
  */
 smb_hta *hta_create(HTA_HASH hash_func, HTA_COMP equal,
                     unsigned int key_size, unsigned int value_size);
+/**
+   @brief Allocate and initialize a hash table which uses a particular probing
+   engine.
+   @param hash_func A function that takes one DATA and returns a hash value
+   generated from it.  It should be a good hash function.  In Swiss mode, both
+   the low and the high bits of the hash are used.
+   @param equal A comparison function for DATA.
+   @param key_size Size of keys.
+   @param value_size Size of values.
+   @param mode The probing engine to use.
+   @returns A pointer to the new hash table.
+ */
+smb_hta *hta_create_mode(HTA_HASH hash_func, HTA_COMP equal,
+                         unsigned int key_size, unsigned int value_size,
+                         smb_hta_mode mode);
+/**
+   @brief Initialize a hash table as a copy of another one.
+
+   The copy has its own storage, but the same hash function, comparator, mode
+   and seed as the original.
+   @param dest A pointer to the table to initialize.
+   @param src The table to copy.
+ */
+void hta_copy(smb_hta *dest, const smb_hta *src);
 /**
    @brief Free any resources used by the hash table, but doesn't free the
    pointer.  Doesn't perform any actions on the data as it is deleted.
@@ -127,17 +399,66 @@ void hta_destroy(smb_hta *table);
  */
 void hta_delete(smb_hta *table);
 
+/**
+   @brief Enable or disable incremental resizing.
+
+   This works just like ht_set_incremental().  Since the hash of each entry is
+   not stored, migrated entries are rehashed as they are moved.
+   @param table The table.
+   @param incremental Whether to resize incrementally.
+ */
+void hta_set_incremental(smb_hta *table, bool incremental);
+/**
+   @brief Choose between the packed and aligned slot layouts.
+
+   By default, slots are packed: a mark byte (except in Swiss mode) is
+   immediately followed by the key and then the value, so keys and values are
+   generally misaligned.  In the aligned layout, marks are kept in a separate
+   array, and keys and values are each aligned to their natural alignment (the
+   largest power of two dividing their size, up to HTA_MAX_ALIGN), with slots
+   padded as needed.  So, a table of 8 byte keys and values uses 16 byte
+   slots, plus one byte per slot for marks.
+
+   Changing the layout rebuilds the table (finishing any incremental resize),
+   so it can't be done to a table from hta_map().
+   @param table The table.
+   @param aligned Whether to use the aligned layout.
+ */
+void hta_set_aligned(smb_hta *table, bool aligned);
+
 /**
    @brief Insert data into the hash table.
 
    Expands the hash table if the load factor is below a threshold.  If the key
    already exists in the table, then the function will overwrite it with the new
-   data provided.
+   data provided.  The table must not be from hta_map().
    @param table A pointer to the hash table.
    @param key The key to insert.
    @param value The value to insert at the key.
  */
 void hta_insert(smb_hta *table, void *key, void *value);
+/**
+   @brief Grow the hash table so that it can hold n items without resizing.
+
+   The table doesn't grow past HASH_TABLE_MAX_SIZE, so a larger n only reserves
+   that much.  The table must not be from hta_map().
+   @param table A pointer to the hash table.
+   @param n The number of items the table should be able to hold.
+ */
+void hta_reserve(smb_hta *table, unsigned int n);
+/**
+   @brief Insert many key, value pairs into the hash table.
+
+   This works like ht_insert_many(): the table is grown once, and keys are
+   hashed and prefetched in batches before being inserted.  The table must not
+   be from hta_map().
+   @param table A pointer to the hash table.
+   @param keys Array of n keys, each key_size bytes, packed together.
+   @param values Array of n values, each value_size bytes, packed together.
+   @param n The number of pairs.
+ */
+void hta_insert_many(smb_hta *table, const void *keys, const void *values,
+                     unsigned int n);
 /**
    @brief Remove the key, value pair stored in the hash table.
 
@@ -146,6 +467,7 @@ void hta_insert(smb_hta *table, void *key, void *value);
    @param key The key to delete.
    @param[out] status Status variable.
    @exception SMB_NOT_FOUND_ERROR If an item with the given key is not found.
+   @exception SMB_READ_ONLY_ERROR If the table is from hta_map().
  */
 void hta_remove(smb_hta *table, void *key, smb_status *status);
 /**
@@ -170,15 +492,65 @@ bool hta_contains(smb_hta const *table, void *key);
    @returns The hash value of the string.
  */
 unsigned int hta_string_hash(void *data);
+/**
+   @brief Return the hash of the data, interpreting it as an int.
+   @param data Pointer to the int to hash.
+   @returns The hash value of the int (see ht_int_hash()).
+ */
+unsigned int hta_int_hash(void *data);
 int hta_string_comp(void *left, void *right);
 int hta_int_comp(void *left, void *right);
+/**
+   @brief Write a hash table to an image file, which hta_map() can open.
+
+   Keys and values are written byte for byte, so they must not contain
+   pointers.  An incremental resize in progress is finished in the image (but
+   not in the table).
+   @param table The table to write.
+   @param path The file to write (it is replaced if it exists).
+   @param[out] status Status variable.
+   @exception SMB_IO_ERROR If the file can't be written.
+ */
+void hta_save(smb_hta const *table, const char *path, smb_status *status);
+/**
+   @brief Open a hash table image file, memory mapping it read-only.
+
+   The table is ready for lookups immediately: nothing is read or rehashed until
+   it is accessed, and the page cache is shared between every process mapping
+   the same file.  It can't be modified: hta_remove() fails with
+   SMB_READ_ONLY_ERROR, and the other functions that modify a table assert that
+   it isn't mapped (but hta_copy() gives a modifiable copy).  Free it with hta_delete() as usual, which unmaps the file.
+   @param path The file to open.
+   @param hash_func The hash function the table was created with.
+   @param equal The comparison function the table was created with.
+   @param[out] status Status variable.
+   @returns The mapped table, or NULL on error.
+   @exception SMB_IO_ERROR If the file can't be opened or mapped.
+   @exception SMB_FORMAT_ERROR If the file isn't a valid image for this
+   version and machine.
+ */
+smb_hta *hta_map(const char *path, HTA_HASH hash_func, HTA_COMP equal,
+                 smb_status *status);
+/**
+   @brief Get memory and load statistics for a hash table.
+
+   See ht_stats().  A scan calls the hash function on every key in quadratic
+   mode, since hashes aren't stored in the table.
+   @param table The table.
+   @param[out] stats Where to store the statistics.
+   @param scan Whether to scan the table for probe statistics and graves.
+ */
+void hta_stats(smb_hta const *table, smb_ht_stats *stats, bool scan);
 /**
    @brief Print the entire hash table.
 
    This function is useful for diagnostics.  It can show every row in the table
    (with full_mode) so you can see how well entries are distributed in the
    table.  Or, it can be compact and show just the rows with data.
+   @param f File to print to.
    @param table The table to print.
+   @param key Printer for keys.
+   @param value Printer for values.
    @param full_mode Whether to print every row in the hash table.
  */
 void hta_print(FILE *f, smb_hta const *table, HTA_PRINT key, HTA_PRINT value,
@@ -0,0 +1,276 @@
+/***************************************************************************//**
+
+  @file         libstephen/htt.h
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Type specialized hash tables, generated by macros.
+
+  @copyright    Copyright (c) 2013-2016, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+  smb_ht and smb_hta call their hash and equality functions through pointers on
+  every probe, and store keys and values generically.  The macros in this file
+  generate a hash table for one key type and one value type instead, with the
+  hash and equality functions inlined into the table's code.  For example:
+
+      SMB_HTT_INIT(iimap, long long, long long, smb_htt_int_hash,
+                   smb_htt_int_equal)
+
+  declares the type smb_htt_iimap, along with static inline functions:
+
+  - htt_iimap_init(smb_htt_iimap *t), htt_iimap_create()
+  - htt_iimap_destroy(smb_htt_iimap *t), htt_iimap_delete(smb_htt_iimap *t)
+  - htt_iimap_reserve(smb_htt_iimap *t, unsigned int n)
+  - htt_iimap_insert(smb_htt_iimap *t, long long key, long long value)
+  - htt_iimap_remove(smb_htt_iimap *t, long long key, smb_status *status)
+  - htt_iimap_get(const smb_htt_iimap *t, long long key, smb_status *status)
+  - htt_iimap_contains(const smb_htt_iimap *t, long long key)
+
+  These behave like their smb_ht counterparts.  To visit every entry, loop over
+  the slots from 0 to allocated, and use the ones where SMB_HTT_FULL() is true.
+
+  The hash argument may be a function or a macro taking a key and returning an
+  unsigned int.  The equal argument takes two keys and returns nonzero when
+  they are equal (unlike the comparators used elsewhere).  Since the table
+  specializes on them, keys are stored in their own array, values in another,
+  and marks in a third, so probes only touch the marks and keys.
+
+  A SMB_HTT_INIT() expands to function definitions, so it should go in a single
+  source file, or in a header which is only included once per source file.
+
+*******************************************************************************/
+
+#ifndef LIBSTEPHEN_HTT_H
+#define LIBSTEPHEN_HTT_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "base.h"
+#include "ht.h"
+
+/**
+   @brief Return true when slot i of a generated table contains an entry.
+ */
+#define SMB_HTT_FULL(t, i) ((t)->marks[i] == HT_FULL)
+
+/**
+   @brief Combine a hash with a table's seed.  This is ht_seed_hash(), inlined.
+ */
+static inline unsigned int smb_htt_seed_hash(unsigned int hash,
+                                             unsigned int seed)
+{
+  uint64_t x = ((uint64_t) seed << 32) | hash;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdull;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ull;
+  x ^= x >> 33;
+  return (unsigned int) x;
+}
+
+/**
+   @brief Hash an integer key.  The seed mixing spreads integers out, so the
+   integer itself is a good enough hash.
+ */
+#define smb_htt_int_hash(key) \
+  ((unsigned int) ((key) ^ ((uint64_t) (key) >> 32)))
+
+/**
+   @brief Compare integer (or pointer) keys.
+ */
+#define smb_htt_int_equal(a, b) ((a) == (b))
+
+/**
+   @brief Hash a string key (a char*).  This is ht_string_hash_len().
+ */
+#define smb_htt_str_hash(key) ht_string_hash_len((key), strlen(key))
+
+/**
+   @brief Compare string keys.
+ */
+#define smb_htt_str_equal(a, b) (strcmp((a), (b)) == 0)
+
+/**
+   @brief Generate a hash table type and its functions.
+   @param name Name of the table: the type is smb_htt_name, and the functions
+   are htt_name_*.
+   @param key_t The key type.
+   @param value_t The value type.
+   @param hash Hash function (or macro) for keys.
+   @param equal Equality function (or macro) for keys.
+ */
+#define SMB_HTT_INIT(name, key_t, value_t, hash, equal)                        \
+  typedef struct smb_htt_##name {                                              \
+    unsigned int length;                                                       \
+    unsigned int allocated;                                                    \
+    unsigned int graves;                                                       \
+    unsigned int seed;                                                         \
+    uint8_t *marks;                                                            \
+    key_t *keys;                                                               \
+    value_t *values;                                                           \
+  } smb_htt_##name;                                                            \
+                                                                               \
+  static inline void htt_##name##_alloc(smb_htt_##name *t,                     \
+                                        unsigned int allocated)                \
+  {                                                                            \
+    t->allocated = allocated;                                                  \
+    t->graves = 0;                                                             \
+    t->marks = smb_new(uint8_t, allocated);                                    \
+    memset(t->marks, HT_EMPTY, allocated);                                     \
+    t->keys = smb_new(key_t, allocated);                                       \
+    t->values = smb_new(value_t, allocated);                                   \
+  }                                                                            \
+                                                                               \
+  static inline void htt_##name##_init(smb_htt_##name *t)                      \
+  {                                                                            \
+    t->length = 0;                                                             \
+    t->seed = ht_new_seed();                                                   \
+    htt_##name##_alloc(t, HASH_TABLE_INITIAL_SIZE);                            \
+  }                                                                            \
+                                                                               \
+  static inline smb_htt_##name *htt_##name##_create(void)                      \
+  {                                                                            \
+    smb_htt_##name *t = smb_new(smb_htt_##name, 1);                            \
+    htt_##name##_init(t);                                                      \
+    return t;                                                                  \
+  }                                                                            \
+                                                                               \
+  static inline void htt_##name##_destroy(smb_htt_##name *t)                   \
+  {                                                                            \
+    smb_free(t->marks);                                                        \
+    smb_free(t->keys);                                                         \
+    smb_free(t->values);                                                       \
+  }                                                                            \
+                                                                               \
+  static inline void htt_##name##_delete(smb_htt_##name *t)                    \
+  {                                                                            \
+    if (!t) {                                                                  \
+      return;                                                                  \
+    }                                                                          \
+    htt_##name##_destroy(t);                                                   \
+    smb_free(t);                                                               \
+  }                                                                            \
+                                                                               \
+  /* Return the slot containing key, or t->allocated if there is none. */     \
+  static inline unsigned int htt_##name##_find(const smb_htt_##name *t,        \
+                                               key_t key)                      \
+  {                                                                            \
+    unsigned int mask = t->allocated - 1;                                      \
+    unsigned int index = smb_htt_seed_hash(hash(key), t->seed) & mask;         \
+    unsigned int j = 1;                                                        \
+    while (t->marks[index] != HT_EMPTY) {                                      \
+      if (t->marks[index] == HT_FULL && equal(t->keys[index], key)) {          \
+        return index;                                                          \
+      }                                                                        \
+      index = (index + j) & mask; /* triangular probing, as in smb_ht */       \
+      j++;                                                                     \
+    }                                                                          \
+    return t->allocated;                                                       \
+  }                                                                            \
+                                                                               \
+  /* Place a key known not to be present, without checking the load. */      \
+  static inline void htt_##name##_place(smb_htt_##name *t, key_t key,          \
+                                        value_t value)                         \
+  {                                                                            \
+    unsigned int mask = t->allocated - 1;                                      \
+    unsigned int index = smb_htt_seed_hash(hash(key), t->seed) & mask;         \
+    unsigned int j = 1;                                                        \
+    while (t->marks[index] == HT_FULL) {                                       \
+      index = (index + j) & mask;                                              \
+      j++;                                                                     \
+    }                                                                          \
+    if (t->marks[index] == HT_GRAVE) {                                         \
+      t->graves--;                                                             \
+    }                                                                          \
+    t->marks[index] = HT_FULL;                                                 \
+    t->keys[index] = key;                                                      \
+    t->values[index] = value;                                                  \
+  }                                                                            \
+                                                                               \
+  /* Rebuild the table with new_size slots, which drops every grave. */       \
+  static inline void htt_##name##_rehash(smb_htt_##name *t,                    \
+                                         unsigned int new_size)                \
+  {                                                                            \
+    smb_htt_##name old = *t;                                                   \
+    unsigned int i;                                                            \
+    htt_##name##_alloc(t, new_size);                                           \
+    for (i = 0; i < old.allocated; i++) {                                      \
+      if (old.marks[i] == HT_FULL) {                                           \
+        htt_##name##_place(t, old.keys[i], old.values[i]);                     \
+      }                                                                        \
+    }                                                                          \
+    htt_##name##_destroy(&old);                                                \
+  }                                                                            \
+                                                                               \
+  static inline void htt_##name##_reserve(smb_htt_##name *t, unsigned int n)   \
+  {                                                                            \
+    unsigned int size = t->allocated;                                          \
+    while (n > size * HASH_TABLE_MAX_LOAD_FACTOR &&                            \
+           size < HASH_TABLE_MAX_SIZE) {                                       \
+      size = ht_next_size(size);                                               \
+    }                                                                          \
+    if (size > t->allocated) {                                                 \
+      htt_##name##_rehash(t, size);                                            \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  static inline void htt_##name##_insert(smb_htt_##name *t, key_t key,         \
+                                         value_t value)                        \
+  {                                                                            \
+    unsigned int size, index = htt_##name##_find(t, key);                      \
+    if (index < t->allocated) {                                                \
+      t->values[index] = value;                                                \
+      return;                                                                  \
+    }                                                                          \
+    /* Graves count against the load, so probes always find empty slots. */   \
+    if (t->length + t->graves + 1 > t->allocated * HASH_TABLE_MAX_LOAD_FACTOR) \
+    {                                                                          \
+      size = t->allocated;                                                     \
+      while (t->length + 1 > size * HASH_TABLE_MAX_LOAD_FACTOR &&              \
+             size < HASH_TABLE_MAX_SIZE) {                                     \
+        size = ht_next_size(size);                                             \
+      }                                                                        \
+      htt_##name##_rehash(t, size);                                            \
+    }                                                                          \
+    htt_##name##_place(t, key, value);                                         \
+    t->length++;                                                               \
+  }                                                                            \
+                                                                               \
+  static inline void htt_##name##_remove(smb_htt_##name *t, key_t key,         \
+                                         smb_status *status)                   \
+  {                                                                            \
+    unsigned int index = htt_##name##_find(t, key);                            \
+    *status = SMB_SUCCESS;                                                     \
+    if (index >= t->allocated) {                                               \
+      *status = SMB_NOT_FOUND_ERROR;                                           \
+      return;                                                                  \
+    }                                                                          \
+    t->marks[index] = HT_GRAVE;                                                \
+    t->graves++;                                                               \
+    t->length--;                                                               \
+  }                                                                            \
+                                                                               \
+  static inline value_t htt_##name##_get(const smb_htt_##name *t, key_t key,   \
+                                         smb_status *status)                   \
+  {                                                                            \
+    unsigned int index = htt_##name##_find(t, key);                            \
+    value_t none;                                                              \
+    *status = SMB_SUCCESS;                                                     \
+    if (index >= t->allocated) {                                               \
+      *status = SMB_NOT_FOUND_ERROR;                                           \
+      memset(&none, 0, sizeof(value_t));                                       \
+      return none;                                                             \
+    }                                                                          \
+    return t->values[index];                                                   \
+  }                                                                            \
+                                                                               \
+  static inline bool htt_##name##_contains(const smb_htt_##name *t, key_t key) \
+  {                                                                            \
+    return htt_##name##_find(t, key) < t->allocated;                           \
+  }
+
+#endif // LIBSTEPHEN_HTT_H
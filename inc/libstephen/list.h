@@ -21,113 +21,414 @@
 #ifndef LIBSTEPHEN_LIST_H
 #define LIBSTEPHEN_LIST_H
 
+#include <assert.h>
 #include <stdbool.h>
 
 #include "base.h"  /* DATA */
 
+/**
+   @brief The list implementations that can back a smb_list.  They start from
+   one, so a zeroed smb_list has no valid kind.
+ */
+typedef enum smb_list_kind
+{
+  SMB_LIST_AL = 1,  /**< An array list, smb_al. */
+  SMB_LIST_LL,      /**< A linked list, smb_ll. */
+  SMB_LIST_UL       /**< An unrolled linked list, smb_ul. */
+} smb_list_kind;
+
 /**
    @brief A generic list data structure.
 
-   Can represent an array list or a linked list.  Uses function pointers to hide
-   the implementation.  Has heavyweight memory requirements (many pointers).
+   Can represent an array list, a linked list, or an unrolled list.  It is just
+   a pointer to the list, tagged with which kind of list it is, so it is two
+   words and can be passed around by value.  The list_*() functions below
+   switch on the tag and call the implementation's function directly, and they
+   are inline, so a call costs about as much as calling that function itself.
+   They assert that the tag is one of the smb_list_kind values, so a zeroed or
+   corrupted smb_list fails instead of being used as the wrong kind of list.
    Function calls must be made like this:
 
-       list->functionName(list, <params...>)
+       list_functionName(&list, <params...>)
  */
 typedef struct smb_list
 {
   /**
-     @brief A pointer to implementation-specific data.
-
-     This data is used by the rest of the functions in the struct to perform all
-     required actions.
+     @brief Which implementation data points to.
    */
-  void *data;
+  smb_list_kind kind;
 
   /**
-     @see ll_append @see al_append
+     @brief A pointer to the implementation's list (a smb_al, smb_ll or
+     smb_ul).
    */
-  void (*append)(struct smb_list *l, DATA newData);
+  void *data;
 
-  /**
-     @see ll_prepend @see al_prepend
-   */
-  void (*prepend)(struct smb_list *l, DATA newData);
+} smb_list;
 
-  /**
-     @see ll_get @see al_get
-   */
-  DATA (*get)(const struct smb_list *l, int index, smb_status *status);
+/*
+  The implementation functions the list_*() functions call.  These are declared
+  in al.h, ll.h and ul.h too, but those headers need smb_list, so they can't be
+  included here.
+ */
+struct smb_al;
+struct smb_ll;
+struct smb_ul;
+
+void al_append(struct smb_al *list, DATA newData);
+void al_prepend(struct smb_al *list, DATA newData);
+DATA al_get(const struct smb_al *list, int index, smb_status *status);
+void al_set(struct smb_al *list, int index, DATA newData, smb_status *status);
+void al_remove(struct smb_al *list, int index, smb_status *status);
+void al_insert(struct smb_al *list, int index, DATA newData);
+void al_delete(struct smb_al *list);
+int al_length(const struct smb_al *list);
+void al_push_back(struct smb_al *list, DATA newData);
+DATA al_pop_back(struct smb_al *list, smb_status *status);
+DATA al_peek_back(struct smb_al *list, smb_status *status);
+void al_push_front(struct smb_al *list, DATA data);
+DATA al_pop_front(struct smb_al *list, smb_status *status);
+DATA al_peek_front(struct smb_al *list, smb_status *status);
+int al_index_of(const struct smb_al *list, DATA d, DATA_COMPARE comp);
+
+void ll_append(struct smb_ll *list, DATA new_data);
+void ll_prepend(struct smb_ll *list, DATA new_data);
+DATA ll_get(struct smb_ll *list, int index, smb_status *status);
+void ll_set(struct smb_ll *list, int index, DATA new_data, smb_status *status);
+void ll_remove(struct smb_ll *list, int index, smb_status *status);
+void ll_insert(struct smb_ll *list, int index, DATA new_data);
+void ll_delete(struct smb_ll *list);
+int ll_length(const struct smb_ll *list);
+void ll_push_back(struct smb_ll *list, DATA new_data);
+DATA ll_pop_back(struct smb_ll *list, smb_status *status);
+DATA ll_peek_back(struct smb_ll *list, smb_status *status);
+void ll_push_front(struct smb_ll *list, DATA new_data);
+DATA ll_pop_front(struct smb_ll *list, smb_status *status);
+DATA ll_peek_front(struct smb_ll *list, smb_status *status);
+int ll_index_of(const struct smb_ll *list, DATA d, DATA_COMPARE comp);
+
+void ul_append(struct smb_ul *list, DATA newData);
+void ul_prepend(struct smb_ul *list, DATA newData);
+DATA ul_get(const struct smb_ul *list, int index, smb_status *status);
+void ul_set(struct smb_ul *list, int index, DATA newData, smb_status *status);
+void ul_remove(struct smb_ul *list, int index, smb_status *status);
+void ul_insert(struct smb_ul *list, int index, DATA newData);
+void ul_delete(struct smb_ul *list);
+int ul_length(const struct smb_ul *list);
+void ul_push_back(struct smb_ul *list, DATA newData);
+DATA ul_pop_back(struct smb_ul *list, smb_status *status);
+DATA ul_peek_back(struct smb_ul *list, smb_status *status);
+void ul_push_front(struct smb_ul *list, DATA newData);
+DATA ul_pop_front(struct smb_ul *list, smb_status *status);
+DATA ul_peek_front(struct smb_ul *list, smb_status *status);
+int ul_index_of(const struct smb_ul *list, DATA d, DATA_COMPARE comp);
 
-  /**
-     @see ll_set @see al_set
-   */
-  void (*set)(struct smb_list *l, int index, DATA newData, smb_status *status);
+/**
+   @see ll_append @see al_append @see ul_append
+ */
+static inline void list_append(smb_list *l, DATA newData)
+{
+  switch (l->kind) {
+  case SMB_LIST_AL:
+    al_append(l->data, newData);
+    break;
+  case SMB_LIST_LL:
+    ll_append(l->data, newData);
+    break;
+  case SMB_LIST_UL:
+    ul_append(l->data, newData);
+    break;
+  default:
+    assert(false);
+    break;
+  }
+}
 
-  /**
-     @see ll_remove @see al_remove
-   */
-  void (*remove)(struct smb_list *l, int index, smb_status *status);
+/**
+   @see ll_prepend @see al_prepend @see ul_prepend
+ */
+static inline void list_prepend(smb_list *l, DATA newData)
+{
+  switch (l->kind) {
+  case SMB_LIST_AL:
+    al_prepend(l->data, newData);
+    break;
+  case SMB_LIST_LL:
+    ll_prepend(l->data, newData);
+    break;
+  case SMB_LIST_UL:
+    ul_prepend(l->data, newData);
+    break;
+  default:
+    assert(false);
+    break;
+  }
+}
 
-  /**
-     @see ll_insert @see al_insert
-   */
-  void (*insert)(struct smb_list *l, int index, DATA newData);
+/**
+   @brief Return the item at an index.  On a linked list, this moves the list's
+   finger, so it writes to the list (though not to the smb_list).
+   @see ll_get @see al_get @see ul_get
+ */
+static inline DATA list_get(const smb_list *l, int index, smb_status *status)
+{
+  switch (l->kind) {
+  case SMB_LIST_AL:
+    return al_get(l->data, index, status);
+  case SMB_LIST_LL:
+    return ll_get(l->data, index, status);
+  case SMB_LIST_UL:
+    return ul_get(l->data, index, status);
+  default:
+    assert(false);
+    return PTR(NULL);
+  }
+}
 
-  /**
-     @see ll_delete @see al_delete
-   */
-  void (*delete)(struct smb_list *l);
+/**
+   @see ll_set @see al_set @see ul_set
+ */
+static inline void list_set(smb_list *l, int index, DATA newData,
+                            smb_status *status)
+{
+  switch (l->kind) {
+  case SMB_LIST_AL:
+    al_set(l->data, index, newData, status);
+    break;
+  case SMB_LIST_LL:
+    ll_set(l->data, index, newData, status);
+    break;
+  case SMB_LIST_UL:
+    ul_set(l->data, index, newData, status);
+    break;
+  default:
+    assert(false);
+    break;
+  }
+}
 
-  /**
-     @see ll_length @see al_length
-   */
-  int (*length)(const struct smb_list *l);
+/**
+   @see ll_remove @see al_remove @see ul_remove
+ */
+static inline void list_remove(smb_list *l, int index, smb_status *status)
+{
+  switch (l->kind) {
+  case SMB_LIST_AL:
+    al_remove(l->data, index, status);
+    break;
+  case SMB_LIST_LL:
+    ll_remove(l->data, index, status);
+    break;
+  case SMB_LIST_UL:
+    ul_remove(l->data, index, status);
+    break;
+  default:
+    assert(false);
+    break;
+  }
+}
 
-  /**
-     @see ll_push_back @see al_push_back
-   */
-  void (*push_back)(struct smb_list *l, DATA newData);
+/**
+   @see ll_insert @see al_insert @see ul_insert
+ */
+static inline void list_insert(smb_list *l, int index, DATA newData)
+{
+  switch (l->kind) {
+  case SMB_LIST_AL:
+    al_insert(l->data, index, newData);
+    break;
+  case SMB_LIST_LL:
+    ll_insert(l->data, index, newData);
+    break;
+  case SMB_LIST_UL:
+    ul_insert(l->data, index, newData);
+    break;
+  default:
+    assert(false);
+    break;
+  }
+}
 
-  /**
-     @see ll_pop_back @see al_pop_back
-   */
-  DATA (*pop_back)(struct smb_list *l, smb_status *status);
+/**
+   @brief Delete the list the generic list points to, and clear its pointer.
+   @see ll_delete @see al_delete @see ul_delete
+ */
+static inline void list_delete(smb_list *l)
+{
+  switch (l->kind) {
+  case SMB_LIST_AL:
+    al_delete(l->data);
+    break;
+  case SMB_LIST_LL:
+    ll_delete(l->data);
+    break;
+  case SMB_LIST_UL:
+    ul_delete(l->data);
+    break;
+  default:
+    assert(false);
+    break;
+  }
+  l->data = NULL;
+}
 
-  /**
-     @see ll_peek_back @see al_peek_back
-   */
-  DATA (*peek_back)(struct smb_list *l, smb_status *status);
+/**
+   @see ll_length @see al_length @see ul_length
+ */
+static inline int list_length(const smb_list *l)
+{
+  switch (l->kind) {
+  case SMB_LIST_AL:
+    return al_length(l->data);
+  case SMB_LIST_LL:
+    return ll_length(l->data);
+  case SMB_LIST_UL:
+    return ul_length(l->data);
+  default:
+    assert(false);
+    return 0;
+  }
+}
 
-  /**
-     @see ll_push_front @see al_push_front
-   */
-  void (*push_front)(struct smb_list *l, DATA newData);
+/**
+   @see ll_push_back @see al_push_back @see ul_push_back
+ */
+static inline void list_push_back(smb_list *l, DATA newData)
+{
+  switch (l->kind) {
+  case SMB_LIST_AL:
+    al_push_back(l->data, newData);
+    break;
+  case SMB_LIST_LL:
+    ll_push_back(l->data, newData);
+    break;
+  case SMB_LIST_UL:
+    ul_push_back(l->data, newData);
+    break;
+  default:
+    assert(false);
+    break;
+  }
+}
 
-  /**
-     @see ll_pop_front @see al_pop_front
-   */
-  DATA (*pop_front)(struct smb_list *l, smb_status *status);
+/**
+   @see ll_pop_back @see al_pop_back @see ul_pop_back
+ */
+static inline DATA list_pop_back(smb_list *l, smb_status *status)
+{
+  switch (l->kind) {
+  case SMB_LIST_AL:
+    return al_pop_back(l->data, status);
+  case SMB_LIST_LL:
+    return ll_pop_back(l->data, status);
+  case SMB_LIST_UL:
+    return ul_pop_back(l->data, status);
+  default:
+    assert(false);
+    return PTR(NULL);
+  }
+}
 
-  /**
-     @see ll_pop_front @see al_pop_front
-   */
-  DATA (*peek_front)(struct smb_list *l, smb_status *status);
+/**
+   @see ll_peek_back @see al_peek_back @see ul_peek_back
+ */
+static inline DATA list_peek_back(smb_list *l, smb_status *status)
+{
+  switch (l->kind) {
+  case SMB_LIST_AL:
+    return al_peek_back(l->data, status);
+  case SMB_LIST_LL:
+    return ll_peek_back(l->data, status);
+  case SMB_LIST_UL:
+    return ul_peek_back(l->data, status);
+  default:
+    assert(false);
+    return PTR(NULL);
+  }
+}
 
-  /**
-     @brief Return the index of an item, or -1 if the list doesn't contain it.
+/**
+   @see ll_push_front @see al_push_front @see ul_push_front
+ */
+static inline void list_push_front(smb_list *l, DATA newData)
+{
+  switch (l->kind) {
+  case SMB_LIST_AL:
+    al_push_front(l->data, newData);
+    break;
+  case SMB_LIST_LL:
+    ll_push_front(l->data, newData);
+    break;
+  case SMB_LIST_UL:
+    ul_push_front(l->data, newData);
+    break;
+  default:
+    assert(false);
+    break;
+  }
+}
 
-     Performs a linear search, O(n) in the number of elements of the list.
+/**
+   @see ll_pop_front @see al_pop_front @see ul_pop_front
+ */
+static inline DATA list_pop_front(smb_list *l, smb_status *status)
+{
+  switch (l->kind) {
+  case SMB_LIST_AL:
+    return al_pop_front(l->data, status);
+  case SMB_LIST_LL:
+    return ll_pop_front(l->data, status);
+  case SMB_LIST_UL:
+    return ul_pop_front(l->data, status);
+  default:
+    assert(false);
+    return PTR(NULL);
+  }
+}
 
-     @param l A pointer to the list.
-     @param d The data to search for.
-     @param comp The comparator to use.  If NULL, compares the bits of d.
-     @return The index of the first occurrence of d, else -1.
-     @exception None.
-   */
-  int (*index_of)(const struct smb_list *l, DATA d, DATA_COMPARE comp);
+/**
+   @see ll_peek_front @see al_peek_front @see ul_peek_front
+ */
+static inline DATA list_peek_front(smb_list *l, smb_status *status)
+{
+  switch (l->kind) {
+  case SMB_LIST_AL:
+    return al_peek_front(l->data, status);
+  case SMB_LIST_LL:
+    return ll_peek_front(l->data, status);
+  case SMB_LIST_UL:
+    return ul_peek_front(l->data, status);
+  default:
+    assert(false);
+    return PTR(NULL);
+  }
+}
 
-} smb_list;
+/**
+   @brief Return the index of an item, or -1 if the list doesn't contain it.
+
+   Performs a linear search, O(n) in the number of elements of the list.
+
+   @param l A pointer to the list.
+   @param d The data to search for.
+   @param comp The comparator to use.  If NULL, compares the bits of d.
+   @return The index of the first occurrence of d, else -1.
+   @exception None.
+ */
+static inline int list_index_of(const smb_list *l, DATA d, DATA_COMPARE comp)
+{
+  switch (l->kind) {
+  case SMB_LIST_AL:
+    return al_index_of(l->data, d, comp);
+  case SMB_LIST_LL:
+    return ll_index_of(l->data, d, comp);
+  case SMB_LIST_UL:
+    return ul_index_of(l->data, d, comp);
+  default:
+    assert(false);
+    return -1;
+  }
+}
 
 /**
    @brief A generic iterator type.
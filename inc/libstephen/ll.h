@@ -51,6 +51,40 @@ typedef struct smb_ll_node
 
 } smb_ll_node;
 
+/**
+   @brief A pool of linked list nodes.
+
+   Nodes are allocated from the pool in slabs, and removed nodes go onto a free
+   list to be reused, so adding and removing items doesn't call malloc() or
+   free(), and nodes allocated together sit together in memory.  Every list has
+   a pool of its own, unless it is given one to share with other lists.  A pool
+   may be shared by several lists, but not used by several threads at once.
+ */
+typedef struct smb_ll_pool
+{
+  /**
+     @brief Nodes which are ready to be used, linked through next.
+   */
+  struct smb_ll_node *free;
+
+  /**
+     @brief The slabs allocated by this pool.  The first node of each slab is
+     not used for data: its next pointer links to the next slab.
+   */
+  struct smb_ll_node *slabs;
+
+  /**
+     @brief The number of nodes in the next slab to be allocated.
+   */
+  int slab_size;
+
+  /**
+     @brief The number of nodes in the free list.
+   */
+  int available;
+
+} smb_ll_pool;
+
 /**
    @brief The actual linked list data type.  "Bare" functions return a pointer
    to this structure.
@@ -73,8 +107,65 @@ typedef struct smb_ll
    */
   int length;
 
+  /**
+     @brief The node most recently reached by index, or NULL.
+
+     Indexed access walks from whichever of this, the head, and the tail is
+     closest to the index, so stepping through the list by index is O(1) per
+     step rather than O(n).
+   */
+  struct smb_ll_node *finger;
+
+  /**
+     @brief The index of finger.
+   */
+  int finger_index;
+
+  /**
+     @brief The pool the list's nodes come from.
+   */
+  smb_ll_pool *pool;
+
+  /**
+     @brief True if the pool belongs to this list, rather than being shared.
+   */
+  bool own_pool;
+
 } smb_ll;
 
+/**
+   @brief Initialize an empty pool of nodes in memory already allocated.
+   @param pool The pool to initialize.
+ */
+void ll_pool_init(smb_ll_pool *pool);
+/**
+   @brief Allocate and initialize an empty pool of nodes.
+   @returns A pointer to the new pool.
+ */
+smb_ll_pool *ll_pool_create();
+/**
+   @brief Free every node allocated by the pool, without freeing the pointer.
+
+   Any list still using the pool must not be used afterwards, except to be
+   ll_init()'ed again.
+   @param pool The pool to destroy.
+ */
+void ll_pool_destroy(smb_ll_pool *pool);
+/**
+   @brief Free every node allocated by the pool, and the pool itself.
+   @param pool The pool to delete.
+ */
+void ll_pool_delete(smb_ll_pool *pool);
+/**
+   @brief Make sure the pool has at least n nodes ready to use.
+
+   This allocates at most once, so lists drawing on the pool won't allocate
+   until they have taken n nodes from it.
+   @param pool The pool to fill.
+   @param n The number of nodes needed.
+ */
+void ll_pool_reserve(smb_ll_pool *pool, int n);
+
 /**
    @brief Initializes a new list in memory which has already been allocated.
    @param new_list A pointer to the memory to initialize.
@@ -85,13 +176,38 @@ void ll_init(smb_ll *new_list);
    @returns A pointer to the new list.
  */
 smb_ll *ll_create();
+/**
+   @brief Initializes a new list which takes its nodes from a shared pool.
+
+   The list returns its nodes to the pool when they are removed, or when the
+   list is destroyed.  The pool must outlive the list.
+   @param new_list A pointer to the memory to initialize.
+   @param pool The pool to share.
+ */
+void ll_init_shared(smb_ll *new_list, smb_ll_pool *pool);
+/**
+   @brief Allocates and initializes a new list which takes its nodes from a
+   shared pool.  See ll_init_shared().
+   @param pool The pool to share.
+   @returns A pointer to the new list.
+ */
+smb_ll *ll_create_shared(smb_ll_pool *pool);
+/**
+   @brief Make sure the list's pool has at least n nodes ready to use, so that
+   adding n items won't allocate.
+   @param list The list.
+   @param n The number of nodes needed.
+ */
+void ll_reserve(smb_ll *list, int n);
 /**
    @brief Frees all the resources held by the linked list without freeing the
    actual pointer to the list.
 
    If you create a list on the stack and use ll_init to initialize it, calling
    ll_delete will attempt to free your stack memory (bad).  Use this to free all
-   the resources of the list without freeing the pointer.
+   the resources of the list without freeing the pointer.  If the list has its
+   own pool, the whole pool is freed at once, and otherwise its nodes are
+   returned to the shared pool.
    @param list The list to destroy.
  */
 void ll_destroy(smb_ll *list);
@@ -194,13 +310,16 @@ DATA ll_peek_front(smb_ll *list, smb_status *status);
 
    However, there is no guarantee that the index was valid.  An empty DATA
    object is returned in that case, and an SMB_INDEX_ERROR is raised.
+
+   This moves the list's finger to the index, so the list is not const, and
+   threads may not call this on a shared list without a lock.
    @param list A pointer to the list to get from.
    @param index The index to get from the list.
    @param[out] status Status variable.
    @return The data at the specified index, if it exists.
    @exception SMB_INDEX_ERROR If the given index is out of range.
  */
-DATA ll_get(const smb_ll *list, int index, smb_status *status);
+DATA ll_get(smb_ll *list, int index, smb_status *status);
 /**
    @brief Removes the node at the given index, if the index exists.
 
@@ -252,6 +371,12 @@ int  ll_length(const smb_ll *list);
 int  ll_index_of(const smb_ll *list, DATA d, DATA_COMPARE comp);
 /**
    @brief Stable sort of linked list.
+
+   This is a bottom-up natural mergesort: it splits the list into runs which
+   are already in order (or in strictly reverse order), and merges them.  So it
+   takes O(n log n) time in general, but only linear time on a list which is
+   sorted, reverse sorted, or made of a few sorted pieces.  It uses constant
+   stack space.
    @param list List to sort.
    @param cmp Comparator for sorting.
    @return Nothing, but the list is sorted in place.
@@ -0,0 +1,186 @@
+/***************************************************************************//**
+
+  @file         libstephen/oht.h
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        An insertion ordered hash table with a compact layout.
+
+  @copyright    Copyright (c) 2013-2016, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+  This has the same interface as smb_ht, but a different layout.  Entries are
+  appended to a dense array in insertion order, and the hash table itself (the
+  index) only holds the position of each entry in that array.  So, iteration,
+  destruction and resizing take time proportional to the number of entries,
+  rather than the capacity of the table, and iteration visits keys in the
+  order they were first inserted.  The index is an array of ints, so it is
+  much smaller than an array of buckets would be.
+
+*******************************************************************************/
+
+#ifndef LIBSTEPHEN_OHT_H
+#define LIBSTEPHEN_OHT_H
+
+#include "base.h"
+#include "list.h"
+#include "ht.h"  /* HASH_FUNCTION, smb_ht_bckt */
+
+/**
+   @brief Index slot which has never held an entry.
+ */
+#define OHT_EMPTY (-1)
+
+/**
+   @brief Index slot whose entry was removed (a grave).
+ */
+#define OHT_DELETED (-2)
+
+/**
+   @brief An insertion ordered hash table.
+ */
+typedef struct smb_oht
+{
+  /**
+     @brief The number of items in the table.
+   */
+  unsigned int length;
+
+  /**
+     @brief The number of index slots.  Always a power of two.
+   */
+  unsigned int allocated;
+
+  /**
+     @brief The number of entries used, including removed ones.
+   */
+  unsigned int nentries;
+
+  /**
+     @brief The hash function for this table.
+   */
+  HASH_FUNCTION hash;
+
+  /**
+     @brief Function to use to compare equality.
+   */
+  DATA_COMPARE equal;
+
+  /**
+     @brief The index: for each slot, the position of an entry, or OHT_EMPTY,
+     or OHT_DELETED.
+   */
+  int *index;
+
+  /**
+     @brief The entries, in insertion order.  Removed entries are marked as
+     graves until the table is rebuilt.  There is room for allocated *
+     HASH_TABLE_MAX_LOAD_FACTOR entries.
+   */
+  smb_ht_bckt *entries;
+
+  /**
+     @brief Random seed mixed into every hash (see ht_seed_hash()).
+   */
+  unsigned int seed;
+
+} smb_oht;
+
+/**
+   @brief Initialize an ordered hash table in memory already allocated.
+   @param table A pointer to the table to initialize.
+   @param hash_func A hash function for the table.
+   @param equal A comparison function for DATA.
+ */
+void oht_init(smb_oht *table, HASH_FUNCTION hash_func, DATA_COMPARE equal);
+/**
+   @brief Allocate and initialize an ordered hash table.
+   @param hash_func A hash function for the table.
+   @param equal A comparison function for DATA.
+   @returns A pointer to the new table.
+ */
+smb_oht *oht_create(HASH_FUNCTION hash_func, DATA_COMPARE equal);
+/**
+   @brief Free resources used by the table, but not the pointer itself.
+   Perform an action on each value first.
+   @param table The table to destroy.
+   @param deleter The action to perform on each value.
+ */
+void oht_destroy_act(smb_oht *table, DATA_ACTION deleter);
+/**
+   @brief Free resources used by the table, but not the pointer itself.
+   @param table The table to destroy.
+ */
+void oht_destroy(smb_oht *table);
+/**
+   @brief Free the table and its resources.  Perform an action on each value
+   first.
+   @param table The table to free.
+   @param deleter The action to perform on each value.
+ */
+void oht_delete_act(smb_oht *table, DATA_ACTION deleter);
+/**
+   @brief Free the table and its resources.
+   @param table The table to free.
+ */
+void oht_delete(smb_oht *table);
+
+/**
+   @brief Insert data into the table.
+
+   If the key already exists, its value is overwritten, and it keeps its place
+   in the iteration order.
+   @param table A pointer to the table.
+   @param key The key to insert.
+   @param value The value to insert at the key.
+ */
+void oht_insert(smb_oht *table, DATA key, DATA value);
+/**
+   @brief Grow the table so that it can hold n items without rebuilding.
+   @param table A pointer to the table.
+   @param n The number of items the table should be able to hold.
+ */
+void oht_reserve(smb_oht *table, unsigned int n);
+/**
+   @brief Remove a key, value pair from the table.
+   @param table A pointer to the table.
+   @param key The key to delete.
+   @param deleter The action to perform on the value before removing it.
+   @param[out] status Status variable.
+   @exception SMB_NOT_FOUND_ERROR If an item with the given key is not found.
+ */
+void oht_remove_act(smb_oht *table, DATA key, DATA_ACTION deleter,
+                    smb_status *status);
+/**
+   @brief Remove a key, value pair from the table.
+   @param table A pointer to the table.
+   @param key The key to delete.
+   @param[out] status Status variable.
+   @exception SMB_NOT_FOUND_ERROR If an item with the given key is not found.
+ */
+void oht_remove(smb_oht *table, DATA key, smb_status *status);
+/**
+   @brief Return the value associated with a key.
+   @param table A pointer to the table.
+   @param key The key whose value to retrieve.
+   @param[out] status Status variable.
+   @returns The value associated with the key.
+   @exception SMB_NOT_FOUND_ERROR If the key is not in the table.
+ */
+DATA oht_get(smb_oht const *table, DATA key, smb_status *status);
+/**
+   @brief Return true when a key is contained in the table.
+   @param table A pointer to the table.
+   @param key The key to search for.
+ */
+bool oht_contains(smb_oht const *table, DATA key);
+/**
+   @brief Return an iterator over the keys of the table, in insertion order.
+   @param table A pointer to the table.
+   @returns An iterator struct.
+ */
+smb_iter oht_get_iter(const smb_oht *table);
+
+#endif // LIBSTEPHEN_OHT_H
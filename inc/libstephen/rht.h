@@ -0,0 +1,238 @@
+/***************************************************************************//**
+
+  @file         libstephen/rht.h
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        A read-mostly hash table with lock-free readers.
+
+  @copyright    Copyright (c) 2013-2016, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+  Readers look at an immutable snapshot (a smb_hta) of the table, which they
+  find with a single atomic load.  Writers copy the current snapshot, modify the
+  copy, and publish it in place of the original.  Old snapshots are freed with
+  epoch based reclamation: each reader announces the epoch in which it started
+  reading, and a snapshot retired in some epoch is freed once no reader remains
+  from that epoch or earlier.  Readers never take a lock or wait for anything.
+
+  Since each write copies the whole table, this is meant for tables which are
+  read constantly, but written rarely (or in batches).
+
+*******************************************************************************/
+
+#ifndef LIBSTEPHEN_RHT_H
+#define LIBSTEPHEN_RHT_H
+
+#include <pthread.h>
+
+#include "base.h"
+#include "hta.h"
+
+/**
+   @brief A registered reader of a smb_rht.
+
+   Each thread which reads the table needs its own reader.
+ */
+typedef struct smb_rht_reader
+{
+  /**
+     @brief The epoch in which the current read began, or 0 if the reader is
+     not reading.
+   */
+  unsigned long epoch;
+
+  /**
+     @brief The next registered reader.
+   */
+  struct smb_rht_reader *next;
+
+} smb_rht_reader;
+
+/**
+   @brief A snapshot which has been replaced, but may still be in use.
+ */
+typedef struct smb_rht_retired
+{
+  /**
+     @brief The snapshot.
+   */
+  smb_hta *table;
+
+  /**
+     @brief The epoch in which the snapshot was replaced.
+   */
+  unsigned long epoch;
+
+  /**
+     @brief The next retired snapshot.
+   */
+  struct smb_rht_retired *next;
+
+} smb_rht_retired;
+
+/**
+   @brief A read-mostly hash table.
+ */
+typedef struct smb_rht
+{
+  /**
+     @brief The current snapshot.  Only ever accessed atomically.
+   */
+  smb_hta *current;
+
+  /**
+     @brief The current epoch.  Only ever accessed atomically.
+   */
+  unsigned long epoch;
+
+  /**
+     @brief Lock held by writers, and while registering readers.
+   */
+  pthread_mutex_t lock;
+
+  /**
+     @brief Registered readers.
+   */
+  smb_rht_reader *readers;
+
+  /**
+     @brief Snapshots waiting to be freed.
+   */
+  smb_rht_retired *retired;
+
+} smb_rht;
+
+/**
+   @brief Initialize a read-mostly hash table in memory already allocated.
+   @param rht A pointer to the table to initialize.
+   @param hash_func A hash function for the table.
+   @param equal A comparison function for keys.
+   @param key_size Size of keys.
+   @param value_size Size of values.
+   @param mode The probing engine for the snapshots.
+ */
+void rht_init(smb_rht *rht, HTA_HASH hash_func, HTA_COMP equal,
+              unsigned int key_size, unsigned int value_size,
+              smb_hta_mode mode);
+/**
+   @brief Allocate and initialize a read-mostly hash table.
+   @param hash_func A hash function for the table.
+   @param equal A comparison function for keys.
+   @param key_size Size of keys.
+   @param value_size Size of values.
+   @param mode The probing engine for the snapshots.
+   @returns A pointer to the new table.
+ */
+smb_rht *rht_create(HTA_HASH hash_func, HTA_COMP equal,
+                    unsigned int key_size, unsigned int value_size,
+                    smb_hta_mode mode);
+/**
+   @brief Free the resources used by the table, but not the pointer itself.
+
+   No other thread may be using the table.  Any readers still registered are
+   freed.
+   @param rht The table to destroy.
+ */
+void rht_destroy(smb_rht *rht);
+/**
+   @brief Free the table and its resources.
+   @param rht The table to free.
+ */
+void rht_delete(smb_rht *rht);
+
+/**
+   @brief Register a new reader (for the calling thread).
+   @param rht The table.
+   @returns A reader, to be passed to the read functions.
+ */
+smb_rht_reader *rht_reader_create(smb_rht *rht);
+/**
+   @brief Unregister and free a reader.  It must not be in a read.
+   @param rht The table.
+   @param reader The reader.
+ */
+void rht_reader_delete(smb_rht *rht, smb_rht_reader *reader);
+
+/**
+   @brief Begin reading the table.
+
+   The returned snapshot stays valid (and unchanged) until rht_read_end().  It
+   may be searched with hta_get() and hta_contains(), but must not be modified.
+   This never blocks.
+   @param rht The table.
+   @param reader The calling thread's reader.
+   @returns The current snapshot.
+ */
+const smb_hta *rht_read_begin(smb_rht *rht, smb_rht_reader *reader);
+/**
+   @brief Finish reading the table.
+   @param rht The table.
+   @param reader The calling thread's reader.
+ */
+void rht_read_end(smb_rht *rht, smb_rht_reader *reader);
+/**
+   @brief Look up a key, copying its value out.
+
+   This is a complete read (begin, lookup, end).  It never blocks.
+   @param rht The table.
+   @param reader The calling thread's reader.
+   @param key The key to look up.
+   @param[out] value Where to copy the value (value_size bytes).
+   @param[out] status Status variable.
+   @exception SMB_NOT_FOUND_ERROR If the key is not in the table.
+ */
+void rht_get(smb_rht *rht, smb_rht_reader *reader, void *key, void *value,
+             smb_status *status);
+
+/**
+   @brief Begin a write, returning a private copy of the current snapshot.
+
+   Only one write may be in progress at a time, so this blocks other writers
+   (but not readers) until rht_write_commit() or rht_write_abort().  Modify the
+   copy with the regular smb_hta functions.
+   @param rht The table.
+   @returns A copy of the current snapshot.
+ */
+smb_hta *rht_write_begin(smb_rht *rht);
+/**
+   @brief Publish a modified copy as the new snapshot.
+
+   The previous snapshot is freed once no readers can still be using it.
+   @param rht The table.
+   @param copy The copy returned by rht_write_begin().
+ */
+void rht_write_commit(smb_rht *rht, smb_hta *copy);
+/**
+   @brief Throw away a copy, leaving the table unchanged.
+   @param rht The table.
+   @param copy The copy returned by rht_write_begin().
+ */
+void rht_write_abort(smb_rht *rht, smb_hta *copy);
+/**
+   @brief Insert a single key and value (as a complete write).
+   @param rht The table.
+   @param key The key to insert.
+   @param value The value to insert at the key.
+ */
+void rht_insert(smb_rht *rht, void *key, void *value);
+/**
+   @brief Remove a single key (as a complete write).
+   @param rht The table.
+   @param key The key to remove.
+   @param[out] status Status variable.
+   @exception SMB_NOT_FOUND_ERROR If the key is not in the table.
+ */
+void rht_remove(smb_rht *rht, void *key, smb_status *status);
+/**
+   @brief Free any retired snapshots which readers are finished with.
+
+   This happens automatically on every write, but may be called to release
+   memory sooner after a burst of writes.
+   @param rht The table.
+ */
+void rht_reclaim(smb_rht *rht);
+
+#endif // LIBSTEPHEN_RHT_H
@@ -0,0 +1,247 @@
+/***************************************************************************//**
+
+  @file         libstephen/ul.h
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        An unrolled linked list implementation of the list interface.
+
+  An unrolled linked list is a linked list whose nodes each hold several items
+  in a small array.  Each node is sized to fill two cache lines, so a scan of
+  the list takes one pointer dereference (and usually one cache miss) per
+  several items, instead of per item.  Inserting and removing in the middle
+  only moves the items within one node, as with a linked list.  Like smb_al and
+  smb_ll, it has its own set of functions, prefixed with ul_*, and it can be
+  used through the generic list interface.
+
+  @copyright    Copyright (c) 2013-2016, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#ifndef LIBSTEPHEN_UL_H
+#define LIBSTEPHEN_UL_H
+
+#include "base.h"  /* DATA     */
+#include "list.h"  /* smb_list */
+
+/**
+   @brief The size of an unrolled list node in bytes.
+ */
+#define SMB_UL_NODE_SIZE 128
+
+/**
+   @brief The number of items that fit in a node alongside its header.
+ */
+#define SMB_UL_NODE_ITEMS \
+  ((SMB_UL_NODE_SIZE - 2 * sizeof(void*) - sizeof(long)) / sizeof(DATA))
+
+/**
+   @brief Node structure for the unrolled list.
+
+   This must be exposed in order for other data types to be public.  This should
+   not be used by users of the library.
+ */
+typedef struct smb_ul_node
+{
+  /**
+     @brief The previous node in the list.
+   */
+  struct smb_ul_node *prev;
+
+  /**
+     @brief The next node in the list.
+   */
+  struct smb_ul_node *next;
+
+  /**
+     @brief The number of items in this node.  Nodes in a list are never empty.
+   */
+  long count;
+
+  /**
+     @brief The items in this node, in data[0] to data[count - 1].
+   */
+  DATA data[SMB_UL_NODE_ITEMS];
+
+} smb_ul_node;
+
+/**
+   @brief The actual unrolled list data type.  "Bare" functions return a
+   pointer to this structure.
+ */
+typedef struct smb_ul
+{
+  /**
+     @brief The first node of the list.
+   */
+  smb_ul_node *head;
+
+  /**
+     @brief The last node of the list.
+   */
+  smb_ul_node *tail;
+
+  /**
+     @brief The number of items stored in the list.
+   */
+  int length;
+
+} smb_ul;
+
+/**
+   @brief Initialize an empty unrolled list in memory already allocated.
+   @param list A pointer to the memory to initialize.
+ */
+void ul_init(smb_ul *list);
+/**
+   @brief Allocate and initialize an empty unrolled list.
+   @returns A pointer to the new list.
+ */
+smb_ul *ul_create();
+/**
+   @brief Free the resources used by the list, but not the pointer given.
+   @param list A pointer to the list to destroy.
+ */
+void ul_destroy(smb_ul *list);
+/**
+   @brief Free the resources and the pointer to the list.
+   @param list A pointer to the list to delete.
+ */
+void ul_delete(smb_ul *list);
+
+/**
+   @brief Create a generic list as an unrolled list.
+   @returns A generic list pointing to a new unrolled list.
+ */
+smb_list ul_create_list();
+/**
+   @brief Cast an unrolled list to a generic list.
+   @param list The list to cast.
+   @returns A generic list pointing to the same unrolled list.
+ */
+smb_list ul_cast_to_list(smb_ul *list);
+
+/**
+   @brief Append an item to the end of the list.
+   @param list A pointer to the list to append to.
+   @param newData The data to append.
+ */
+void ul_append(smb_ul *list, DATA newData);
+/**
+   @brief Prepend an item to the beginning of the list.
+   @param list A pointer to the list to prepend to.
+   @param newData The data to prepend.
+ */
+void ul_prepend(smb_ul *list, DATA newData);
+/**
+   @brief Return the data at a specified index.
+
+   This walks from whichever end of the list is closer, one node at a time.
+   @param list A pointer to the list to get from.
+   @param index The index to get from the list.
+   @param[out] status Status variable.
+   @returns The data at the specified index.
+   @exception SMB_INDEX_ERROR If the specified index was out of range.
+ */
+DATA ul_get(const smb_ul *list, int index, smb_status *status);
+/**
+   @brief Remove the item at the given index.
+
+   If the item's node and one of its neighbors fit into one node afterwards,
+   they are merged, so removals don't leave a trail of nearly empty nodes.
+   @param list A pointer to the list to remove from.
+   @param index The index to remove from the list.
+   @param[out] status Status variable.
+   @exception SMB_INDEX_ERROR If the specified index was out of range.
+ */
+void ul_remove(smb_ul *list, int index, smb_status *status);
+/**
+   @brief Insert an item at the specified location in the list.
+
+   A full node is split in two to make room.  As with al_insert(), an index
+   less than 0 is treated as 0, and one greater than the length of the list is
+   treated as the length.
+   @param list A pointer to the list to insert into.
+   @param index The index to insert at.
+   @param newData The data to insert.
+ */
+void ul_insert(smb_ul *list, int index, DATA newData);
+/**
+   @brief Set the item at the given index.  The index must already exist.
+   @param list A pointer to the list to modify.
+   @param index The index to set.
+   @param newData The new data.
+   @param[out] status Status variable.
+   @exception SMB_INDEX_ERROR If the provided index was out of range.
+ */
+void ul_set(smb_ul *list, int index, DATA newData, smb_status *status);
+/**
+   @brief Push the data to the back of the list.  An alias for ul_append.
+   @param list A pointer to the list to push to.
+   @param newData The data to push to the back.
+ */
+void ul_push_back(smb_ul *list, DATA newData);
+/**
+   @brief Pop the data from the back of the list.
+   @param list A pointer to the list to pop from.
+   @param[out] status Status variable.
+   @returns The data from the back of the list.
+   @exception SMB_INDEX_ERROR If the list is empty.
+ */
+DATA ul_pop_back(smb_ul *list, smb_status *status);
+/**
+   @brief Peek at the data from the back of the list.
+   @param list A pointer to the list to peek from.
+   @param[out] status Status variable.
+   @returns The data at the back of the list.
+   @exception SMB_INDEX_ERROR If the list is empty.
+ */
+DATA ul_peek_back(smb_ul *list, smb_status *status);
+/**
+   @brief Push the data to the front of the list.  An alias for ul_prepend.
+   @param list A pointer to the list to push to.
+   @param newData The data to push to the front.
+ */
+void ul_push_front(smb_ul *list, DATA newData);
+/**
+   @brief Pop the data from the front of the list.
+   @param list A pointer to the list to pop from.
+   @param[out] status Status variable.
+   @returns The data from the front of the list.
+   @exception SMB_INDEX_ERROR If the list is empty.
+ */
+DATA ul_pop_front(smb_ul *list, smb_status *status);
+/**
+   @brief Peek at the data from the front of the list.
+   @param list A pointer to the list to peek from.
+   @param[out] status Status variable.
+   @returns The data from the front of the list.
+   @exception SMB_INDEX_ERROR If the list is empty.
+ */
+DATA ul_peek_front(smb_ul *list, smb_status *status);
+/**
+   @brief Return the length of the list.
+   @param list A pointer to the list.
+   @returns The length of the list.
+ */
+int ul_length(const smb_ul *list);
+/**
+   @brief Return the index of an item in the list.
+   @param list A pointer to the list.
+   @param d The item to search for.
+   @param comp The comparator to use.  NULL for bit comparison.
+   @returns Index of the item, or -1 if it's not in the list.
+ */
+int ul_index_of(const smb_ul *list, DATA d, DATA_COMPARE comp);
+
+/**
+   @brief Return an iterator on the unrolled list.
+   @param list A pointer to the list.
+   @returns The smb_iter to the list.
+ */
+smb_iter ul_get_iter(const smb_ul *list);
+
+#endif // LIBSTEPHEN_UL_H
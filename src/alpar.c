@@ -0,0 +1,356 @@
+/***************************************************************************//**
+
+  @file         alpar.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Parallel operations on array lists, from "libstephen/al.h".
+
+  @copyright    Copyright (c) 2013-2016, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libstephen/al.h"
+
+/*******************************************************************************
+
+                               Private Functions
+
+*******************************************************************************/
+
+/**
+   @brief One thread's share of a parallel operation.
+ */
+typedef struct smb_al_task
+{
+  /**
+     @brief The items this thread works on.
+   */
+  DATA *data;
+  /**
+     @brief The number of items in data.
+   */
+  int length;
+
+  /**
+     @brief For merges, the second run of items, which follows data.
+   */
+  DATA *other;
+  /**
+     @brief For merges, the number of items in other.
+   */
+  int other_length;
+  /**
+     @brief For merges, where the merged items go.
+   */
+  DATA *dest;
+
+  /**
+     @brief For maps, the function to apply.
+   */
+  DATA (*map_function)(DATA);
+  /**
+     @brief For filters, the test for items to remove.
+   */
+  bool (*test_function)(DATA);
+  /**
+     @brief For reductions, the function to reduce with.
+   */
+  DATA (*reduction)(DATA, DATA);
+  /**
+     @brief For sorts and merges, the comparator.
+   */
+  DATA_COMPARE cmp;
+
+  /**
+     @brief For reductions, this thread's result.  For filters, the number of
+     items kept, in data_llint.
+   */
+  DATA result;
+
+} smb_al_task;
+
+/**
+   @brief Return how many threads to split length items over.
+
+   This is the number of online processors, but no more than leaves each thread
+   at least grain items (and always at least one).
+   @param length The number of items.
+   @param grain The smallest number of items worth giving a thread.
+ */
+static int al_par_threads(int length, int grain)
+{
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  int threads = length / grain;
+  if (cpus < 1) {
+    cpus = 1;
+  }
+  if (threads > cpus) {
+    threads = (int) cpus;
+  }
+  if (threads < 1) {
+    threads = 1;
+  }
+  return threads;
+}
+
+/**
+   @brief Split data into nearly equal contiguous pieces, one per task.
+ */
+static void al_par_split(smb_al_task *tasks, int ntasks, DATA *data, int length)
+{
+  int i, begin, end;
+  for (i = 0; i < ntasks; i++) {
+    begin = (int) ((long long) length * i / ntasks);
+    end = (int) ((long long) length * (i + 1) / ntasks);
+    tasks[i].data = data + begin;
+    tasks[i].length = end - begin;
+  }
+}
+
+/**
+   @brief Run worker on each task, each in its own thread.
+
+   The calling thread runs the first task itself.  If a thread can't be
+   created, its task runs on the calling thread instead, so the operation still
+   completes.
+ */
+static void al_par_run(smb_al_task *tasks, int ntasks, void *(*worker)(void *))
+{
+  pthread_t *threads = smb_new(pthread_t, ntasks);
+  bool *started = smb_new(bool, ntasks);
+  int i;
+
+  for (i = 1; i < ntasks; i++) {
+    started[i] = pthread_create(&threads[i], NULL, worker, &tasks[i]) == 0;
+    if (!started[i]) {
+      worker(&tasks[i]);
+    }
+  }
+  worker(&tasks[0]);
+  for (i = 1; i < ntasks; i++) {
+    if (started[i]) {
+      pthread_join(threads[i], NULL);
+    }
+  }
+
+  smb_free(started);
+  smb_free(threads);
+}
+
+static void *al_par_map_worker(void *arg)
+{
+  smb_al_task *task = arg;
+  int i;
+  for (i = 0; i < task->length; i++) {
+    task->data[i] = task->map_function(task->data[i]);
+  }
+  return NULL;
+}
+
+/**
+   @brief Move the items to keep to the front of the task's piece.
+ */
+static void *al_par_filter_worker(void *arg)
+{
+  smb_al_task *task = arg;
+  int i, kept = 0;
+  for (i = 0; i < task->length; i++) {
+    if (!task->test_function(task->data[i])) {
+      task->data[kept++] = task->data[i];
+    }
+  }
+  task->result.data_llint = kept;
+  return NULL;
+}
+
+static void *al_par_reduce_worker(void *arg)
+{
+  smb_al_task *task = arg;
+  int i;
+  task->result = task->data[0];
+  for (i = 1; i < task->length; i++) {
+    task->result = task->reduction(task->result, task->data[i]);
+  }
+  return NULL;
+}
+
+static void *al_par_sort_worker(void *arg)
+{
+  smb_al_task *task = arg;
+  al_sort_array(task->data, task->length, task->cmp);
+  return NULL;
+}
+
+/**
+   @brief Merge the task's two sorted runs into dest.  Ties go to the first run.
+ */
+static void *al_par_merge_worker(void *arg)
+{
+  smb_al_task *task = arg;
+  int i = 0, j = 0, k = 0;
+  while (i < task->length && j < task->other_length) {
+    if (task->cmp(task->other[j], task->data[i]) < 0) {
+      task->dest[k++] = task->other[j++];
+    } else {
+      task->dest[k++] = task->data[i++];
+    }
+  }
+  memcpy(task->dest + k, task->data + i, (task->length - i) * sizeof(DATA));
+  k += task->length - i;
+  memcpy(task->dest + k, task->other + j,
+         (task->other_length - j) * sizeof(DATA));
+  return NULL;
+}
+
+/*******************************************************************************
+
+                          Public Interface Functions
+
+*******************************************************************************/
+
+void al_par_map(smb_al *list, DATA (*map_function)(DATA), int grain)
+{
+  int i, ntasks;
+  smb_al_task *tasks;
+
+  if (grain <= 0) {
+    grain = SMB_AL_PAR_GRAIN;
+  }
+  ntasks = al_par_threads(list->length, grain);
+  tasks = smb_new(smb_al_task, ntasks);
+  al_par_split(tasks, ntasks, list->data + list->start, list->length);
+  for (i = 0; i < ntasks; i++) {
+    tasks[i].map_function = map_function;
+  }
+  al_par_run(tasks, ntasks, al_par_map_worker);
+  smb_free(tasks);
+}
+
+void al_par_filter(smb_al *list, bool (*test_function)(DATA), int grain)
+{
+  int i, ntasks, length = 0;
+  smb_al_task *tasks;
+  DATA *data = list->data + list->start;
+
+  if (grain <= 0) {
+    grain = SMB_AL_PAR_GRAIN;
+  }
+  ntasks = al_par_threads(list->length, grain);
+  tasks = smb_new(smb_al_task, ntasks);
+  al_par_split(tasks, ntasks, data, list->length);
+  for (i = 0; i < ntasks; i++) {
+    tasks[i].test_function = test_function;
+  }
+  al_par_run(tasks, ntasks, al_par_filter_worker);
+
+  // Each piece kept its items at its front, so close the gaps between them.
+  for (i = 0; i < ntasks; i++) {
+    memmove(data + length, tasks[i].data,
+            tasks[i].result.data_llint * sizeof(DATA));
+    length += tasks[i].result.data_llint;
+  }
+  list->length = length;
+  smb_free(tasks);
+}
+
+DATA al_par_reduce(const smb_al *list, DATA start_value,
+                   DATA (*reduction)(DATA, DATA), int grain)
+{
+  int i, ntasks;
+  smb_al_task *tasks;
+
+  if (list->length == 0) {
+    return start_value;
+  }
+  if (grain <= 0) {
+    grain = SMB_AL_PAR_GRAIN;
+  }
+  ntasks = al_par_threads(list->length, grain);
+  tasks = smb_new(smb_al_task, ntasks);
+  al_par_split(tasks, ntasks, list->data + list->start, list->length);
+  for (i = 0; i < ntasks; i++) {
+    tasks[i].reduction = reduction;
+  }
+  al_par_run(tasks, ntasks, al_par_reduce_worker);
+
+  for (i = 0; i < ntasks; i++) {
+    start_value = reduction(start_value, tasks[i].result);
+  }
+  smb_free(tasks);
+  return start_value;
+}
+
+void al_par_sort(smb_al *list, DATA_COMPARE cmp, int grain)
+{
+  int i, ntasks, nruns;
+  smb_al_task *tasks;
+  DATA *data = list->data + list->start;
+  DATA *src, *dst, *swap, *tmp;
+
+  if (grain <= 0) {
+    grain = SMB_AL_PAR_GRAIN;
+  }
+  ntasks = al_par_threads(list->length, grain);
+  if (ntasks == 1) {
+    al_sort_array(data, list->length, cmp);
+    return;
+  }
+
+  // Sort one run per thread.
+  tasks = smb_new(smb_al_task, ntasks);
+  al_par_split(tasks, ntasks, data, list->length);
+  for (i = 0; i < ntasks; i++) {
+    tasks[i].cmp = cmp;
+  }
+  al_par_run(tasks, ntasks, al_par_sort_worker);
+
+  // Merge pairs of neighboring runs until there is only one, going back and
+  // forth between the list and a temporary buffer.  Each pair is merged by its
+  // own thread.
+  tmp = smb_new(DATA, list->length);
+  src = data;
+  dst = tmp;
+  nruns = ntasks;
+  while (nruns > 1) {
+    for (i = 0; i < nruns / 2; i++) {
+      tasks[i].data = tasks[2 * i].data;
+      tasks[i].length = tasks[2 * i].length;
+      tasks[i].other = tasks[2 * i + 1].data;
+      tasks[i].other_length = tasks[2 * i + 1].length;
+      tasks[i].dest = dst + (tasks[i].data - src);
+    }
+    if (nruns % 2 == 1) {
+      // The odd run out is "merged" with nothing, which copies it over.
+      tasks[i].data = tasks[nruns - 1].data;
+      tasks[i].length = tasks[nruns - 1].length;
+      tasks[i].other = tasks[i].data + tasks[i].length;
+      tasks[i].other_length = 0;
+      tasks[i].dest = dst + (tasks[i].data - src);
+    }
+    nruns = (nruns + 1) / 2;
+    al_par_run(tasks, nruns, al_par_merge_worker);
+
+    // The merged runs are now in dst.
+    for (i = 0; i < nruns; i++) {
+      tasks[i].data = tasks[i].dest;
+      tasks[i].length += tasks[i].other_length;
+    }
+    swap = src;
+    src = dst;
+    dst = swap;
+  }
+
+  if (src != data) {
+    memcpy(data, src, list->length * sizeof(DATA));
+  }
+  smb_free(tmp);
+  smb_free(tasks);
+}
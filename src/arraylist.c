@@ -13,13 +13,13 @@
 
 *******************************************************************************/
 
-#include <stdlib.h>      /* memcpy    */
+#include <stdint.h>      /* uint64_t  */
+#include <string.h>      /* memcpy    */
 
 #include "libstephen/al.h"
 
 /**
-   @brief The default size that an array list is allocated with, and is added to
-   the capacity each time it expands.
+   @brief The default size that an array list is allocated with.
 */
 #define SMB_AL_BLOCK_SIZE 20
 
@@ -30,70 +30,375 @@
 *******************************************************************************/
 
 /**
-   @brief Expands the smb_al by adding anothur chunk of the default size.
+   @brief Move the list's items into a new buffer of the given size, with start
+   as their new offset.
 
-   Note that this is a *private* function, not defined in libstephen.h for a
-   reason.
+   The capacity is never less than one, so that smb_new() is never asked for
+   zero bytes.
 
-   @param list The list to expand.
-   @param[out] status Status variable.
+   @param list The list to reallocate.
+   @param allocated The new capacity, at least list->length + start.
+   @param start Where the first item goes in the new buffer.
  */
-void al_expand(smb_al *list)
+static void al_resize(smb_al *list, int allocated, int start)
 {
-  list->allocated = list->allocated + SMB_AL_BLOCK_SIZE;
-  list->data = smb_renew(DATA, list->data, list->allocated);
+  DATA *data;
+  if (allocated < 1) {
+    allocated = 1;
+  }
+  data = smb_new(DATA, allocated);
+  memcpy(data + start, list->data + list->start, list->length * sizeof(DATA));
+  smb_free(list->data);
+  list->data = data;
+  list->allocated = allocated;
+  list->start = start;
 }
 
 /**
-   @brief Shifts the elements in the array up one element starting from
-   from_index.
+   @brief Make sure there are at least front free slots before the first item,
+   and back free slots after the last.
 
-   Additionally, increments the list->length.  Precondition is that from_index
-   is within range.  Since this is a private function, that is reasonable.
+   If the list is at most half full, the items are moved back to the middle of
+   the buffer.  Otherwise the buffer doubles, and the new space goes to
+   whichever end ran out.  Either way, moving n items buys at least n cheap
+   operations at that end, so pushing and popping at both ends is amortized
+   constant time.
 
    Note that this is a *private* function, not defined in libstephen.h for a
    reason.
 
-   @param list The list to operate on.
-   @param from_index The index to start shifting up from.
-   @param[out] status Status variable.
+   @param list The list to make room in.
+   @param front The number of free slots needed at the front.
+   @param back The number of free slots needed at the back.
  */
-void al_shift_up(smb_al *list, int from_index)
+void al_make_room(smb_al *list, int front, int back)
 {
-  // Check if there's space and allocate more if necessary
-  if (list->length >= list->allocated) {
-    al_expand(list);
+  int tail = list->allocated - list->start - list->length;
+  int needed = list->length + front + back;
+  int allocated, start;
+
+  if (front <= list->start && back <= tail) {
+    return;
   }
 
-  // Starting at the last element in the array, shift up by one
-  for (int i = list->length - 1; i >= from_index; i--) {
-    list->data[i + 1] = list->data[i];
+  if (needed <= list->allocated / 2) {
+    start = front + (list->allocated - needed) / 2;
+    memmove(list->data + start, list->data + list->start,
+            list->length * sizeof(DATA));
+    list->start = start;
+    return;
   }
 
-  list->length++;
+  // Keep the slack at the end which has enough, and give the rest of the new
+  // space to the end which ran out.
+  if (front < list->start) front = list->start;
+  if (back < tail) back = tail;
+  allocated = list->allocated * 2;
+  if (allocated < SMB_AL_BLOCK_SIZE) {
+    allocated = SMB_AL_BLOCK_SIZE;
+  }
+  if (allocated < list->length + front + back) {
+    allocated = list->length + front + back;
+  }
+  if (front == list->start) {
+    start = front;
+  } else if (back == tail) {
+    start = allocated - list->length - back;
+  } else {
+    start = front + (allocated - list->length - front - back) / 2;
+  }
+  al_resize(list, allocated, start);
+}
+
+/**
+   @brief Open a gap of n slots at index, shifting the items on whichever side
+   of index is shorter.
+
+   Additionally, increases list->length by n.  Precondition is that index is
+   within [0, length].  Since this is a private function, that is reasonable.
+
+   Note that this is a *private* function, not defined in libstephen.h for a
+   reason.
+
+   @param list The list to operate on.
+   @param index The index of the first slot in the gap.
+   @param n The number of slots to open.
+ */
+void al_shift_up(smb_al *list, int index, int n)
+{
+  if (index < list->length - index) {
+    al_make_room(list, n, 0);
+    memmove(list->data + list->start - n, list->data + list->start,
+            index * sizeof(DATA));
+    list->start -= n;
+  } else {
+    al_make_room(list, 0, n);
+    memmove(list->data + list->start + index + n,
+            list->data + list->start + index,
+            (list->length - index) * sizeof(DATA));
+  }
+  list->length += n;
 }
 
 /**
-   @brief Shifts the elements of the array down one element.
+   @brief Close the n slots starting at index, shifting the items on whichever
+   side of them is shorter.
 
-   The function shifts each element down in the list, until the element at the
-   given index is eventually overwritten.  Decrements the list->length.
-   Precondition is that to_index is within range.
+   Decreases list->length by n.  Precondition is that [index, index + n) is
+   within range.
 
    Note that this is a *private* function, not defined in libstephen.h for a
    reason.
 
    @param list The list to operate on.
-   @param to_index The index to shift down to.  The element at this index is
-   eventually overwritten.
+   @param index The first index to remove.
+   @param n The number of slots to remove.
  */
-void al_shift_down(smb_al *list, int to_index)
+void al_shift_down(smb_al *list, int index, int n)
 {
-  for (int i = to_index + 1; i < list->length; i++) {
-    list->data[i - 1] = list->data[i];
+  int after = list->length - index - n;
+  if (index < after) {
+    memmove(list->data + list->start + n, list->data + list->start,
+            index * sizeof(DATA));
+    list->start += n;
+  } else {
+    memmove(list->data + list->start + index,
+            list->data + list->start + index + n, after * sizeof(DATA));
+  }
+  list->length -= n;
+}
+
+/**
+   @brief Below this many items, sorts finish with an insertion sort.
+ */
+#define SMB_AL_INSERTION_SORT 16
+
+/**
+   @brief From this many items up, integer and double sorts use a radix sort.
+ */
+#define SMB_AL_RADIX_SORT 512
+
+/**
+   @brief Swap two items of an array.
+ */
+static void al_swap(DATA *a, int i, int j)
+{
+  DATA d = a[i];
+  a[i] = a[j];
+  a[j] = d;
+}
+
+/**
+   @brief Sort a small array with an insertion sort.
+   @param a The array to sort.
+   @param n The number of items in it.
+   @param cmp Comparator to order by.
+ */
+static void al_insertion_sort(DATA *a, int n, DATA_COMPARE cmp)
+{
+  int i, j;
+  DATA d;
+  for (i = 1; i < n; i++) {
+    d = a[i];
+    for (j = i; j > 0 && cmp(d, a[j - 1]) < 0; j--) {
+      a[j] = a[j - 1];
+    }
+    a[j] = d;
   }
+}
 
-  list->length--;
+/**
+   @brief Move a[root] down the max-heap of n items until it is in place.
+ */
+static void al_sift_down(DATA *a, int root, int n, DATA_COMPARE cmp)
+{
+  int child;
+  DATA d = a[root];
+  while ((child = 2 * root + 1) < n) {
+    if (child + 1 < n && cmp(a[child], a[child + 1]) < 0) {
+      child++;
+    }
+    if (cmp(d, a[child]) >= 0) {
+      break;
+    }
+    a[root] = a[child];
+    root = child;
+  }
+  a[root] = d;
+}
+
+/**
+   @brief Sort an array with a heap sort, which is O(n log n) for any input.
+ */
+static void al_heap_sort(DATA *a, int n, DATA_COMPARE cmp)
+{
+  int i;
+  for (i = n / 2 - 1; i >= 0; i--) {
+    al_sift_down(a, i, n, cmp);
+  }
+  for (i = n - 1; i > 0; i--) {
+    al_swap(a, 0, i);
+    al_sift_down(a, 0, i, cmp);
+  }
+}
+
+/**
+   @brief Sort an array with an introsort.
+
+   This is a quicksort with a median of three pivot, which switches to a heap
+   sort once it has gone depth levels deep, so bad inputs are still O(n log n).
+   It recurses on the smaller partition and loops on the larger one, so the
+   stack stays O(log n) deep.
+
+   @param a The array to sort.
+   @param n The number of items in it.
+   @param depth The number of levels left before switching to heap sort.
+   @param cmp Comparator to order by.
+ */
+static void al_intro_sort(DATA *a, int n, int depth, DATA_COMPARE cmp)
+{
+  int i, j, mid;
+  DATA pivot;
+
+  while (n > SMB_AL_INSERTION_SORT) {
+    if (depth-- == 0) {
+      al_heap_sort(a, n, cmp);
+      return;
+    }
+
+    // Order the first, middle, and last items, and use the middle as pivot.
+    mid = n / 2;
+    if (cmp(a[mid], a[0]) < 0) {
+      al_swap(a, 0, mid);
+    }
+    if (cmp(a[n - 1], a[mid]) < 0) {
+      al_swap(a, mid, n - 1);
+      if (cmp(a[mid], a[0]) < 0) {
+        al_swap(a, 0, mid);
+      }
+    }
+    pivot = a[mid];
+
+    // Hoare partition: afterwards, a[0..j] <= pivot <= a[j+1..n-1].
+    i = -1;
+    j = n;
+    while (true) {
+      do {
+        i++;
+      } while (cmp(a[i], pivot) < 0);
+      do {
+        j--;
+      } while (cmp(pivot, a[j]) < 0);
+      if (i >= j) {
+        break;
+      }
+      al_swap(a, i, j);
+    }
+
+    if (j + 1 < n - j - 1) {
+      al_intro_sort(a, j + 1, depth, cmp);
+      a += j + 1;
+      n -= j + 1;
+    } else {
+      al_intro_sort(a + j + 1, n - j - 1, depth, cmp);
+      n = j + 1;
+    }
+  }
+  al_insertion_sort(a, n, cmp);
+}
+
+/**
+   @brief Return a key for d whose unsigned order matches the order of d.
+   @param d The item.
+   @param dbl True if d is a double, false if it is a long long int.
+ */
+static uint64_t al_radix_key(DATA d, bool dbl)
+{
+  uint64_t bits = (uint64_t) d.data_llint;
+  if (!dbl) {
+    return bits ^ 0x8000000000000000ull;
+  } else if (bits & 0x8000000000000000ull) {
+    return ~bits; // negative doubles sort in reverse order of their bits
+  } else {
+    return bits ^ 0x8000000000000000ull;
+  }
+}
+
+/**
+   @brief Sort an array of integers or doubles with an LSD radix sort.
+
+   This makes one pass to count every byte of every key, and then one pass per
+   byte to scatter the items by that byte, skipping bytes where all keys are
+   the same.  That is O(n) work, with no comparator calls at all.
+
+   @param a The array to sort.
+   @param n The number of items in it.
+   @param dbl True for doubles, false for long long ints.
+ */
+static void al_radix_sort(DATA *a, int n, bool dbl)
+{
+  int counts[8][256];
+  DATA *tmp = smb_new(DATA, n);
+  DATA *src = a, *dst = tmp, *swap;
+  int i, byte, total, count;
+  uint64_t key;
+
+  memset(counts, 0, sizeof(counts));
+  for (i = 0; i < n; i++) {
+    key = al_radix_key(a[i], dbl);
+    for (byte = 0; byte < 8; byte++) {
+      counts[byte][(key >> (8 * byte)) & 0xFF]++;
+    }
+  }
+
+  for (byte = 0; byte < 8; byte++) {
+    if (counts[byte][(al_radix_key(a[0], dbl) >> (8 * byte)) & 0xFF] == n) {
+      continue; // every key has the same value in this byte
+    }
+    // Turn the counts into the starting offset of each bucket.
+    total = 0;
+    for (i = 0; i < 256; i++) {
+      count = counts[byte][i];
+      counts[byte][i] = total;
+      total += count;
+    }
+    for (i = 0; i < n; i++) {
+      key = al_radix_key(src[i], dbl);
+      dst[counts[byte][(key >> (8 * byte)) & 0xFF]++] = src[i];
+    }
+    swap = src;
+    src = dst;
+    dst = swap;
+  }
+
+  if (src != a) {
+    memcpy(a, src, n * sizeof(DATA));
+  }
+  smb_free(tmp);
+}
+
+/**
+   @brief Sort an array of DATA, using a radix sort when the comparator is one
+   that it can stand in for.
+
+   @param a The array to sort.
+   @param n The number of items in it.
+   @param cmp Comparator to order by.
+ */
+void al_sort_array(DATA *a, int n, DATA_COMPARE cmp)
+{
+  int depth = 0, i;
+
+  if (n >= SMB_AL_RADIX_SORT && cmp == data_compare_int) {
+    al_radix_sort(a, n, false);
+  } else if (n >= SMB_AL_RADIX_SORT && cmp == data_compare_float) {
+    al_radix_sort(a, n, true);
+  } else {
+    for (i = n; i > 1; i >>= 1) {
+      depth++;
+    }
+    al_intro_sort(a, n, 2 * depth, cmp);
+  }
 }
 
 /*******************************************************************************
@@ -104,15 +409,29 @@ void al_shift_down(smb_al *list, int to_index)
 
 void al_init(smb_al *list)
 {
-  list->data = smb_new(DATA, SMB_AL_BLOCK_SIZE);
+  al_init_capacity(list, SMB_AL_BLOCK_SIZE);
+}
+
+void al_init_capacity(smb_al *list, int capacity)
+{
+  if (capacity < 1) {
+    capacity = 1;
+  }
+  list->data = smb_new(DATA, capacity);
+  list->start = 0;
   list->length = 0;
-  list->allocated = SMB_AL_BLOCK_SIZE;
+  list->allocated = capacity;
 }
 
 smb_al *al_create()
+{
+  return al_create_capacity(SMB_AL_BLOCK_SIZE);
+}
+
+smb_al *al_create_capacity(int capacity)
 {
   smb_al *list = smb_new(smb_al, 1);
-  al_init(list);
+  al_init_capacity(list, capacity);
   return list;
 }
 
@@ -127,20 +446,40 @@ void al_delete(smb_al *list)
   smb_free(list);
 }
 
+void al_reserve(smb_al *list, int capacity)
+{
+  if (capacity > list->length) {
+    al_make_room(list, 0, capacity - list->length);
+  }
+}
+
+void al_shrink_to_fit(smb_al *list)
+{
+  if (list->allocated > list->length) {
+    al_resize(list, list->length, 0);
+  }
+}
+
+int al_capacity(const smb_al *list)
+{
+  return list->allocated;
+}
+
 void al_append(smb_al *list, DATA newData)
 {
-  if (list->length < list->allocated) {
-    list->data[list->length++] = newData;
-  } else {
-    al_expand(list);
-    list->data[list->length++] = newData;
+  if (list->start + list->length >= list->allocated) {
+    al_make_room(list, 0, 1);
   }
+  list->data[list->start + list->length++] = newData;
 }
 
 void al_prepend(smb_al *list, DATA newData)
 {
-  al_shift_up(list, 0);
-  list->data[0] = newData;
+  if (list->start == 0) {
+    al_make_room(list, 1, 0);
+  }
+  list->data[--list->start] = newData;
+  list->length++;
 }
 
 DATA al_get(const smb_al *list, int index, smb_status *status)
@@ -152,7 +491,7 @@ DATA al_get(const smb_al *list, int index, smb_status *status)
     return mockData;
   }
 
-  return list->data[index];
+  return list->data[list->start + index];
 }
 
 void al_remove(smb_al *list, int index, smb_status *status)
@@ -163,7 +502,7 @@ void al_remove(smb_al *list, int index, smb_status *status)
     return;
   }
 
-  al_shift_down(list, index);
+  al_shift_down(list, index, 1);
 }
 
 void al_insert(smb_al *list, int index, DATA newData)
@@ -174,8 +513,63 @@ void al_insert(smb_al *list, int index, DATA newData)
     index = list->length;
   }
 
-  al_shift_up(list, index);
-  list->data[index] = newData;
+  al_shift_up(list, index, 1);
+  list->data[list->start + index] = newData;
+}
+
+void al_extend(smb_al *list, const DATA *items, int n)
+{
+  al_insert_range(list, list->length, items, n);
+}
+
+void al_insert_range(smb_al *list, int index, const DATA *items, int n)
+{
+  DATA *copy = NULL;
+  if (n <= 0) {
+    return;
+  }
+  if (index < 0) {
+    index = 0;
+  } else if (index > list->length) {
+    index = list->length;
+  }
+
+  // Making room moves the list's items, and may free its buffer, so items from
+  // the list itself are copied out first.
+  if (items >= list->data && items < list->data + list->allocated) {
+    copy = smb_new(DATA, n);
+    memcpy(copy, items, n * sizeof(DATA));
+    items = copy;
+  }
+  al_shift_up(list, index, n);
+  memcpy(list->data + list->start + index, items, n * sizeof(DATA));
+  smb_free(copy);
+}
+
+void al_remove_range(smb_al *list, int index, int n, smb_status *status)
+{
+  *status = SMB_SUCCESS;
+  if (index < 0 || n < 0 || n > list->length - index) {
+    *status = SMB_INDEX_ERROR;
+    return;
+  }
+
+  al_shift_down(list, index, n);
+}
+
+smb_al *al_slice(const smb_al *list, int index, int n, smb_status *status)
+{
+  smb_al *slice;
+  *status = SMB_SUCCESS;
+  if (index < 0 || n < 0 || n > list->length - index) {
+    *status = SMB_INDEX_ERROR;
+    return NULL;
+  }
+
+  slice = al_create_capacity(n);
+  memcpy(slice->data, list->data + list->start + index, n * sizeof(DATA));
+  slice->length = n;
+  return slice;
 }
 
 void al_set(smb_al *list, int index, DATA newData, smb_status *status)
@@ -186,7 +580,7 @@ void al_set(smb_al *list, int index, DATA newData, smb_status *status)
     return;
   }
 
-  list->data[index] = newData;
+  list->data[list->start + index] = newData;
 }
 
 void al_push_back(smb_al *list, DATA newData)
@@ -232,16 +626,22 @@ int al_length(const smb_al *list)
   return list->length;
 }
 
+void al_sort(smb_al *list, DATA_COMPARE cmp)
+{
+  al_sort_array(list->data + list->start, list->length, cmp);
+}
+
 int al_index_of(const smb_al *list, DATA d, DATA_COMPARE comp)
 {
+  const DATA *data = list->data + list->start;
   int i;
   for (i = 0; i < list->length; i++) {
     if (comp == NULL) {
-      if (list->data[i].data_llint == d.data_llint) {
+      if (data[i].data_llint == d.data_llint) {
         return i;
       }
     } else {
-      if (comp(list->data[i], d) == 0) {
+      if (comp(data[i], d) == 0) {
         return i;
       }
     }
@@ -313,140 +713,16 @@ smb_iter al_get_iter(const smb_al *list)
 
 /*******************************************************************************
 
-                             List Adapter Functions
-
-  These guys are used as the function pointers in smb_list.  They really don't
-  need any documentation.
+                                 Generic List
 
 *******************************************************************************/
 
-void al_append_adapter(smb_list *l, DATA newData)
-{
-  smb_al *list = (smb_al*) (l->data);
-  al_append(list, newData);
-}
-
-void al_prepend_adapter(smb_list *l, DATA newData)
-{
-  smb_al *list = (smb_al*) (l->data);
-  al_prepend(list, newData);
-}
-
-DATA al_get_adapter(const smb_list *l, int index, smb_status *status)
-{
-  const smb_al *list = (const smb_al*) (l->data);
-  return al_get(list, index, status);
-}
-
-void al_set_adapter(smb_list *l, int index, DATA newData, smb_status *status)
-{
-  smb_al *list = (smb_al*) (l->data);
-  al_set(list, index, newData, status);
-}
-
-void al_remove_adapter(smb_list *l, int index, smb_status *status)
-{
-  smb_al *list = (smb_al*) (l->data);
-  al_remove(list, index, status);
-}
-
-void al_insert_adapter(smb_list *l, int index, DATA newData)
-{
-  smb_al *list = (smb_al*) (l->data);
-  al_insert(list, index, newData);
-}
-
-void al_delete_adapter(smb_list *l)
-{
-  smb_al *list = (smb_al*) (l->data);
-  al_delete(list);
-  l->data = NULL;
-  return;
-}
-
-int al_length_adapter(const smb_list *l)
-{
-  const smb_al *list = (const smb_al*) (l->data);
-  return al_length(list);
-}
-
-void al_push_back_adapter(smb_list *l, DATA newData)
-{
-  smb_al *list = (smb_al*) (l->data);
-  al_push_back(list, newData);
-}
-
-DATA al_pop_back_adapter(smb_list *l, smb_status *status)
-{
-  smb_al *list = (smb_al*) (l->data);
-  return al_pop_back(list, status);
-}
-
-DATA al_peek_back_adapter(smb_list *l, smb_status *status)
-{
-  smb_al *list = (smb_al*) (l->data);
-  return al_peek_back(list, status);
-}
-
-void al_push_front_adapter(smb_list *l, DATA newData)
-{
-  smb_al *list = (smb_al*) (l->data);
-  al_push_front(list, newData);
-}
-
-DATA al_pop_front_adapter(smb_list *l, smb_status *status)
-{
-  smb_al *list = (smb_al*) (l->data);
-  return al_pop_front(list, status);
-}
-
-DATA al_peek_front_adapter(smb_list *l, smb_status *status)
-{
-  smb_al *list = (smb_al*) (l->data);
-  return al_peek_front(list, status);
-}
-
-int al_index_of_adapter(const smb_list *l, DATA d, DATA_COMPARE comp)
-{
-  const smb_al *list = (smb_al*) (l->data);
-  return al_index_of(list, d, comp);
-}
-
-/**
-   @brief Populate generic smb_list with function pointers necessary to use
-   smb_al with it.
-
-   Note that this is a *private* function, not defined in libstephen.h for a
-   reason.  You shouldn't need the function, as there is library functionality
-   that provides it for you.
-
-   @param l The list to fill up.
- */
-void al_fill_functions(smb_list *l)
-{
-  l->append = al_append_adapter;
-  l->prepend = al_prepend_adapter;
-  l->get = al_get_adapter;
-  l->set = al_set_adapter;
-  l->remove = al_remove_adapter;
-  l->insert = al_insert_adapter;
-  l->delete = al_delete_adapter;
-  l->length = al_length_adapter;
-  l->push_back = al_push_back_adapter;
-  l->pop_back = al_pop_back_adapter;
-  l->peek_back = al_peek_back_adapter;
-  l->push_front = al_push_front_adapter;
-  l->pop_front = al_pop_front_adapter;
-  l->peek_front = al_peek_front_adapter;
-  l->index_of = al_index_of_adapter;
-}
-
 smb_list al_cast_to_list(smb_al *list)
 {
   smb_list genericList;
   genericList.data = list;
 
-  al_fill_functions(&genericList);
+  genericList.kind = SMB_LIST_AL;
 
   return genericList;
 }
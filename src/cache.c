@@ -0,0 +1,295 @@
+/***************************************************************************//**
+
+  @file         cache.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Implementation of "libstephen/cache.h".
+
+  @copyright    Copyright (c) 2013-2016, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#include <assert.h>
+#include <string.h>
+
+#include "libstephen/cache.h"
+
+/*******************************************************************************
+
+                               Private Functions
+
+*******************************************************************************/
+
+/**
+   @brief Find the index slot of a key.
+   @param cache The cache.
+   @param key Key we're looking up.
+   @param hash Hash of the key.
+   @returns The slot containing the key, or if it isn't present, the empty slot
+   where it would go.
+ */
+static unsigned int cache_slot(const smb_cache *cache, DATA key,
+                               unsigned int hash)
+{
+  unsigned int mask = cache->allocated - 1;
+  unsigned int slot = hash & mask;
+  const smb_cache_entry *entry;
+
+  while (cache->index[slot] != CACHE_EMPTY) {
+    entry = &cache->entries[cache->index[slot]];
+    if (entry->hash == hash && cache->equal(key, entry->key) == 0) {
+      break;
+    }
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+/**
+   @brief Clear an index slot, shifting later entries of its run back.
+
+   This keeps every run of the linear probing index unbroken without leaving
+   graves, which would otherwise pile up in a cache with constant turnover.
+   @param cache The cache.
+   @param slot The slot to clear.
+ */
+static void cache_unindex(smb_cache *cache, unsigned int slot)
+{
+  unsigned int mask = cache->allocated - 1;
+  unsigned int next = slot, home;
+
+  for (;;) {
+    next = (next + 1) & mask;
+    if (cache->index[next] == CACHE_EMPTY) {
+      break;
+    }
+    // An entry may move back to the hole unless its home slot is cyclically
+    // in (slot, next].
+    home = cache->entries[cache->index[next]].hash & mask;
+    if (slot < next ? (home <= slot || home > next)
+                    : (home <= slot && home > next)) {
+      cache->index[slot] = cache->index[next];
+      slot = next;
+    }
+  }
+  cache->index[slot] = CACHE_EMPTY;
+}
+
+/**
+   @brief Remove an entry from the recency list.
+ */
+static void cache_unlink(smb_cache *cache, smb_cache_entry *entry)
+{
+  if (entry->prev) {
+    entry->prev->next = entry->next;
+  } else {
+    cache->head = entry->next;
+  }
+  if (entry->next) {
+    entry->next->prev = entry->prev;
+  } else {
+    cache->tail = entry->prev;
+  }
+}
+
+/**
+   @brief Add an entry to the front (most recently used end) of the list.
+ */
+static void cache_push_front(smb_cache *cache, smb_cache_entry *entry)
+{
+  entry->prev = NULL;
+  entry->next = cache->head;
+  if (cache->head) {
+    cache->head->prev = entry;
+  } else {
+    cache->tail = entry;
+  }
+  cache->head = entry;
+}
+
+/**
+   @brief Remove an entry from the cache entirely, returning it to the free
+   list.
+   @param cache The cache.
+   @param slot The entry's index slot.
+ */
+static void cache_release(smb_cache *cache, unsigned int slot)
+{
+  smb_cache_entry *entry = &cache->entries[cache->index[slot]];
+  cache_unindex(cache, slot);
+  cache_unlink(cache, entry);
+  entry->prev = cache->free;
+  cache->free = entry;
+  cache->length--;
+}
+
+/*******************************************************************************
+
+                           Public Interface Functions
+
+*******************************************************************************/
+
+void cache_init(smb_cache *cache, unsigned int capacity,
+                HASH_FUNCTION hash_func, DATA_COMPARE equal, DATA_ACTION evict)
+{
+  unsigned int i;
+
+  // The index has twice as many slots as the capacity.
+  assert(capacity >= 1 && capacity <= HASH_TABLE_MAX_SIZE / 2);
+  cache->length = 0;
+  cache->capacity = capacity;
+  // Keep the index at most half full, so that probe runs stay short.
+  cache->allocated = 2;
+  while (cache->allocated < 2 * capacity) {
+    cache->allocated = ht_next_size(cache->allocated);
+  }
+  cache->hash = hash_func;
+  cache->equal = equal;
+  cache->evict = evict;
+  cache->index = smb_new(int, cache->allocated);
+  memset(cache->index, 0xFF, cache->allocated * sizeof(int)); // CACHE_EMPTY
+  cache->entries = smb_new(smb_cache_entry, capacity);
+  cache->head = NULL;
+  cache->tail = NULL;
+  cache->free = NULL;
+  for (i = capacity; i > 0; i--) {
+    cache->entries[i - 1].prev = cache->free;
+    cache->free = &cache->entries[i - 1];
+  }
+  cache->seed = ht_new_seed();
+  cache->hits = 0;
+  cache->misses = 0;
+  cache->evictions = 0;
+}
+
+smb_cache *cache_create(unsigned int capacity, HASH_FUNCTION hash_func,
+                        DATA_COMPARE equal, DATA_ACTION evict)
+{
+  smb_cache *cache = smb_new(smb_cache, 1);
+  cache_init(cache, capacity, hash_func, equal, evict);
+  return cache;
+}
+
+void cache_destroy_act(smb_cache *cache, DATA_ACTION deleter)
+{
+  smb_cache_entry *entry;
+
+  if (deleter) {
+    for (entry = cache->head; entry; entry = entry->next) {
+      deleter(entry->value);
+    }
+  }
+  smb_free(cache->index);
+  smb_free(cache->entries);
+}
+
+void cache_destroy(smb_cache *cache)
+{
+  cache_destroy_act(cache, NULL);
+}
+
+void cache_delete_act(smb_cache *cache, DATA_ACTION deleter)
+{
+  if (!cache) {
+    return;
+  }
+
+  cache_destroy_act(cache, deleter);
+  smb_free(cache);
+}
+
+void cache_delete(smb_cache *cache)
+{
+  cache_delete_act(cache, NULL);
+}
+
+void cache_put(smb_cache *cache, DATA key, DATA value)
+{
+  unsigned int hash = ht_seed_hash(cache->hash(key), cache->seed);
+  unsigned int slot = cache_slot(cache, key, hash);
+  smb_cache_entry *entry;
+
+  if (cache->index[slot] != CACHE_EMPTY) {
+    entry = &cache->entries[cache->index[slot]];
+    entry->value = value;
+    cache_unlink(cache, entry);
+    cache_push_front(cache, entry);
+    return;
+  }
+
+  if (cache->length >= cache->capacity) {
+    entry = cache->tail;
+    if (cache->evict) {
+      cache->evict(entry->value);
+    }
+    cache_release(cache, cache_slot(cache, entry->key, entry->hash));
+    cache->evictions++;
+    // Releasing may have shifted entries into the slot we found.
+    slot = cache_slot(cache, key, hash);
+  }
+
+  entry = cache->free;
+  cache->free = entry->prev;
+  entry->key = key;
+  entry->value = value;
+  entry->hash = hash;
+  cache->index[slot] = entry - cache->entries;
+  cache_push_front(cache, entry);
+  cache->length++;
+}
+
+DATA cache_get(smb_cache *cache, DATA key, smb_status *status)
+{
+  unsigned int slot = cache_slot(cache, key,
+                                 ht_seed_hash(cache->hash(key), cache->seed));
+  smb_cache_entry *entry;
+  *status = SMB_SUCCESS;
+
+  if (cache->index[slot] == CACHE_EMPTY) {
+    cache->misses++;
+    *status = SMB_NOT_FOUND_ERROR;
+    return PTR(NULL);
+  }
+
+  cache->hits++;
+  entry = &cache->entries[cache->index[slot]];
+  if (entry != cache->head) {
+    cache_unlink(cache, entry);
+    cache_push_front(cache, entry);
+  }
+  return entry->value;
+}
+
+bool cache_contains(smb_cache const *cache, DATA key)
+{
+  unsigned int slot = cache_slot(cache, key,
+                                 ht_seed_hash(cache->hash(key), cache->seed));
+  return cache->index[slot] != CACHE_EMPTY;
+}
+
+void cache_remove_act(smb_cache *cache, DATA key, DATA_ACTION deleter,
+                      smb_status *status)
+{
+  unsigned int slot = cache_slot(cache, key,
+                                 ht_seed_hash(cache->hash(key), cache->seed));
+  *status = SMB_SUCCESS;
+
+  if (cache->index[slot] == CACHE_EMPTY) {
+    *status = SMB_NOT_FOUND_ERROR;
+    return;
+  }
+
+  if (deleter) {
+    deleter(cache->entries[cache->index[slot]].value);
+  }
+  cache_release(cache, slot);
+}
+
+void cache_remove(smb_cache *cache, DATA key, smb_status *status)
+{
+  cache_remove_act(cache, key, NULL, status);
+}
@@ -0,0 +1,152 @@
+/***************************************************************************//**
+
+  @file         cht.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Implementation of "libstephen/cht.h".
+
+  @copyright    Copyright (c) 2013-2016, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#include <pthread.h>
+
+#include "libstephen/cht.h"
+
+/*******************************************************************************
+
+                               Private Functions
+
+*******************************************************************************/
+
+/**
+   @brief Return the segment which holds a key.
+   @param table The table.
+   @param key The key.
+ */
+static smb_cht_seg *cht_segment(const smb_cht *table, DATA key)
+{
+  unsigned int hash = ht_seed_hash(table->hash(key), table->seed);
+  return &table->segments[hash & (table->nsegments - 1)];
+}
+
+/*******************************************************************************
+
+                           Public Interface Functions
+
+*******************************************************************************/
+
+void cht_init(smb_cht *table, HASH_FUNCTION hash_func, DATA_COMPARE equal,
+              unsigned int nsegments)
+{
+  unsigned int i;
+
+  if (nsegments == 0) {
+    nsegments = SMB_CHT_DEFAULT_SEGMENTS;
+  }
+  table->nsegments = 1;
+  while (table->nsegments < nsegments) {
+    table->nsegments *= 2;
+  }
+
+  table->hash = hash_func;
+  table->seed = ht_new_seed();
+  table->segments = smb_new(smb_cht_seg, table->nsegments);
+  for (i = 0; i < table->nsegments; i++) {
+    pthread_rwlock_init(&table->segments[i].lock, NULL);
+    ht_init(&table->segments[i].table, hash_func, equal);
+  }
+}
+
+smb_cht *cht_create(HASH_FUNCTION hash_func, DATA_COMPARE equal,
+                    unsigned int nsegments)
+{
+  smb_cht *table = smb_new(smb_cht, 1);
+  cht_init(table, hash_func, equal, nsegments);
+  return table;
+}
+
+void cht_destroy_act(smb_cht *table, DATA_ACTION deleter)
+{
+  unsigned int i;
+  for (i = 0; i < table->nsegments; i++) {
+    ht_destroy_act(&table->segments[i].table, deleter);
+    pthread_rwlock_destroy(&table->segments[i].lock);
+  }
+  smb_free(table->segments);
+}
+
+void cht_destroy(smb_cht *table)
+{
+  cht_destroy_act(table, NULL);
+}
+
+void cht_delete_act(smb_cht *table, DATA_ACTION deleter)
+{
+  if (!table) {
+    return;
+  }
+
+  cht_destroy_act(table, deleter);
+  smb_free(table);
+}
+
+void cht_delete(smb_cht *table)
+{
+  cht_delete_act(table, NULL);
+}
+
+void cht_insert(smb_cht *table, DATA key, DATA value)
+{
+  smb_cht_seg *seg = cht_segment(table, key);
+  pthread_rwlock_wrlock(&seg->lock);
+  ht_insert(&seg->table, key, value);
+  pthread_rwlock_unlock(&seg->lock);
+}
+
+void cht_remove_act(smb_cht *table, DATA key, DATA_ACTION deleter,
+                    smb_status *status)
+{
+  smb_cht_seg *seg = cht_segment(table, key);
+  pthread_rwlock_wrlock(&seg->lock);
+  ht_remove_act(&seg->table, key, deleter, status);
+  pthread_rwlock_unlock(&seg->lock);
+}
+
+void cht_remove(smb_cht *table, DATA key, smb_status *status)
+{
+  cht_remove_act(table, key, NULL, status);
+}
+
+DATA cht_get(smb_cht *table, DATA key, smb_status *status)
+{
+  DATA value;
+  smb_cht_seg *seg = cht_segment(table, key);
+  // Lookups don't modify a smb_ht, so any number may run at once.
+  pthread_rwlock_rdlock(&seg->lock);
+  value = ht_get(&seg->table, key, status);
+  pthread_rwlock_unlock(&seg->lock);
+  return value;
+}
+
+bool cht_contains(smb_cht *table, DATA key)
+{
+  smb_status status = SMB_SUCCESS;
+  cht_get(table, key, &status);
+  return status == SMB_SUCCESS;
+}
+
+unsigned int cht_length(smb_cht *table)
+{
+  unsigned int i, length = 0;
+  for (i = 0; i < table->nsegments; i++) {
+    pthread_rwlock_rdlock(&table->segments[i].lock);
+    length += table->segments[i].table.length;
+    pthread_rwlock_unlock(&table->segments[i].lock);
+  }
+  return length;
+}
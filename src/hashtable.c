@@ -15,9 +15,11 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include <unistd.h>
 
 #include "libstephen/ht.h"
-#include "libstephen/re.h" // nelem()
 
 /*******************************************************************************
 
@@ -25,84 +27,85 @@
 
 *******************************************************************************/
 
-unsigned int ht_primes[] = {
-  31, // 2^5
-  61,
-  127,
-  257,
-  509,
-  1021,
-  2053,
-  4093,
-  8191,
-  16381,
-  32771,
-  65537,
-  131071,
-  262147,
-  524287,
-  1048573,
-  2097143,
-  4194301,
-  8388617,
-  16777213,
-  33554467,
-  67108859,
-  134217757,
-  268435459,
-  536870909,
-  1073741827,
-  2147483647,
-  4294967291 // 2^32
-};
+/**
+   @brief Returns the next hashtable size.
+
+   Table sizes are powers of two, so that a hash may be reduced to an index by
+   masking instead of by an expensive modulo.  They stop at
+   HASH_TABLE_MAX_SIZE, rather than overflowing.
 
-int binary_search(unsigned int *array, int len, unsigned int value)
+   @param current The current size of the hash table.
+   @returns The next size in the sequence for hash tables.
+ */
+unsigned int ht_next_size(unsigned int current)
 {
-  int lo = 0, hi = len, mid;
-  while (lo < hi) {
-    mid = (lo + hi) / 2;
-    if (value <= array[mid]) {
-      hi = mid;
-    } else {
-      lo = mid + 1;
-    }
+  if (current >= HASH_TABLE_MAX_SIZE) {
+    return HASH_TABLE_MAX_SIZE;
   }
-  return lo;
+  return current * 2;
 }
 
-/**
-   @brief Returns the next hashtable size.
+unsigned int ht_probe_length(unsigned int hash, unsigned int index,
+                             unsigned int allocated)
+{
+  unsigned int mask = allocated - 1;
+  unsigned int probe = hash & mask;
+  unsigned int j = 1;
 
-   @param current The current size of the hash table.
-   @returns The next size in the sequence for hash tables.
+  // Follow the same triangular sequence as ht_find_insert().
+  while (probe != index) {
+    probe = (probe + j) & mask;
+    j++;
+  }
+  return j;
+}
+
+void ht_stats_record(smb_ht_stats *stats, unsigned int probe)
+{
+  if (probe > HT_STATS_HISTOGRAM_SIZE) {
+    stats->histogram[HT_STATS_HISTOGRAM_SIZE - 1]++;
+  } else {
+    stats->histogram[probe - 1]++;
+  }
+  if (probe > stats->max_probe) {
+    stats->max_probe = probe;
+  }
+  stats->avg_probe += probe;
+}
+
+/**
+   @brief Hash a key for a table, mixing in the table's seed.
+   @param table The table.
+   @param key The key to hash.
  */
-int ht_next_size(int current)
+static unsigned int ht_hash(const smb_ht *table, DATA key)
 {
-  int curridx = binary_search(ht_primes, nelem(ht_primes), current);
-  return ht_primes[curridx + 1];
+  return ht_seed_hash(table->hash(key), table->seed);
 }
 
 /**
    @brief Find the proper index for insertion into the table.
-   @param obj Hash table object.
-   @param key Key we're inserting.
+
+   This is the first slot in the probe sequence which is not full.  It should
+   only be called once the key is known not to be present.
+   @param buckets Buckets of the table.
+   @param allocated Number of buckets.
+   @param hash Hash of the key we're inserting.
  */
-unsigned int ht_find_insert(const smb_ht *obj, DATA key)
+unsigned int ht_find_insert(const smb_ht_bckt *buckets, unsigned int allocated,
+                            unsigned int hash)
 {
-  unsigned int index = obj->hash(key) % obj->allocated;
+  unsigned int mask = allocated - 1;
+  unsigned int index = hash & mask;
   unsigned int j = 1;
 
-  // Continue searching until we either find a non-full slot, or we find the key
-  // we're trying to insert.
-  // until (cell.mark != full || cell.key == key)
-  // while (cell.mark == full && cell.key != key)
-  while (obj->table[index].mark == HT_FULL &&
-         obj->equal(key, obj->table[index].key) != 0) {
-    // This is quadratic probing, but I'm avoiding squaring numbers:
-    // j:     1, 3, 5, 7,  9, 11, ..
-    // index: 0, 1, 4, 9, 16, 25, 36
-    index = (index + j) % obj->allocated;
-    j += 2;
+  while (buckets[index].mark == HT_FULL) {
+    // This is quadratic probing by triangular numbers, which visits every slot
+    // of a power of two sized table:
+    // j:     1, 2, 3, 4,  5,  6, ..
+    // index: 0, 1, 3, 6, 10, 15, 21
+    index = (index + j) & mask;
+    j++;
   }
 
   return index;
@@ -110,58 +113,177 @@ unsigned int ht_find_insert(const smb_ht *obj, DATA key)
 
 /**
    @brief Find the proper index for retrieval from the table.
+
+   The cached hash of each full slot is compared before the comparator is
+   called, so most mismatches never make it to the function pointer.
    @param obj Hash table object.
+   @param buckets Buckets to search (the table, or the old table).
+   @param allocated Number of buckets.
    @param key Key we're looking up.
+   @param hash Hash of the key we're looking up.
  */
-unsigned int ht_find_retrieve(const smb_ht *obj, DATA key)
+unsigned int ht_find_retrieve(const smb_ht *obj, const smb_ht_bckt *buckets,
+                              unsigned int allocated, DATA key,
+                              unsigned int hash)
 {
-  unsigned int index = obj->hash(key) % obj->allocated;
+  unsigned int mask = allocated - 1;
+  unsigned int index = hash & mask;
   unsigned int j = 1;
 
   // Continue searching until we either find an empty slot, or we find the key
-  // we're trying to insert.
-  // until (cell.mark == empty || cell.key == key)
-  // while (cell.mark != empty && cell.key != key)
-  while (obj->table[index].mark != HT_EMPTY &&
-         obj->equal(key, obj->table[index].key) != 0) {
-    // This is quadratic probing, but I'm avoiding squaring numbers:
-    // j:     1, 3, 5, 7,  9, 11, ..
-    // index: 0, 1, 4, 9, 16, 25, 36
-    index = (index + j) % obj->allocated;
-    j += 2;
+  // we're trying to insert.  Graves are skipped without comparison.
+  while (buckets[index].mark != HT_EMPTY) {
+    if (buckets[index].mark == HT_FULL && buckets[index].hash == hash &&
+        obj->equal(key, buckets[index].key) == 0) {
+      break;
+    }
+    // Triangular probing, see ht_find_insert().
+    index = (index + j) & mask;
+    j++;
   }
   return index;
 }
 
 /**
-   @brief Expand the hash table, adding increment to the capacity of the table.
+   @brief Return the bucket containing a key, or NULL if there is none.
 
-   @param table The table to expand.
+   While an incremental resize is in progress, keys may be in either table.
+   @param obj Hash table object.
+   @param key Key we're looking up.
+   @param hash Hash of the key we're looking up.
  */
-void ht_resize(smb_ht *table)
+static smb_ht_bckt *ht_lookup(const smb_ht *obj, DATA key, unsigned int hash)
 {
-  smb_ht_bckt *old_table;
-  unsigned int index, old_allocated;
+  unsigned int index = ht_find_retrieve(obj, obj->table, obj->allocated, key,
+                                        hash);
+  if (obj->table[index].mark == HT_FULL) {
+    return &obj->table[index];
+  }
 
-  // Step one: allocate new space for the table
-  old_table = table->table;
-  old_allocated = table->allocated;
-  table->length = 0;
-  table->allocated = ht_next_size(old_allocated);
+  if (obj->old_table) {
+    index = ht_find_retrieve(obj, obj->old_table, obj->old_allocated, key, hash);
+    if (obj->old_table[index].mark == HT_FULL) {
+      return &obj->old_table[index];
+    }
+  }
+  return NULL;
+}
+
+/**
+   @brief Find the slot a new key will be inserted into, keeping the grave count
+   up to date if the slot is a grave being reused.
+   @param table The table.
+   @param hash Hash of the key we're inserting.
+ */
+static unsigned int ht_claim(smb_ht *table, unsigned int hash)
+{
+  unsigned int index = ht_find_insert(table->table, table->allocated, hash);
+  if (table->table[index].mark == HT_GRAVE) {
+    table->graves--;
+  }
+  return index;
+}
+
+/**
+   @brief Migrate buckets from the old table into the new one.
+
+   Since every bucket caches its hash, entries are moved directly into their new
+   slots without calling the hash function or comparator.  Migrated buckets are
+   left as graves, so that probes for the remaining old entries still work.
+   The old table is freed once it has been completely drained.
+   @param table The table.
+   @param nbuckets The maximum number of old buckets to visit.
+ */
+static void ht_rehash_step(smb_ht *table, unsigned int nbuckets)
+{
+  smb_ht_bckt *bckt;
+  unsigned int index;
+
+  while (table->old_table && nbuckets-- > 0) {
+    bckt = &table->old_table[table->rehash_index];
+    if (bckt->mark == HT_FULL) {
+      index = ht_claim(table, bckt->hash);
+      table->table[index] = *bckt;
+      bckt->mark = HT_GRAVE;
+    }
+
+    table->rehash_index++;
+    if (table->rehash_index >= table->old_allocated) {
+      smb_free(table->old_table);
+      table->old_table = NULL;
+      table->old_allocated = 0;
+      table->rehash_index = 0;
+    }
+  }
+}
+
+/**
+   @brief Rebuild the hash table with a new capacity.
+
+   The current table becomes the old table, and its entries are migrated
+   immediately, or later on if the table is incremental.  The new table has no
+   graves.
+   @param table The table to rebuild.
+   @param new_size The new number of slots (a power of two).
+ */
+static void ht_rehash(smb_ht *table, unsigned int new_size)
+{
+  // Step one: finish any resize that is still in progress.
+  ht_rehash_step(table, table->old_allocated);
+
+  // Step two: allocate new space for the table.
+  table->old_table = table->table;
+  table->old_allocated = table->allocated;
+  table->rehash_index = 0;
+  table->allocated = new_size;
+  table->graves = 0;
   table->table = smb_new(smb_ht_bckt, table->allocated);
 
   // Zero out the new block too.
   memset((void*)table->table, 0, table->allocated * sizeof(smb_ht_bckt));
 
-  // Step two, add the old items to the new table.
-  for (index = 0; index < old_allocated; index++) {
-    if (old_table[index].mark == HT_FULL) {
-      ht_insert(table, old_table[index].key, old_table[index].value);
-    }
+  // Step three: move the old items to the new table (and free the old one).
+  if (!table->incremental) {
+    ht_rehash_step(table, table->old_allocated);
+  }
+}
+
+/**
+   @brief Expand the hash table, adding increment to the capacity of the table.
+   @param table The table to expand.
+ */
+void ht_resize(smb_ht *table)
+{
+  ht_rehash(table, ht_next_size(table->allocated));
+}
+
+/**
+   @brief Clean up after a removal, if the table has become sparse or has too
+   many graves.
+
+   When the load factor drops below HASH_TABLE_MIN_LOAD_FACTOR, the table is
+   halved.  Otherwise, when more than HASH_TABLE_MAX_GRAVE_FACTOR of its slots
+   are graves, it is rehashed at the same size.  Both are skipped while an
+   incremental resize is in progress.  Migration drops the old table's graves,
+   but not graves made in the new table during the resize.  Those stay until a
+   removal after the resize finishes runs this again, so compaction is only
+   deferred.
+   @param table The table.
+ */
+static void ht_compact(smb_ht *table)
+{
+  if (table->old_table) {
+    return;
   }
 
-  // Step three: free old data.
-  smb_free(old_table);
+  if (table->allocated > HASH_TABLE_INITIAL_SIZE &&
+      table->length < table->allocated * HASH_TABLE_MIN_LOAD_FACTOR) {
+    ht_rehash(table, table->allocated / 2);
+    table->shrinks++;
+  } else if (table->graves > table->allocated * HASH_TABLE_MAX_GRAVE_FACTOR) {
+    ht_rehash(table, table->allocated);
+    table->compactions++;
+  }
 }
 
 /**
@@ -175,6 +297,226 @@ double ht_load_factor(smb_ht *table)
   return ((double) table->length) / ((double) table->allocated);
 }
 
+/**
+   @brief Insert data into the hash table, given the hash of the key.
+   @param table The table.
+   @param key The key to insert.
+   @param value The value to insert at the key.
+   @param hash The hash of the key.
+ */
+static void ht_insert_hashed(smb_ht *table, DATA key, DATA value,
+                             unsigned int hash)
+{
+  unsigned int index;
+  smb_ht_bckt *bckt;
+
+  ht_rehash_step(table, HASH_TABLE_REHASH_STEP);
+  if (ht_load_factor(table) > HASH_TABLE_MAX_LOAD_FACTOR) {
+    ht_resize(table);
+  }
+
+  // First, probe for the key as if we're trying to return it.  If we find it,
+  // we update the existing key.
+  bckt = ht_lookup(table, key, hash);
+  if (bckt) {
+    bckt->value = value;
+    return;
+  }
+
+  // If we don't find the key, then we find the first open slot or gravestone.
+  index = ht_claim(table, hash);
+  table->table[index].key = key;
+  table->table[index].value = value;
+  table->table[index].hash = hash;
+  table->table[index].mark = HT_FULL;
+  table->length++;
+}
+
+/*******************************************************************************
+
+                                Hash Functions
+
+*******************************************************************************/
+
+/**
+   @brief The wyhash secret constants.
+ */
+static const uint64_t hash_secret[4] = {
+  0xa0761d6478bd642full, 0xe7037ed1a0b428dbull,
+  0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull
+};
+
+/**
+   @brief Multiply two 64 bit numbers into a 128 bit product, returning the low
+   half in a and the high half in b.
+ */
+static void hash_mum(uint64_t *a, uint64_t *b)
+{
+#ifdef __SIZEOF_INT128__
+  __uint128_t r = (__uint128_t) *a * *b;
+  *a = (uint64_t) r;
+  *b = (uint64_t) (r >> 64);
+#else
+  uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t) *a, lb = (uint32_t) *b;
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t = rl + (rm0 << 32), c = t < rl, lo;
+  lo = t + (rm1 << 32);
+  c += lo < t;
+  *a = lo;
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+/**
+   @brief Multiply two 64 bit numbers and fold the 128 bit product in half.
+ */
+static uint64_t hash_mix(uint64_t a, uint64_t b)
+{
+  hash_mum(&a, &b);
+  return a ^ b;
+}
+
+static uint64_t hash_read8(const uint8_t *p)
+{
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static uint64_t hash_read4(const uint8_t *p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+/**
+   @brief The murmur3 64 bit finalizer.  Every input bit affects every output
+   bit, and it is a bijection.
+ */
+static uint64_t hash_fmix(uint64_t x)
+{
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdull;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ull;
+  x ^= x >> 33;
+  return x;
+}
+
+/**
+   @brief Return a new random seed.
+
+   Seeds come from a splitmix64 sequence, which starts from the time, the
+   process ID and the address of the sequence state (randomized by ASLR).  This
+   is not cryptographic, but it is not predictable from outside the process.
+ */
+static uint64_t hash_random_seed(void)
+{
+  static uint64_t state = 0;
+  uint64_t expected = 0, initial;
+  struct timeval tv;
+
+  if (__atomic_load_n(&state, __ATOMIC_RELAXED) == 0) {
+    gettimeofday(&tv, NULL);
+    initial = hash_fmix(((uint64_t) tv.tv_sec << 32) ^ tv.tv_usec ^
+                        ((uint64_t) getpid() << 16) ^ (uintptr_t) &state) | 1;
+    __atomic_compare_exchange_n(&state, &expected, initial, false,
+                                __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+  }
+  return hash_fmix(__atomic_add_fetch(&state, 0x9e3779b97f4a7c15ull,
+                                      __ATOMIC_RELAXED));
+}
+
+/**
+   @brief Return the process-wide secret used to seed the string hashes.
+
+   It is chosen randomly the first time it is needed.
+ */
+static uint64_t hash_process_secret(void)
+{
+  static uint64_t secret = 0;
+  uint64_t expected = 0, value = __atomic_load_n(&secret, __ATOMIC_ACQUIRE);
+
+  if (value == 0) {
+    value = hash_random_seed() | 1;
+    // If another thread got there first, use its secret instead.
+    if (!__atomic_compare_exchange_n(&secret, &expected, value, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      value = expected;
+    }
+  }
+  return value;
+}
+
+unsigned int ht_hash_bytes(const void *data, size_t len, uint64_t seed)
+{
+  // This is wyhash (final version 4), which reads eight bytes at a time and
+  // mixes with 64x64->128 bit multiplies.
+  const uint8_t *p = (const uint8_t*) data;
+  const uint64_t *s = hash_secret;
+  uint64_t a, b, see1, see2;
+  size_t i = len;
+
+  seed ^= hash_mix(seed ^ s[0], s[1]);
+  if (len <= 16) {
+    if (len >= 4) {
+      a = (hash_read4(p) << 32) | hash_read4(p + ((len >> 3) << 2));
+      b = (hash_read4(p + len - 4) << 32) |
+        hash_read4(p + len - 4 - ((len >> 3) << 2));
+    } else if (len > 0) {
+      a = ((uint64_t) p[0] << 16) | ((uint64_t) p[len >> 1] << 8) | p[len - 1];
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    if (i > 48) {
+      see1 = see2 = seed;
+      do {
+        seed = hash_mix(hash_read8(p) ^ s[1], hash_read8(p + 8) ^ seed);
+        see1 = hash_mix(hash_read8(p + 16) ^ s[2], hash_read8(p + 24) ^ see1);
+        see2 = hash_mix(hash_read8(p + 32) ^ s[3], hash_read8(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = hash_mix(hash_read8(p) ^ s[1], hash_read8(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = hash_read8(p + i - 16);
+    b = hash_read8(p + i - 8);
+  }
+
+  a ^= s[1];
+  b ^= seed;
+  hash_mum(&a, &b);
+  return (unsigned int) hash_mix(a ^ s[0] ^ len, b ^ s[1]);
+}
+
+unsigned int ht_int_hash(DATA data)
+{
+  return (unsigned int) hash_fmix((uint64_t) data.data_llint);
+}
+
+unsigned int ht_seed_hash(unsigned int hash, unsigned int seed)
+{
+  return (unsigned int) hash_fmix(((uint64_t) seed << 32) | hash);
+}
+
+unsigned int ht_new_seed(void)
+{
+  return (unsigned int) hash_random_seed();
+}
+
+unsigned int ht_string_hash_len(const char *str, size_t len)
+{
+  return ht_hash_bytes(str, len, hash_process_secret());
+}
+
 /*******************************************************************************
 
                            Public Interface Functions
@@ -188,6 +530,14 @@ void ht_init(smb_ht *table, HASH_FUNCTION hash_func, DATA_COMPARE equal)
   table->allocated = HASH_TABLE_INITIAL_SIZE;
   table->hash = hash_func;
   table->equal = equal;
+  table->incremental = false;
+  table->old_table = NULL;
+  table->old_allocated = 0;
+  table->rehash_index = 0;
+  table->graves = 0;
+  table->compactions = 0;
+  table->shrinks = 0;
+  table->seed = ht_new_seed();
 
   // Create the bucket list
   table->table = smb_new(smb_ht_bckt, HASH_TABLE_INITIAL_SIZE);
@@ -216,10 +566,16 @@ void ht_destroy_act(smb_ht *table, DATA_ACTION deleter)
         deleter(table->table[i].value);
       }
     }
+    for (i = 0; i < table->old_allocated; i++) {
+      if (table->old_table[i].mark == HT_FULL) {
+        deleter(table->old_table[i].value);
+      }
+    }
   }
 
   // Delete the table.
   smb_free(table->table);
+  smb_free(table->old_table);
 }
 
 void ht_destroy(smb_ht *table)
@@ -242,49 +598,80 @@ void ht_delete(smb_ht *table)
   ht_delete_act(table, NULL);
 }
 
-void ht_insert(smb_ht *table, DATA key, DATA value)
+void ht_set_incremental(smb_ht *table, bool incremental)
 {
-  unsigned int index;
-  if (ht_load_factor(table) >= HASH_TABLE_MAX_LOAD_FACTOR) {
-    ht_resize(table);
+  table->incremental = incremental;
+  if (!incremental) {
+    ht_rehash_step(table, table->old_allocated);
   }
+}
 
-  // First, probe for the key as if we're trying to return it.  If we find it,
-  // we update the existing key.
-  index = ht_find_retrieve(table, key);
-  if (table->table[index].mark == HT_FULL) {
-    table->table[index].value = value;
-    return;
+void ht_insert(smb_ht *table, DATA key, DATA value)
+{
+  ht_insert_hashed(table, key, value, ht_hash(table, key));
+}
+
+void ht_reserve(smb_ht *table, unsigned int n)
+{
+  unsigned int size = table->allocated;
+  while (n > size * HASH_TABLE_MAX_LOAD_FACTOR && size < HASH_TABLE_MAX_SIZE) {
+    size = ht_next_size(size);
+  }
+  if (size > table->allocated) {
+    ht_rehash(table, size);
   }
+}
 
-  // If we don't find the key, then we find the first open slot or gravestone.
-  index = ht_find_insert(table, key);
-  table->table[index].key = key;
-  table->table[index].value = value;
-  table->table[index].mark = HT_FULL;
-  table->length++;
+void ht_insert_many(smb_ht *table, const DATA *keys, const DATA *values,
+                    unsigned int n)
+{
+  unsigned int hashes[HASH_TABLE_BATCH_SIZE];
+  unsigned int i, j, batch;
+
+  ht_reserve(table, table->length + n);
+
+  for (i = 0; i < n; i += batch) {
+    batch = n - i < HASH_TABLE_BATCH_SIZE ? n - i : HASH_TABLE_BATCH_SIZE;
+    // Hash the whole batch first, and start loading each key's first bucket, so
+    // that the cache misses overlap instead of happening one at a time.
+    for (j = 0; j < batch; j++) {
+      hashes[j] = ht_hash(table, keys[i + j]);
+      __builtin_prefetch(&table->table[hashes[j] & (table->allocated - 1)]);
+    }
+    for (j = 0; j < batch; j++) {
+      ht_insert_hashed(table, keys[i + j], values[i + j], hashes[j]);
+    }
+  }
 }
 
 void ht_remove_act(smb_ht *table, DATA key, DATA_ACTION deleter,
                    smb_status *status)
 {
   *status = SMB_SUCCESS;
-  unsigned int index = ht_find_retrieve(table, key);
+  smb_ht_bckt *bckt;
+
+  ht_rehash_step(table, HASH_TABLE_REHASH_STEP);
+  bckt = ht_lookup(table, key, ht_hash(table, key));
 
-  // If the returned slot isn't full, that means we couldn't find it.
-  if (table->table[index].mark != HT_FULL) {
+  // If there's no bucket, that means we couldn't find it.
+  if (!bckt) {
     *status = SMB_NOT_FOUND_ERROR;
     return;
   }
 
   // Perform the action if there is one.
   if (deleter) {
-    deleter(table->table[index].value);
+    deleter(bckt->value);
   }
 
-  // Mark the slot with a "grave stone", indicating it is deleted.
-  table->table[index].mark = HT_GRAVE;
+  // Mark the slot with a "grave stone", indicating it is deleted.  Graves in
+  // the old table of a resize aren't counted, since it will be freed.
+  bckt->mark = HT_GRAVE;
   table->length--;
+  if (bckt >= table->table && bckt < table->table + table->allocated) {
+    table->graves++;
+  }
+  ht_compact(table);
 }
 
 void ht_remove(smb_ht *table, DATA key, smb_status *status)
@@ -295,16 +682,16 @@ void ht_remove(smb_ht *table, DATA key, smb_status *status)
 DATA ht_get(smb_ht const *table, DATA key, smb_status *status)
 {
   *status = SMB_SUCCESS;
-  unsigned int index = ht_find_retrieve(table, key);
+  smb_ht_bckt *bckt = ht_lookup(table, key, ht_hash(table, key));
 
-  // If the slot is not marked full, we didn't find the key.
-  if (table->table[index].mark != HT_FULL) {
+  // If there's no bucket, we didn't find the key.
+  if (!bckt) {
     *status = SMB_NOT_FOUND_ERROR;
     return PTR(NULL);
   }
 
   // Otherwise, return the key.
-  return table->table[index].value;
+  return bckt->value;
 }
 
 bool ht_contains(smb_ht const *table, DATA key)
@@ -314,15 +701,33 @@ bool ht_contains(smb_ht const *table, DATA key)
   return status == SMB_SUCCESS;
 }
 
+/**
+   @brief Return a bucket by iteration index.
+
+   Indices past the end of the table continue into the old table, if there is a
+   resize in progress.
+   @param ht The table.
+   @param i The index.
+ */
+static const smb_ht_bckt *ht_iter_bckt(const smb_ht *ht, long long int i)
+{
+  if (i < ht->allocated) {
+    return &ht->table[i];
+  } else {
+    return &ht->old_table[i - ht->allocated];
+  }
+}
+
 DATA ht_iter_next(smb_iter *iter, smb_status *status)
 {
   *status = SMB_SUCCESS;
   long long int i = iter->state.data_llint + 1;
   const smb_ht *ht = iter->ds;
+  long long int total = ht->allocated + ht->old_allocated;
 
   // Move up until we either run off the table, or find a bucket that contains
   // something.
-  while (i < ht->allocated && ht->table[i].mark != HT_FULL) {
+  while (i < total && ht_iter_bckt(ht, i)->mark != HT_FULL) {
     i++;
   }
 
@@ -330,13 +735,13 @@ DATA ht_iter_next(smb_iter *iter, smb_status *status)
   iter->state.data_llint = i;
 
   // If we hit the end of the table, stop iterating.
-  if (i >= ht->allocated) {
+  if (i >= total) {
     *status = SMB_STOP_ITERATION;
     return LLINT(0);
   } else {
     // Otherwise, return the key we found.
     iter->index++; // count the number of items we've found so far
-    return ht->table[i].key;
+    return ht_iter_bckt(ht, i)->key;
   }
 }
 
@@ -377,15 +782,10 @@ smb_iter ht_get_iter(const smb_ht *ht)
 unsigned int ht_string_hash(DATA data)
 {
   char *theString = (char *)data.data_ptr;
-  unsigned int hash = 0;
-
-  while (theString && *theString != '\0' ) {
-    hash = (hash << 5) - hash + *theString;
-    theString++;
+  if (!theString) {
+    return 0;
   }
-
-  // printf("Hash of \"%s\": %u\n", (char*)data.data_ptr, hash);
-  return hash;
+  return ht_string_hash_len(theString, strlen(theString));
 }
 
 void ht_print(smb_ht const *table, int full_mode)
@@ -395,9 +795,51 @@ void ht_print(smb_ht const *table, int full_mode)
 
   for (i = 0; i < table->allocated; i++) {
     if (full_mode || table->table[i].mark == HT_FULL) {
-      printf("[%04d|%s]: key=0x%llx, value=0x%llx\n", i,
-             MARKS[table->table[i].mark], table->table[i].key.data_llint,
-             table->table[i].value.data_llint);
+      printf("[%04d|%s]: hash=0x%08x, key=0x%llx, value=0x%llx\n", i,
+             MARKS[table->table[i].mark], table->table[i].hash,
+             table->table[i].key.data_llint, table->table[i].value.data_llint);
     }
   }
+  for (i = 0; i < table->old_allocated; i++) {
+    if (full_mode || table->old_table[i].mark == HT_FULL) {
+      printf("[old %04d|%s]: hash=0x%08x, key=0x%llx, value=0x%llx\n", i,
+             MARKS[table->old_table[i].mark], table->old_table[i].hash,
+             table->old_table[i].key.data_llint,
+             table->old_table[i].value.data_llint);
+    }
+  }
+}
+
+void ht_stats(smb_ht const *table, smb_ht_stats *stats, bool scan)
+{
+  unsigned int i;
+
+  memset(stats, 0, sizeof(smb_ht_stats));
+  stats->length = table->length;
+  stats->allocated = table->allocated;
+  stats->old_allocated = table->old_allocated;
+  stats->graves = table->graves;
+  stats->bytes = sizeof(smb_ht) + (table->allocated + table->old_allocated) *
+    sizeof(smb_ht_bckt);
+  stats->load_factor = (double) table->length / (double) table->allocated;
+
+  if (!scan) {
+    return;
+  }
+
+  for (i = 0; i < table->allocated; i++) {
+    if (table->table[i].mark == HT_FULL) {
+      ht_stats_record(stats, ht_probe_length(table->table[i].hash, i,
+                                             table->allocated));
+    }
+  }
+  for (i = 0; i < table->old_allocated; i++) {
+    if (table->old_table[i].mark == HT_FULL) {
+      ht_stats_record(stats, ht_probe_length(table->old_table[i].hash, i,
+                                             table->old_allocated));
+    }
+  }
+  if (table->length > 0) {
+    stats->avg_probe /= table->length;
+  }
 }
@@ -17,8 +17,16 @@
 
 *******************************************************************************/
 
+#include <assert.h>
 #include <string.h>
 #include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "libstephen/ht.h"
 #include "libstephen/hta.h"
@@ -29,9 +37,14 @@
 
 *******************************************************************************/
 
+unsigned int key_offset(const smb_hta *obj)
+{
+  return obj->key_offset;
+}
+
 unsigned int item_size(const smb_hta *obj)
 {
-  return HTA_KEY_OFFSET + obj->key_size + obj->value_size;
+  return obj->slot_size;
 }
 
 unsigned int convert_idx(const smb_hta *obj, unsigned int orig)
@@ -39,29 +52,161 @@ unsigned int convert_idx(const smb_hta *obj, unsigned int orig)
   return orig * item_size(obj);
 }
 
+/**
+   @brief Return the natural alignment for a key or value of a given size.
+
+   This is the largest power of two dividing the size, up to HTA_MAX_ALIGN.
+   @param size The size of the key or value.
+ */
+static unsigned int hta_natural_align(unsigned int size)
+{
+  unsigned int align = 1;
+  if (size == 0) {
+    return 1;
+  }
+  while (align < HTA_MAX_ALIGN && size % (align * 2) == 0) {
+    align *= 2;
+  }
+  return align;
+}
+
+/**
+   @brief Round a size up to a multiple of an alignment (a power of two).
+ */
+static unsigned int hta_round_up(unsigned int size, unsigned int align)
+{
+  return (size + align - 1) & ~(align - 1);
+}
+
+/**
+   @brief Compute the slot layout of a table from its sizes, mode, and whether
+   it's aligned.
+   @param table The table.
+ */
+static void hta_layout(smb_hta *table)
+{
+  unsigned int key_align, value_align;
+
+  if (!table->aligned) {
+    // Swiss mode keeps its marks in the control array, not inline.
+    table->key_offset = table->mode == HTA_SWISS ? 0 : HTA_KEY_OFFSET;
+    table->value_offset = table->key_offset + table->key_size;
+    table->slot_size = table->value_offset + table->value_size;
+    return;
+  }
+
+  // Aligned tables always keep their marks in the control array.
+  key_align = hta_natural_align(table->key_size);
+  value_align = hta_natural_align(table->value_size);
+  table->key_offset = 0;
+  table->value_offset = hta_round_up(table->key_size, value_align);
+  table->slot_size = hta_round_up(table->value_offset + table->value_size,
+                                  key_align > value_align ?
+                                  key_align : value_align);
+}
+
+/**
+   @brief Hash a key for a table, mixing in the table's seed.
+   @param obj The table.
+   @param key The key to hash.
+ */
+static unsigned int hta_hash(const smb_hta *obj, void *key)
+{
+  if (!obj->hash) {
+    return ht_hash_bytes(key, obj->key_size, obj->seed);
+  }
+  return ht_seed_hash(obj->hash(key), obj->seed);
+}
+
+/**
+   @brief Return true if two keys of a table are equal.
+
+   Keys compared bytewise (no comparator, or hta_int_comp() on int keys) are
+   compared inline.  Loads go through memcpy(), which compiles to a single
+   instruction and is safe for misaligned keys.
+   @param obj The table.
+   @param key The key being looked up.
+   @param other A key in the table.
+ */
+static bool hta_key_equal(const smb_hta *obj, void *key, void *other)
+{
+  uint32_t a32, b32;
+  uint64_t a64, b64;
+
+  if (obj->equal && !(obj->equal == &hta_int_comp &&
+                      obj->key_size == sizeof(int))) {
+    return obj->equal(key, other) == 0;
+  }
+
+  switch (obj->key_size) {
+  case 4:
+    memcpy(&a32, key, 4);
+    memcpy(&b32, other, 4);
+    return a32 == b32;
+  case 8:
+    memcpy(&a64, key, 8);
+    memcpy(&b64, other, 8);
+    return a64 == b64;
+  default:
+    return memcmp(key, other, obj->key_size) == 0;
+  }
+}
+
+/**
+   @brief Return a pointer to the mark byte of a slot (except in Swiss mode).
+
+   Marks are inline, unless the table is aligned.
+   @param obj Hash table object.
+   @param index Slot index.
+ */
+static uint8_t *hta_mark(const smb_hta *obj, unsigned int index)
+{
+  if (obj->ctrl) {
+    return obj->ctrl + index;
+  }
+  return (uint8_t*)obj->table + convert_idx(obj, index);
+}
+
+/**
+   @brief Return the key of a slot (in any mode).
+   @param obj Hash table object.
+   @param index Slot index.
+ */
+static void *hta_slot_key(const smb_hta *obj, unsigned int index)
+{
+  return obj->table + convert_idx(obj, index) + key_offset(obj);
+}
+
+/**
+   @brief Return the value of a slot (in any mode).
+   @param obj Hash table object.
+   @param index Slot index.
+ */
+static void *hta_slot_value(const smb_hta *obj, unsigned int index)
+{
+  return obj->table + convert_idx(obj, index) + obj->value_offset;
+}
+
 /**
    @brief Find the proper index for insertion into the table.
+
+   This is the first slot in the probe sequence which is not full.  It should
+   only be called once the key is known not to be present.
    @param obj Hash table object.
-   @param key Key we're inserting.
+   @param hash Hash of the key we're inserting.
  */
-unsigned int hta_find_insert(const smb_hta *obj, void *key)
+unsigned int hta_find_insert(const smb_hta *obj, unsigned int hash)
 {
-  unsigned int index = obj->hash(key) % obj->allocated;
-  unsigned int bufidx = convert_idx(obj, index);
+  unsigned int index = hash & (obj->allocated - 1);
   unsigned int j = 1;
 
-  // Continue searching until we either find a non-full slot, or we find the key
-  // we're trying to insert.
-  // until (cell.mark != full || cell.key == key)
-  // while (cell.mark == full && cell.key != key)
-  while (HTA_MARK(obj, bufidx) == HT_FULL &&
-         obj->equal(key, obj->table + bufidx + HTA_KEY_OFFSET) != 0) {
-    // This is quadratic probing, but I'm avoiding squaring numbers:
-    // j:     1, 3, 5, 7,  9, 11, ..
-    // index: 0, 1, 4, 9, 16, 25, 36
-    index = (index + j) % obj->allocated;
-    j += 2;
-    bufidx = convert_idx(obj, index);
+  while (*hta_mark(obj, index) == HT_FULL) {
+    // This is quadratic probing by triangular numbers, which visits every slot
+    // of a power of two sized table:
+    // j:     1, 2, 3, 4,  5,  6, ..
+    // index: 0, 1, 3, 6, 10, 15, 21
+    index = (index + j) & (obj->allocated - 1);
+    j++;
   }
 
   return index;
@@ -71,58 +216,499 @@ unsigned int hta_find_insert(const smb_hta *obj, void *key)
    @brief Find the proper index for retrieval from the table.
    @param obj Hash table object.
    @param key Key we're looking up.
+   @param hash Hash of the key we're looking up.
  */
-unsigned int hta_find_retrieve(const smb_hta *obj, void *key)
+unsigned int hta_find_retrieve(const smb_hta *obj, void *key, unsigned int hash)
 {
-  unsigned int index = obj->hash(key) % obj->allocated;
-  unsigned int bufidx = convert_idx(obj, index);
+  unsigned int index = hash & (obj->allocated - 1);
   unsigned int j = 1;
 
   // Continue searching until we either find an empty slot, or we find the key
   // we're trying to insert.
   // until (cell.mark == empty || cell.key == key)
   // while (cell.mark != empty && cell.key != key)
-  while (HTA_MARK(obj, bufidx) != HT_EMPTY &&
-         obj->equal(key, obj->table + bufidx + HTA_KEY_OFFSET) != 0) {
-    // This is quadratic probing, but I'm avoiding squaring numbers:
-    // j:     1, 3, 5, 7,  9, 11, ..
-    // index: 0, 1, 4, 9, 16, 25, 36
-    index = (index + j) % obj->allocated;
-    j += 2;
-    bufidx = convert_idx(obj, index);
+  while (*hta_mark(obj, index) != HT_EMPTY &&
+         (*hta_mark(obj, index) != HT_FULL ||
+          !hta_key_equal(obj, key, hta_slot_key(obj, index)))) {
+    // Triangular probing, see hta_find_insert().
+    index = (index + j) & (obj->allocated - 1);
+    j++;
   }
 
   return index;
 }
 
+/*******************************************************************************
+
+                               Swiss Table Mode
+
+*******************************************************************************/
+
+/**
+   @brief Return a bit mask of the bytes in a group equal to a control byte.
+   @param group Pointer to HTA_GROUP_SIZE control bytes.
+   @param byte The control byte to search for.
+   @returns Bit i is set iff group[i] == byte.
+ */
+static unsigned int group_match(const uint8_t *group, uint8_t byte)
+{
+#ifdef __SSE2__
+  __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)byte)));
+#else
+  unsigned int i, mask = 0;
+  for (i = 0; i < HTA_GROUP_SIZE; i++) {
+    if (group[i] == byte) {
+      mask |= 1u << i;
+    }
+  }
+  return mask;
+#endif
+}
+
 /**
-   @brief Expand the hash table, adding increment to the capacity of the table.
+   @brief Return a bit mask of the slots in a group which are empty or graves.
 
-   @param table The table to expand.
+   Both of these control bytes (and no full ones) have their high bit set.
+   @param group Pointer to HTA_GROUP_SIZE control bytes.
+   @returns Bit i is set iff slot i may be inserted into.
  */
-void hta_resize(smb_hta *table)
+static unsigned int group_match_available(const uint8_t *group)
+{
+#ifdef __SSE2__
+  return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#else
+  unsigned int i, mask = 0;
+  for (i = 0; i < HTA_GROUP_SIZE; i++) {
+    if (group[i] & 0x80) {
+      mask |= 1u << i;
+    }
+  }
+  return mask;
+#endif
+}
+
+/**
+   @brief Find the slot containing a key in a Swiss mode table.
+
+   The high bits of the hash (h1) choose a group, and the low seven bits (h2)
+   are stored in the control byte.  The comparator is only called for slots
+   whose control byte matches h2.  Groups are probed by triangular numbers,
+   which visits every group of a power of two sized table.
+   @param obj Hash table object.
+   @param key Key we're looking up.
+   @param hash Hash of the key we're looking up.
+   @returns The slot index, or obj->allocated when the key is not present.
+ */
+static unsigned int hta_swiss_find_retrieve(const smb_hta *obj, void *key,
+                                            unsigned int hash)
 {
-  void *old_table;
-  unsigned int index, old_allocated, bufidx;
+  unsigned int ngroups = obj->allocated / HTA_GROUP_SIZE;
+  unsigned int group = (hash >> 7) & (ngroups - 1);
+  uint8_t h2 = hash & 0x7F;
+  unsigned int j, match, index;
 
-  // Step one: allocate new space for the table
-  old_table = table->table;
-  old_allocated = table->allocated;
-  table->length = 0;
-  table->allocated = ht_next_size(old_allocated);
-  table->table = calloc(table->allocated, item_size(table));
-
-  // Step two, add the old items to the new table.
-  for (index = 0; index < old_allocated; index++) {
-    bufidx = convert_idx(table, index);
-    if (((int8_t*)old_table)[bufidx] == HT_FULL) {
-      hta_insert(table, old_table + bufidx + HTA_KEY_OFFSET,
-                 old_table + bufidx + HTA_KEY_OFFSET + table->value_size);
+  for (j = 1; j <= ngroups; j++) {
+    const uint8_t *ctrl = obj->ctrl + group * HTA_GROUP_SIZE;
+    match = group_match(ctrl, h2);
+    while (match) {
+      index = group * HTA_GROUP_SIZE + __builtin_ctz(match);
+      if (hta_key_equal(obj, key, hta_slot_key(obj, index))) {
+        return index;
+      }
+      match &= match - 1;
+    }
+    // An empty slot means the key was never inserted past this group.
+    if (group_match(ctrl, HTA_CTRL_EMPTY)) {
+      break;
     }
+    group = (group + j) & (ngroups - 1);
   }
+  return obj->allocated;
+}
 
-  // Step three: free old data.
-  smb_free(old_table);
+/**
+   @brief Find the first available slot along a hash's probe sequence.
+
+   This should only be called once the key is known not to be present.  There
+   is always an available slot, since the load factor is kept below one.
+   @param obj Hash table object.
+   @param hash Hash of the key we're inserting.
+ */
+static unsigned int hta_swiss_find_insert(const smb_hta *obj, unsigned int hash)
+{
+  unsigned int ngroups = obj->allocated / HTA_GROUP_SIZE;
+  unsigned int group = (hash >> 7) & (ngroups - 1);
+  unsigned int j = 1, match;
+
+  while (!(match = group_match_available(obj->ctrl + group * HTA_GROUP_SIZE))) {
+    group = (group + j) & (ngroups - 1);
+    j++;
+  }
+  return group * HTA_GROUP_SIZE + __builtin_ctz(match);
+}
+
+/*******************************************************************************
+
+                               Robin Hood Mode
+
+*******************************************************************************/
+
+/**
+   @brief Return the distance of a full slot from its key's home slot.
+   @param obj Hash table object.
+   @param index Slot index (must be full).
+ */
+static unsigned int hta_rh_dist(const smb_hta *obj, unsigned int index)
+{
+  uint8_t mark = *hta_mark(obj, index);
+  if (mark != HTA_RH_DIST_SATURATED) {
+    return mark - 1;
+  }
+  // Only very long probe sequences (i.e. a bad hash function) get here.
+  return (index - hta_hash(obj, hta_slot_key(obj, index))) &
+    (obj->allocated - 1);
+}
+
+/**
+   @brief Set the distance of a slot from its key's home slot.
+   @param obj Hash table object.
+   @param index Slot index.
+   @param dist Distance of the slot's key from its home slot.
+ */
+static void hta_rh_set_dist(const smb_hta *obj, unsigned int index,
+                            unsigned int dist)
+{
+  if (dist >= HTA_RH_DIST_SATURATED - 1) {
+    *hta_mark(obj, index) = HTA_RH_DIST_SATURATED;
+  } else {
+    *hta_mark(obj, index) = dist + 1;
+  }
+}
+
+/**
+   @brief Copy a slot into another one, setting its new distance.
+   @param obj Hash table object.
+   @param dst Destination slot index.
+   @param src Source slot index (must be full).
+   @param dist Distance of dst from the key's home slot.
+ */
+static void hta_rh_move(const smb_hta *obj, unsigned int dst, unsigned int src,
+                        unsigned int dist)
+{
+  memcpy(hta_slot_key(obj, dst), hta_slot_key(obj, src),
+         obj->slot_size - obj->key_offset);
+  hta_rh_set_dist(obj, dst, dist);
+}
+
+/**
+   @brief Find the slot containing a key in a Robin Hood mode table.
+
+   Slots are probed one after another from the key's home slot.  Since an entry
+   is never further from home than the entries after it in the same run, the
+   search stops as soon as it reaches an empty slot, or a slot which is closer
+   to its home than the key would be.
+   @param obj Hash table object.
+   @param key Key we're looking up.
+   @param hash Hash of the key we're looking up.
+   @returns The slot index, or obj->allocated when the key is not present.
+ */
+static unsigned int hta_rh_find_retrieve(const smb_hta *obj, void *key,
+                                         unsigned int hash)
+{
+  unsigned int mask = obj->allocated - 1;
+  unsigned int index = hash & mask;
+  unsigned int dist;
+
+  for (dist = 0; *hta_mark(obj, index) != 0; dist++) {
+    if (hta_rh_dist(obj, index) < dist) {
+      break;
+    }
+    if (hta_key_equal(obj, key, hta_slot_key(obj, index))) {
+      return index;
+    }
+    index = (index + 1) & mask;
+  }
+  return obj->allocated;
+}
+
+/**
+   @brief Find the slot a new key belongs in, and make room for it there.
+
+   The key goes in the first slot which is empty, or whose entry is closer to
+   home than the key would be.  In the second case, that entry and the rest of
+   its run are shifted forward one slot (into the next empty slot).  This
+   should only be called once the key is known not to be present.
+   @param obj Hash table object.
+   @param hash Hash of the key we're inserting.
+   @returns The (now empty) slot index for the key.  Its distance is set.
+ */
+static unsigned int hta_rh_find_insert(const smb_hta *obj, unsigned int hash)
+{
+  unsigned int mask = obj->allocated - 1;
+  unsigned int index = hash & mask;
+  unsigned int dist = 0, empty;
+
+  while (*hta_mark(obj, index) != 0 && hta_rh_dist(obj, index) >= dist) {
+    index = (index + 1) & mask;
+    dist++;
+  }
+
+  if (*hta_mark(obj, index) != 0) {
+    for (empty = index; *hta_mark(obj, empty) != 0;
+         empty = (empty + 1) & mask);
+    // Shift back to front, so that nothing is overwritten before it's moved.
+    for (; empty != index; empty = (empty - 1) & mask) {
+      hta_rh_move(obj, empty, (empty - 1) & mask,
+                  hta_rh_dist(obj, (empty - 1) & mask) + 1);
+    }
+  }
+
+  hta_rh_set_dist(obj, index, dist);
+  return index;
+}
+
+/**
+   @brief Remove an entry from a Robin Hood mode table by shifting the rest of
+   its run back one slot.
+   @param obj Hash table object.
+   @param index Slot to delete (must be full).
+ */
+static void hta_rh_erase(const smb_hta *obj, unsigned int index)
+{
+  unsigned int mask = obj->allocated - 1;
+  unsigned int next = (index + 1) & mask;
+
+  // Entries that are already in their home slot must stay put.
+  while (*hta_mark(obj, next) != 0 && hta_rh_dist(obj, next) != 0) {
+    hta_rh_move(obj, index, next, hta_rh_dist(obj, next) - 1);
+    index = next;
+    next = (next + 1) & mask;
+  }
+  *hta_mark(obj, index) = 0;
+}
+
+/*******************************************************************************
+
+                             Shared Private Functions
+
+*******************************************************************************/
+
+/**
+   @brief Return true if a slot is full (in any mode).
+   @param obj Hash table object.
+   @param index Slot index.
+ */
+static bool hta_slot_full(const smb_hta *obj, unsigned int index)
+{
+  if (obj->mode == HTA_SWISS) {
+    return !(obj->ctrl[index] & 0x80);
+  } else if (obj->mode == HTA_ROBIN_HOOD) {
+    return *hta_mark(obj, index) != 0;
+  }
+  return *hta_mark(obj, index) == HT_FULL;
+}
+
+/**
+   @brief Find the slot containing a key.
+   @param obj Hash table object.
+   @param key Key we're looking up.
+   @param hash Hash of the key we're looking up.
+   @returns The slot index, or obj->allocated when the key is not present.
+ */
+static unsigned int hta_lookup(const smb_hta *obj, void *key, unsigned int hash)
+{
+  unsigned int index;
+  if (obj->mode == HTA_SWISS) {
+    return hta_swiss_find_retrieve(obj, key, hash);
+  } else if (obj->mode == HTA_ROBIN_HOOD) {
+    return hta_rh_find_retrieve(obj, key, hash);
+  }
+  index = hta_find_retrieve(obj, key, hash);
+  return hta_slot_full(obj, index) ? index : obj->allocated;
+}
+
+/**
+   @brief Place a key and value in the first available slot of its probe
+   sequence.  This does not update the length.
+   @param obj Hash table object.
+   @param key Key to insert (not already in the table).
+   @param value Value to insert.
+   @param hash Hash of the key.
+ */
+static void hta_place(smb_hta *obj, void *key, void *value, unsigned int hash)
+{
+  unsigned int index;
+  if (obj->mode == HTA_SWISS) {
+    index = hta_swiss_find_insert(obj, hash);
+    obj->ctrl[index] = hash & 0x7F;
+  } else if (obj->mode == HTA_ROBIN_HOOD) {
+    index = hta_rh_find_insert(obj, hash);
+  } else {
+    index = hta_find_insert(obj, hash);
+    *hta_mark(obj, index) = HT_FULL;
+  }
+  memcpy(hta_slot_key(obj, index), key, obj->key_size);
+  memcpy(hta_slot_value(obj, index), value, obj->value_size);
+}
+
+/**
+   @brief Mark a full slot as deleted.  This does not update the length.
+
+   In Swiss mode, if the slot's group still contains an empty slot, no probe has
+   ever continued past this group, so the slot can be marked empty instead of
+   leaving a grave.  In Robin Hood mode, the following entries move back, so
+   the slot may be full again afterwards.
+   @param obj Hash table object.
+   @param index Slot to delete.
+ */
+static void hta_erase(smb_hta *obj, unsigned int index)
+{
+  uint8_t *group;
+  if (obj->mode == HTA_SWISS) {
+    group = obj->ctrl + (index / HTA_GROUP_SIZE) * HTA_GROUP_SIZE;
+    if (group_match(group, HTA_CTRL_EMPTY)) {
+      obj->ctrl[index] = HTA_CTRL_EMPTY;
+    } else {
+      obj->ctrl[index] = HTA_CTRL_GRAVE;
+    }
+  } else if (obj->mode == HTA_ROBIN_HOOD) {
+    hta_rh_erase(obj, index);
+  } else {
+    // Mark the slot with a "grave stone", indicating it is deleted.
+    *hta_mark(obj, index) = HT_GRAVE;
+  }
+}
+
+/**
+   @brief Return a copy of a table whose storage is the old table of an
+   incremental resize, so the slot functions above may operate on it.
+   @param table The table being resized.
+ */
+static smb_hta hta_old_view(const smb_hta *table)
+{
+  smb_hta old = *table;
+  old.table = table->old_table;
+  old.ctrl = table->old_ctrl;
+  old.allocated = table->old_allocated;
+  return old;
+}
+
+/**
+   @brief Allocate the storage for a table of table->allocated slots.
+   @param table The table to allocate storage for.
+ */
+static void hta_alloc(smb_hta *table)
+{
+  if (table->mode == HTA_SWISS) {
+    table->ctrl = smb_new(uint8_t, table->allocated);
+    memset(table->ctrl, HTA_CTRL_EMPTY, table->allocated);
+    table->table = smb_new(char, table->allocated * item_size(table));
+  } else if (table->aligned) {
+    table->ctrl = calloc(table->allocated, sizeof(uint8_t));
+    table->table = smb_new(char, table->allocated * item_size(table));
+  } else {
+    table->ctrl = NULL;
+    table->table = calloc(table->allocated, item_size(table));
+  }
+}
+
+/**
+   @brief Migrate slots from the old table into the new one.
+
+   Migrated slots are erased from the old table, so that probes for the
+   remaining old entries still work.  The old table is freed once it has been
+   completely drained.
+   @param table The table.
+   @param nslots The maximum number of old slots to visit.
+ */
+static void hta_rehash_step(smb_hta *table, unsigned int nslots)
+{
+  smb_hta old;
+  void *key;
+
+  while (table->old_table && nslots-- > 0) {
+    old = hta_old_view(table);
+    if (hta_slot_full(&old, table->rehash_index)) {
+      key = hta_slot_key(&old, table->rehash_index);
+      hta_place(table, key, hta_slot_value(&old, table->rehash_index),
+                hta_hash(table, key));
+      hta_erase(&old, table->rehash_index);
+    }
+
+    // A Robin Hood erase may shift the next entry into this slot.  Since that
+    // was a migration, it doesn't count as visiting another slot.
+    if (hta_slot_full(&old, table->rehash_index)) {
+      nslots++;
+      continue;
+    }
+    table->rehash_index++;
+    if (table->rehash_index >= table->old_allocated) {
+      smb_free(table->old_table);
+      smb_free(table->old_ctrl);
+      table->old_table = NULL;
+      table->old_ctrl = NULL;
+      table->old_allocated = 0;
+      table->rehash_index = 0;
+    }
+  }
+}
+
+/**
+   @brief Rebuild the hash table with a new capacity.
+
+   The current table becomes the old table, and its entries are migrated
+   immediately, or later on if the table is incremental.
+   @param table The table to rebuild.
+   @param new_size The new number of slots (a power of two).
+ */
+static void hta_rehash(smb_hta *table, unsigned int new_size)
+{
+  // Step one: finish any resize that is still in progress.
+  hta_rehash_step(table, table->old_allocated);
+
+  // Step two: allocate new space for the table.
+  table->old_table = table->table;
+  table->old_ctrl = table->ctrl;
+  table->old_allocated = table->allocated;
+  table->rehash_index = 0;
+  table->allocated = new_size;
+  hta_alloc(table);
+
+  // Step three: move the old items to the new table (and free the old one).
+  if (!table->incremental) {
+    hta_rehash_step(table, table->old_allocated);
+  }
+}
+
+/**
+   @brief Expand the hash table, adding increment to the capacity of the table.
+   @param table The table to expand.
+ */
+void hta_resize(smb_hta *table)
+{
+  hta_rehash(table, ht_next_size(table->allocated));
+}
+
+/**
+   @brief Find the slot containing a key, in either table.
+   @param table The table.
+   @param key Key we're looking up.
+   @param hash Hash of the key we're looking up.
+   @param[out] view Set to the table (or old table view) containing the slot.
+   @returns The slot index, or view->allocated if not found.
+ */
+static unsigned int hta_lookup_any(const smb_hta *table, void *key,
+                                   unsigned int hash, smb_hta *view)
+{
+  unsigned int index;
+  *view = *table;
+  index = hta_lookup(view, key, hash);
+  if (index < view->allocated || !table->old_table) {
+    return index;
+  }
+  *view = hta_old_view(table);
+  return hta_lookup(view, key, hash);
 }
 
 /**
@@ -136,14 +722,129 @@ double hta_load_factor(smb_hta *table)
   return ((double) table->length) / ((double) table->allocated);
 }
 
+/**
+   @brief Return the maximum load factor of a hash table before it expands.
+   @param table The table.
+ */
+static double hta_max_load_factor(const smb_hta *table)
+{
+  if (table->mode == HTA_SWISS) {
+    return HTA_SWISS_MAX_LOAD_FACTOR;
+  } else if (table->mode == HTA_ROBIN_HOOD) {
+    return HTA_ROBIN_HOOD_MAX_LOAD_FACTOR;
+  }
+  return HASH_TABLE_MAX_LOAD_FACTOR;
+}
+
+/**
+   @brief Insert data into the hash table, given the hash of the key.
+   @param table The table.
+   @param key The key to insert.
+   @param value The value to insert at the key.
+   @param hash The hash of the key.
+ */
+static void hta_insert_hashed(smb_hta *table, void *key, void *value,
+                              unsigned int hash)
+{
+  unsigned int index;
+  smb_hta view;
+
+  hta_rehash_step(table, HASH_TABLE_REHASH_STEP);
+  if (hta_load_factor(table) > hta_max_load_factor(table)) {
+    hta_resize(table);
+  }
+
+  // First, probe for the key as if we're trying to return it.  If we find it,
+  // we update the existing key.
+  index = hta_lookup_any(table, key, hash, &view);
+  if (index < view.allocated) {
+    memcpy(hta_slot_value(&view, index), value, table->value_size);
+    return;
+  }
+
+  // If we don't find the key, then we find the first open slot or gravestone.
+  hta_place(table, key, value, hash);
+  table->length++;
+}
+
+/**
+   @brief Start loading the memory a probe for a hash will look at first.
+   @param table The table.
+   @param hash The hash.
+ */
+static void hta_prefetch(const smb_hta *table, unsigned int hash)
+{
+  unsigned int ngroups;
+  if (table->mode == HTA_SWISS) {
+    ngroups = table->allocated / HTA_GROUP_SIZE;
+    __builtin_prefetch(table->ctrl + ((hash >> 7) & (ngroups - 1)) *
+                       HTA_GROUP_SIZE);
+  } else {
+    __builtin_prefetch(hta_slot_key(table, hash & (table->allocated - 1)));
+  }
+}
+
+/**
+   @brief Round a file offset up to a multiple of HTA_IMAGE_ALIGN.
+ */
+static uint64_t hta_image_round(uint64_t offset)
+{
+  return (offset + HTA_IMAGE_ALIGN - 1) & ~(uint64_t)(HTA_IMAGE_ALIGN - 1);
+}
+
+/**
+   @brief Check that an image header is valid, and describes a file of a given
+   size.
+
+   The table must already be filled in from the header, including its layout.
+   Each region is checked against the space left after its offset, rather than
+   by adding up its end, so that offsets near UINT64_MAX can't wrap around.
+   @param header The image header.
+   @param table The table described by the header.
+   @param size The size of the image file.
+ */
+static bool hta_image_valid(const smb_hta_image_header *header,
+                            const smb_hta *table, uint64_t size)
+{
+  uint64_t table_size = (uint64_t) header->allocated * header->slot_size;
+  bool has_ctrl = header->mode == HTA_SWISS || header->aligned;
+
+  if (memcmp(header->magic, HTA_IMAGE_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != HTA_IMAGE_VERSION ||
+      header->byte_order != 0x01020304 ||
+      header->mode > HTA_ROBIN_HOOD) {
+    return false;
+  }
+  // The sizes must be consistent with each other, and with the layout this
+  // version of the library computes.
+  if (header->allocated < HTA_GROUP_SIZE ||
+      (header->allocated & (header->allocated - 1)) != 0 ||
+      header->length > header->allocated ||
+      header->slot_size != table->slot_size) {
+    return false;
+  }
+  if (header->table_offset < sizeof(smb_hta_image_header) ||
+      header->table_offset % HTA_IMAGE_ALIGN != 0 ||
+      header->table_offset > size || table_size > size - header->table_offset) {
+    return false;
+  }
+  if (has_ctrl) {
+    return header->ctrl_offset >= header->table_offset + table_size &&
+      header->ctrl_offset <= size &&
+      header->allocated <= size - header->ctrl_offset;
+  }
+  return header->ctrl_offset == 0;
+}
+
 /*******************************************************************************
 
                            Public Interface Functions
 
 *******************************************************************************/
 
-void hta_init(smb_hta *table, HTA_HASH hash_func, HTA_COMP equal,
-              unsigned int key_size, unsigned int value_size)
+void hta_init_mode(smb_hta *table, HTA_HASH hash_func, HTA_COMP equal,
+                   unsigned int key_size, unsigned int value_size,
+                   smb_hta_mode mode)
 {
   // Initialize values
   table->length = 0;
@@ -152,24 +853,82 @@ void hta_init(smb_hta *table, HTA_HASH hash_func, HTA_COMP equal,
   table->value_size = value_size;
   table->hash = hash_func;
   table->equal = equal;
+  table->mode = mode;
+  table->incremental = false;
+  table->old_table = NULL;
+  table->old_ctrl = NULL;
+  table->old_allocated = 0;
+  table->rehash_index = 0;
+  table->seed = ht_new_seed();
+  table->aligned = false;
+  table->image = NULL;
+  table->image_size = 0;
+  hta_layout(table);
 
   // Allocate table
-  table->table = calloc(HASH_TABLE_INITIAL_SIZE, item_size(table));
+  hta_alloc(table);
 }
 
-smb_hta *hta_create(HTA_HASH hash_func, HTA_COMP equal,
-                    unsigned int key_size, unsigned int value_size)
+void hta_init(smb_hta *table, HTA_HASH hash_func, HTA_COMP equal,
+              unsigned int key_size, unsigned int value_size)
+{
+  hta_init_mode(table, hash_func, equal, key_size, value_size, HTA_QUADRATIC);
+}
+
+smb_hta *hta_create_mode(HTA_HASH hash_func, HTA_COMP equal,
+                         unsigned int key_size, unsigned int value_size,
+                         smb_hta_mode mode)
 {
   // Allocate and create the table.
   smb_hta *table;
   table = smb_new(smb_hta, 1);
-  hta_init(table, hash_func, equal, key_size, value_size);
+  hta_init_mode(table, hash_func, equal, key_size, value_size, mode);
   return table;
 }
 
+smb_hta *hta_create(HTA_HASH hash_func, HTA_COMP equal,
+                    unsigned int key_size, unsigned int value_size)
+{
+  return hta_create_mode(hash_func, equal, key_size, value_size, HTA_QUADRATIC);
+}
+
+void hta_copy(smb_hta *dest, const smb_hta *src)
+{
+  smb_hta old;
+  *dest = *src;
+
+  dest->image = NULL;
+  dest->image_size = 0;
+
+  dest->table = smb_new(char, src->allocated * item_size(src));
+  memcpy(dest->table, src->table, src->allocated * item_size(src));
+  if (src->ctrl) {
+    dest->ctrl = smb_new(uint8_t, src->allocated);
+    memcpy(dest->ctrl, src->ctrl, src->allocated);
+  }
+
+  if (src->old_table) {
+    old = hta_old_view(src);
+    dest->old_table = smb_new(char, old.allocated * item_size(&old));
+    memcpy(dest->old_table, old.table, old.allocated * item_size(&old));
+    if (old.ctrl) {
+      dest->old_ctrl = smb_new(uint8_t, old.allocated);
+      memcpy(dest->old_ctrl, old.ctrl, old.allocated);
+    }
+  }
+}
+
 void hta_destroy(smb_hta *table)
 {
+  if (table->image) {
+    // The storage is in the mapped image (and there's never an old table).
+    munmap(table->image, table->image_size);
+    return;
+  }
   smb_free(table->table);
+  smb_free(table->ctrl);
+  smb_free(table->old_table);
+  smb_free(table->old_ctrl);
 }
 
 void hta_delete(smb_hta *table)
@@ -182,64 +941,121 @@ void hta_delete(smb_hta *table)
   smb_free(table);
 }
 
-void hta_insert(smb_hta *table, void *key, void *value)
+void hta_set_incremental(smb_hta *table, bool incremental)
 {
-  unsigned int index, bufidx;
-  if (hta_load_factor(table) > HASH_TABLE_MAX_LOAD_FACTOR) {
-    hta_resize(table);
+  table->incremental = incremental;
+  if (!incremental) {
+    hta_rehash_step(table, table->old_allocated);
   }
+}
 
-  // First, probe for the key as if we're trying to return it.  If we find it,
-  // we update the existing key.
-  index = hta_find_retrieve(table, key);
-  bufidx = convert_idx(table, index);
-  if (HTA_MARK(table, bufidx) == HT_FULL) {
-    memcpy(table->table + bufidx + HTA_KEY_OFFSET + table->key_size, value,
-           table->value_size);
+void hta_set_aligned(smb_hta *table, bool aligned)
+{
+  smb_hta old;
+  unsigned int i;
+  void *key;
+
+  if (table->aligned == aligned) {
     return;
   }
+  assert(!table->image);
 
-  // If we don't find the key, then we find the first open slot or gravestone.
-  index = hta_find_insert(table, key);
-  bufidx = convert_idx(table, index);
-  HTA_MARK(table, bufidx) = HT_FULL;
-  memcpy(table->table + bufidx + HTA_KEY_OFFSET, key, table->key_size);
-  memcpy(table->table + bufidx + HTA_KEY_OFFSET + table->key_size, value,
-         table->value_size);
-  table->length++;
+  // Move every entry from the old storage into storage with the new layout.
+  hta_rehash_step(table, table->old_allocated);
+  old = *table;
+  table->aligned = aligned;
+  hta_layout(table);
+  hta_alloc(table);
+  for (i = 0; i < old.allocated; i++) {
+    if (hta_slot_full(&old, i)) {
+      key = hta_slot_key(&old, i);
+      hta_place(table, key, hta_slot_value(&old, i), hta_hash(table, key));
+    }
+  }
+  smb_free(old.table);
+  smb_free(old.ctrl);
+}
+
+void hta_insert(smb_hta *table, void *key, void *value)
+{
+  assert(!table->image);
+  hta_insert_hashed(table, key, value, hta_hash(table, key));
+}
+
+void hta_reserve(smb_hta *table, unsigned int n)
+{
+  unsigned int size = table->allocated;
+  assert(!table->image);
+  while (n > size * hta_max_load_factor(table) && size < HASH_TABLE_MAX_SIZE) {
+    size = ht_next_size(size);
+  }
+  if (size > table->allocated) {
+    hta_rehash(table, size);
+  }
+}
+
+void hta_insert_many(smb_hta *table, const void *keys, const void *values,
+                     unsigned int n)
+{
+  unsigned int hashes[HASH_TABLE_BATCH_SIZE];
+  unsigned int i, j, batch;
+  char *key = (char*)keys, *value = (char*)values;
+
+  assert(!table->image);
+  hta_reserve(table, table->length + n);
+
+  for (i = 0; i < n; i += batch) {
+    batch = n - i < HASH_TABLE_BATCH_SIZE ? n - i : HASH_TABLE_BATCH_SIZE;
+    // Hash the whole batch first, and start loading each key's first probe, so
+    // that the cache misses overlap instead of happening one at a time.
+    for (j = 0; j < batch; j++) {
+      hashes[j] = hta_hash(table, key + (i + j) * table->key_size);
+      hta_prefetch(table, hashes[j]);
+    }
+    for (j = 0; j < batch; j++) {
+      hta_insert_hashed(table, key + (i + j) * table->key_size,
+                        value + (i + j) * table->value_size, hashes[j]);
+    }
+  }
 }
 
 void hta_remove(smb_hta *table, void *key, smb_status *status)
 {
   *status = SMB_SUCCESS;
-  unsigned int index = hta_find_retrieve(table, key);
-  unsigned int bufidx = convert_idx(table, index);
+  unsigned int index;
+  smb_hta view;
+
+  if (table->image) {
+    *status = SMB_READ_ONLY_ERROR;
+    return;
+  }
+  hta_rehash_step(table, HASH_TABLE_REHASH_STEP);
+  index = hta_lookup_any(table, key, hta_hash(table, key), &view);
 
-  // If the returned slot isn't full, that means we couldn't find it.
-  if (HTA_MARK(table, bufidx) != HT_FULL) {
+  // If there's no such slot, that means we couldn't find it.
+  if (index >= view.allocated) {
     *status = SMB_NOT_FOUND_ERROR;
     return;
   }
 
-  // Mark the slot with a "grave stone", indicating it is deleted.
-  HTA_MARK(table, bufidx) = HT_GRAVE;
+  hta_erase(&view, index);
   table->length--;
 }
 
 void *hta_get(smb_hta const *table, void *key, smb_status *status)
 {
   *status = SMB_SUCCESS;
-  unsigned int index = hta_find_retrieve(table, key);
-  unsigned int bufidx = convert_idx(table, index);
+  smb_hta view;
+  unsigned int index = hta_lookup_any(table, key, hta_hash(table, key), &view);
 
-  // If the slot is not marked full, we didn't find the key.
-  if (HTA_MARK(table, bufidx) != HT_FULL) {
+  // If there's no such slot, we didn't find the key.
+  if (index >= view.allocated) {
     *status = SMB_NOT_FOUND_ERROR;
     return NULL;
   }
 
   // Otherwise, return the value.
-  return table->table + bufidx + HTA_KEY_OFFSET + table->key_size;
+  return hta_slot_value(&view, index);
 }
 
 bool hta_contains(smb_hta const *table, void *key)
@@ -251,48 +1067,262 @@ bool hta_contains(smb_hta const *table, void *key)
 
 unsigned int hta_string_hash(void *data)
 {
-  char *theString = *(char**)data;
-  unsigned int hash = 0;
-
-  while (theString && *theString != '\0' ) {
-    hash = (hash << 5) - hash + *theString;
-    theString++;
+  char *theString;
+  memcpy(&theString, data, sizeof(char*));
+  if (!theString) {
+    return 0;
   }
+  return ht_string_hash_len(theString, strlen(theString));
+}
 
-  // printf("Hash of \"%s\": %u\n", (char*)data.data_ptr, hash);
-  return hash;
+unsigned int hta_int_hash(void *data)
+{
+  int value;
+  // Keys in a packed table are misaligned, so don't dereference them.
+  memcpy(&value, data, sizeof(int));
+  return ht_int_hash(LLINT(value));
 }
 
 int hta_string_comp(void *left, void *right)
 {
-  char **l = (char**)left, **r = (char**)right;
-  return strcmp(*l,*r);
+  char *l, *r;
+  memcpy(&l, left, sizeof(char*));
+  memcpy(&r, right, sizeof(char*));
+  return strcmp(l, r);
 }
 
 int hta_int_comp(void *left, void *right)
 {
-  int *l = (int*)left, *r = (int*)right;
-  return *l - *r;
+  int l, r;
+  memcpy(&l, left, sizeof(int));
+  memcpy(&r, right, sizeof(int));
+  return l - r;
 }
 
-void hta_print(FILE* f, smb_hta const *table, HTA_PRINT key, HTA_PRINT value,
-               int full_mode)
+/**
+   @brief Print the slots of a table (or old table view).
+ */
+static void hta_print_slots(FILE* f, smb_hta const *table, HTA_PRINT key,
+                            HTA_PRINT value, int full_mode)
 {
   unsigned int i, bufidx;
   char *MARKS[] = {"EMPTY", " FULL", "GRAVE"};
 
   for (i = 0; i < table->allocated; i++) {
     bufidx = convert_idx(table, i);
-    int8_t mark = HTA_MARK(table, bufidx);
+    int8_t mark;
+    if (table->mode == HTA_SWISS) {
+      mark = table->ctrl[i] == HTA_CTRL_EMPTY ? HT_EMPTY :
+        (table->ctrl[i] == HTA_CTRL_GRAVE ? HT_GRAVE : HT_FULL);
+    } else if (table->mode == HTA_ROBIN_HOOD) {
+      mark = hta_slot_full(table, i) ? HT_FULL : HT_EMPTY;
+    } else {
+      mark = *hta_mark(table, i);
+    }
     if (full_mode || mark == HT_FULL) {
-      printf("[%04d|%05d|%s]:\n", i, bufidx, MARKS[mark]);
+      fprintf(f, "[%04d|%05d|%s]:\n", i, bufidx, MARKS[mark]);
       if (mark == HT_FULL) {
-        printf("  key: ");
-        key(f, table->table + bufidx + HTA_KEY_OFFSET);
-        printf("\n  value: ");
-        value(f, table->table + bufidx + HTA_KEY_OFFSET + table->value_size);
-        printf("\n");
+        fprintf(f, "  key: ");
+        key(f, hta_slot_key(table, i));
+        fprintf(f, "\n  value: ");
+        value(f, hta_slot_value(table, i));
+        fprintf(f, "\n");
+      }
+    }
+  }
+}
+
+/**
+   @brief Count the probe lengths (and graves) of a table (or old table view).
+ */
+static void hta_stats_slots(smb_hta const *table, smb_ht_stats *stats,
+                            bool graves)
+{
+  unsigned int i, hash, probe;
+
+  for (i = 0; i < table->allocated; i++) {
+    if (!hta_slot_full(table, i)) {
+      if (graves && (table->mode == HTA_SWISS ?
+                     table->ctrl[i] == HTA_CTRL_GRAVE :
+                     (table->mode == HTA_QUADRATIC &&
+                      *hta_mark(table, i) == HT_GRAVE))) {
+        stats->graves++;
       }
+      continue;
     }
+
+    if (table->mode == HTA_SWISS) {
+      hash = hta_hash(table, hta_slot_key(table, i));
+      probe = ht_probe_length(hash >> 7, i / HTA_GROUP_SIZE,
+                              table->allocated / HTA_GROUP_SIZE);
+    } else if (table->mode == HTA_ROBIN_HOOD) {
+      probe = hta_rh_dist(table, i) + 1;
+    } else {
+      hash = hta_hash(table, hta_slot_key(table, i));
+      probe = ht_probe_length(hash, i, table->allocated);
+    }
+    ht_stats_record(stats, probe);
+  }
+}
+
+void hta_stats(smb_hta const *table, smb_ht_stats *stats, bool scan)
+{
+  smb_hta old;
+
+  memset(stats, 0, sizeof(smb_ht_stats));
+  stats->length = table->length;
+  stats->allocated = table->allocated;
+  stats->old_allocated = table->old_allocated;
+  stats->bytes = sizeof(smb_hta) + table->allocated * item_size(table) +
+    table->old_allocated * item_size(table);
+  if (table->ctrl) {
+    stats->bytes += table->allocated + table->old_allocated;
+  }
+  stats->load_factor = (double) table->length / (double) table->allocated;
+
+  if (!scan) {
+    return;
+  }
+
+  hta_stats_slots(table, stats, true);
+  if (table->old_table) {
+    old = hta_old_view(table);
+    hta_stats_slots(&old, stats, false);
+  }
+  if (table->length > 0) {
+    stats->avg_probe /= table->length;
+  }
+}
+
+void hta_print(FILE* f, smb_hta const *table, HTA_PRINT key, HTA_PRINT value,
+               int full_mode)
+{
+  smb_hta old;
+  hta_print_slots(f, table, key, value, full_mode);
+  if (table->old_table) {
+    fprintf(f, "old table:\n");
+    old = hta_old_view(table);
+    hta_print_slots(f, &old, key, value, full_mode);
+  }
+}
+
+void hta_save(smb_hta const *table, const char *path, smb_status *status)
+{
+  smb_hta copy;
+  smb_hta_image_header header;
+  uint64_t table_bytes;
+  FILE *f;
+  bool ok;
+
+  *status = SMB_SUCCESS;
+
+  // An image holds a single table, so finish any resize in a copy.
+  if (table->old_table) {
+    hta_copy(&copy, table);
+    hta_set_incremental(&copy, false);
+    hta_save(&copy, path, status);
+    hta_destroy(&copy);
+    return;
+  }
+
+  table_bytes = (uint64_t) table->allocated * table->slot_size;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, HTA_IMAGE_MAGIC, sizeof(header.magic));
+  header.version = HTA_IMAGE_VERSION;
+  header.byte_order = 0x01020304;
+  header.mode = table->mode;
+  header.aligned = table->aligned;
+  header.seed = table->seed;
+  header.key_size = table->key_size;
+  header.value_size = table->value_size;
+  header.slot_size = table->slot_size;
+  header.allocated = table->allocated;
+  header.length = table->length;
+  header.table_offset = hta_image_round(sizeof(header));
+  if (table->ctrl) {
+    header.ctrl_offset = hta_image_round(header.table_offset + table_bytes);
+  }
+
+  f = fopen(path, "wb");
+  if (!f) {
+    *status = SMB_IO_ERROR;
+    return;
   }
+  // Seeking past the end of the file pads it with zeros.
+  ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+    fseek(f, header.table_offset, SEEK_SET) == 0 &&
+    fwrite(table->table, 1, table_bytes, f) == table_bytes;
+  if (ok && table->ctrl) {
+    ok = fseek(f, header.ctrl_offset, SEEK_SET) == 0 &&
+      fwrite(table->ctrl, 1, table->allocated, f) == table->allocated;
+  }
+  if (fclose(f) != 0 || !ok) {
+    *status = SMB_IO_ERROR;
+  }
+}
+
+smb_hta *hta_map(const char *path, HTA_HASH hash_func, HTA_COMP equal,
+                 smb_status *status)
+{
+  smb_hta_image_header header;
+  smb_hta *table;
+  struct stat st;
+  void *image;
+  int fd;
+
+  *status = SMB_SUCCESS;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    *status = SMB_IO_ERROR;
+    return NULL;
+  }
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    *status = SMB_IO_ERROR;
+    return NULL;
+  }
+  if ((uint64_t) st.st_size < sizeof(header)) {
+    close(fd);
+    *status = SMB_FORMAT_ERROR;
+    return NULL;
+  }
+  // The mapping stays valid after the file is closed.
+  image = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (image == MAP_FAILED) {
+    *status = SMB_IO_ERROR;
+    return NULL;
+  }
+
+  memcpy(&header, image, sizeof(header));
+  table = smb_new(smb_hta, 1);
+  table->length = header.length;
+  table->allocated = header.allocated;
+  table->key_size = header.key_size;
+  table->value_size = header.value_size;
+  table->hash = hash_func;
+  table->equal = equal;
+  table->mode = header.mode;
+  table->incremental = false;
+  table->old_table = NULL;
+  table->old_ctrl = NULL;
+  table->old_allocated = 0;
+  table->rehash_index = 0;
+  table->seed = header.seed;
+  table->aligned = header.aligned;
+  hta_layout(table);
+
+  if (!hta_image_valid(&header, table, st.st_size)) {
+    munmap(image, st.st_size);
+    smb_free(table);
+    *status = SMB_FORMAT_ERROR;
+    return NULL;
+  }
+
+  table->table = (char*)image + header.table_offset;
+  table->ctrl = header.ctrl_offset ? (uint8_t*)image + header.ctrl_offset : NULL;
+  table->image = image;
+  table->image_size = st.st_size;
+  return table;
 }
@@ -26,12 +26,75 @@
 
 *******************************************************************************/
 
+/**
+   @brief The number of nodes in a pool's first slab.
+ */
+#define SMB_LL_POOL_SLAB 16
+
+/**
+   @brief The most nodes a pool will put in one slab, unless a reservation asks
+   for more.
+ */
+#define SMB_LL_POOL_MAX_SLAB 4096
+
+/**
+   @brief Allocate a slab of n nodes and put them on the pool's free list.
+
+   The nodes go on the list in address order, so a list built from them is
+   traversed in address order too.
+
+   @param pool The pool to add to.
+   @param n The number of nodes.
+ */
+static void ll_pool_grow(smb_ll_pool *pool, int n)
+{
+  smb_ll_node *slab = smb_new(smb_ll_node, n + 1);
+  int i;
+
+  slab[0].next = pool->slabs;
+  pool->slabs = slab;
+  for (i = 1; i < n; i++) {
+    slab[i].next = &slab[i + 1];
+  }
+  slab[n].next = pool->free;
+  pool->free = &slab[1];
+  pool->available += n;
+}
+
+/**
+   @brief Take a node from the pool, growing it if necessary.
+ */
+static smb_ll_node *ll_pool_alloc(smb_ll_pool *pool)
+{
+  smb_ll_node *node;
+  if (!pool->free) {
+    ll_pool_grow(pool, pool->slab_size);
+    if (pool->slab_size < SMB_LL_POOL_MAX_SLAB) {
+      pool->slab_size *= 2;
+    }
+  }
+  node = pool->free;
+  pool->free = node->next;
+  pool->available--;
+  return node;
+}
+
+/**
+   @brief Return a node to the pool.
+ */
+static void ll_pool_free(smb_ll_pool *pool, smb_ll_node *node)
+{
+  node->next = pool->free;
+  pool->free = node;
+  pool->available++;
+}
+
 /**
    @brief Removes the given node, reassigning the links to and from it.
 
-   Frees the node, in addition no reassigning links.  Once this function is
-   called, the_node is invlidated.  Please note that this function *does not*
-   decrement the list's length!
+   Returns the node to the list's pool, in addition to reassigning links.  Once
+   this function is called, the_node is invalidated.  Please note that this
+   function *does not* decrement the list's length!
 
    This function is a *private* function, not declared in libstephen.h for a
    reason.  It is only necessary for the implementation functions within this
@@ -54,23 +117,19 @@ void ll_remove_node(smb_ll *list, smb_ll_node *the_node)
   } else {
     list->tail = previous;
   }
-  smb_free(the_node);
-}
-
-smb_ll_node *ll_node_navigate(smb_ll_node *node, int index)
-{
-  int i = 0;
-  while (i < index) {
-    node = node->next;
-    i++;
+  if (list->finger == the_node) {
+    list->finger = NULL;
   }
-  return node;
+  ll_pool_free(list->pool, the_node);
 }
 
 /**
    @brief Navigates to the given index in the list, returning the correct node,
    or NULL.
 
+   The walk starts from the head, the tail, or the finger, whichever is
+   closest.  This only reads the list; ll_seek() also moves the finger.
+
    This function is a *private* function, not declared in libstephen.h for a
    reason.
 
@@ -84,23 +143,66 @@ smb_ll_node *ll_node_navigate(smb_ll_node *node, int index)
 smb_ll_node * ll_navigate(const smb_ll *list, int index, smb_status *status)
 {
   smb_ll_node *node = list->head;
+  int at = 0, distance = index;
+
   if (index < 0 || index >= list->length) {
     *status = SMB_INDEX_ERROR;
     return NULL;
   }
-  return ll_node_navigate(node, index);
+
+  if (list->length - 1 - index < distance) {
+    node = list->tail;
+    at = list->length - 1;
+    distance = list->length - 1 - index;
+  }
+  if (list->finger && abs(index - list->finger_index) < distance) {
+    node = list->finger;
+    at = list->finger_index;
+  }
+
+  while (at < index) {
+    node = node->next;
+    at++;
+  }
+  while (at > index) {
+    node = node->prev;
+    at--;
+  }
+
+  return node;
 }
 
 /**
-   @brief Allocates and initializes a node with the given data.
+   @brief Navigates to the given index in the list, and makes the node found
+   the list's finger.
+   @param list The list to navigate within.
+   @param index The index to find in the list.
+   @param[out] status Status variable.
+   @returns A pointer to the node navigated to.
+   @retval NULL if the index was out of range.
+   @exception SMB_INDEX_ERROR if the given index was out of range.
+ */
+static smb_ll_node *ll_seek(smb_ll *list, int index, smb_status *status)
+{
+  smb_ll_node *node = ll_navigate(list, index, status);
+  if (node) {
+    list->finger = node;
+    list->finger_index = index;
+  }
+  return node;
+}
 
+/**
+   @brief Takes a node from the list's pool and initializes it with the given
+   data.
+
+   @param list The list the node will belong to.
    @param data The data to insert into the new node.
-   @param[out] status Status variable.
    @return A pointer to the node created.
  */
-smb_ll_node *ll_create_node(DATA data)
+smb_ll_node *ll_create_node(smb_ll *list, DATA data)
 {
-  smb_ll_node *new_node = smb_new(smb_ll_node, 1);
+  smb_ll_node *new_node = ll_pool_alloc(list->pool);
   new_node->data = data;
   new_node->next = NULL;
   new_node->prev = NULL;
@@ -113,25 +215,93 @@ smb_ll_node *ll_create_node(DATA data)
 
 *******************************************************************************/
 
+void ll_pool_init(smb_ll_pool *pool)
+{
+  pool->free = NULL;
+  pool->slabs = NULL;
+  pool->slab_size = SMB_LL_POOL_SLAB;
+  pool->available = 0;
+}
+
+smb_ll_pool *ll_pool_create()
+{
+  smb_ll_pool *pool = smb_new(smb_ll_pool, 1);
+  ll_pool_init(pool);
+  return pool;
+}
+
+void ll_pool_destroy(smb_ll_pool *pool)
+{
+  smb_ll_node *slab = pool->slabs, *next;
+  while (slab) {
+    next = slab->next;
+    smb_free(slab);
+    slab = next;
+  }
+  ll_pool_init(pool);
+}
+
+void ll_pool_delete(smb_ll_pool *pool)
+{
+  ll_pool_destroy(pool);
+  smb_free(pool);
+}
+
+void ll_pool_reserve(smb_ll_pool *pool, int n)
+{
+  if (n > pool->available) {
+    ll_pool_grow(pool, n - pool->available);
+  }
+}
+
 void ll_init(smb_ll *new_list)
+{
+  ll_init_shared(new_list, ll_pool_create());
+  new_list->own_pool = true;
+}
+
+smb_ll *ll_create()
+{
+  smb_ll *new_list = smb_new(smb_ll, 1);
+  ll_init(new_list);
+  return new_list;
+}
+
+void ll_init_shared(smb_ll *new_list, smb_ll_pool *pool)
 {
   new_list->length = 0;
   new_list->head = NULL;
   new_list->tail = NULL;
+  new_list->finger = NULL;
+  new_list->finger_index = 0;
+  new_list->pool = pool;
+  new_list->own_pool = false;
 }
 
-smb_ll *ll_create()
+smb_ll *ll_create_shared(smb_ll_pool *pool)
 {
   smb_ll *new_list = smb_new(smb_ll, 1);
-  ll_init(new_list);
+  ll_init_shared(new_list, pool);
   return new_list;
 }
 
+void ll_reserve(smb_ll *list, int n)
+{
+  ll_pool_reserve(list->pool, n);
+}
+
 void ll_destroy(smb_ll *list)
 {
-  // Iterate through each node, deleting them as we go
   smb_ll_node *iter = list->head;
   smb_ll_node *temp;
+
+  // A pool of our own can be freed all at once.
+  if (list->own_pool) {
+    ll_pool_delete(list->pool);
+    return;
+  }
+
+  // Otherwise, give each node back to the shared pool.
   while (iter) {
     temp = iter->next;
     ll_remove_node(list, iter);
@@ -148,7 +318,7 @@ void ll_delete(smb_ll *list)
 void ll_append(smb_ll *list, DATA new_data)
 {
   // Create the new node
-  smb_ll_node *new_node = ll_create_node(new_data);
+  smb_ll_node *new_node = ll_create_node(list, new_data);
 
   // Get the last node in the list
   smb_ll_node *last_node = list->tail;
@@ -166,7 +336,7 @@ void ll_append(smb_ll *list, DATA new_data)
 void ll_prepend(smb_ll *list, DATA new_data)
 {
   // Create the new smb_ll_node
-  smb_ll_node *new_node = ll_create_node(new_data);
+  smb_ll_node *new_node = ll_create_node(list, new_data);
   smb_ll_node *first_node = list->head;
   new_node->next = first_node;
   if (first_node)
@@ -175,6 +345,9 @@ void ll_prepend(smb_ll *list, DATA new_data)
     list->tail = new_node;
   list->head = new_node;
   list->length++;
+  if (list->finger) {
+    list->finger_index++;
+  }
 }
 
 void ll_push_back(smb_ll *list, DATA new_data)
@@ -222,6 +395,9 @@ DATA ll_pop_front(smb_ll *list, smb_status *status)
     DATA to_return = first_node->data;
     ll_remove_node(list, first_node);
     list->length--;
+    if (list->finger) {
+      list->finger_index--;
+    }
     return to_return;
   } else {
     *status = SMB_INDEX_ERROR; // The list is empty
@@ -241,11 +417,11 @@ DATA ll_peek_front(smb_ll *list, smb_status *status)
   }
 }
 
-DATA ll_get(const smb_ll *list, int index, smb_status *status)
+DATA ll_get(smb_ll *list, int index, smb_status *status)
 {
   *status = SMB_SUCCESS;
   // Navigate to that position in the node.
-  smb_ll_node * the_node = ll_navigate(list, index, status);
+  smb_ll_node * the_node = ll_seek(list, index, status);
   if (*status == SMB_INDEX_ERROR) {
     // Return a dummy value.
     return PTR(NULL);
@@ -257,13 +433,18 @@ DATA ll_get(const smb_ll *list, int index, smb_status *status)
 void ll_remove(smb_ll *list, int index, smb_status *status)
 {
   // Fond the node
-  smb_ll_node *the_node = ll_navigate(list, index, status);
+  smb_ll_node *the_node = ll_seek(list, index, status);
+  smb_ll_node *next;
   if (*status == SMB_INDEX_ERROR) {
     return; // Return the INDEX_ERROR
   }
   // Remove it (managing the links and the list header)
+  next = the_node->next;
   ll_remove_node(list, the_node);
   list->length--;
+  // The next node takes its index, which makes a good finger.
+  list->finger = next;
+  list->finger_index = index;
 }
 
 void ll_insert(smb_ll *list, int index, DATA new_data)
@@ -273,10 +454,10 @@ void ll_insert(smb_ll *list, int index, DATA new_data)
   } else if (index >= list->length) {
     ll_append(list, new_data);
   } else {
-    smb_ll_node *new_node = ll_create_node(new_data);
+    smb_ll_node *new_node = ll_create_node(list, new_data);
 
     smb_status status = SMB_SUCCESS;
-    smb_ll_node *current = ll_navigate(list, index, &status);
+    smb_ll_node *current = ll_seek(list, index, &status);
 
     // Since we already checked indices, there can be no errors.
     assert(status == SMB_SUCCESS);
@@ -286,13 +467,15 @@ void ll_insert(smb_ll *list, int index, DATA new_data)
     new_node->next = current;
     current->prev = new_node;
     list->length++;
+    list->finger = new_node;
+    list->finger_index = index;
   }
 }
 
 void ll_set(smb_ll *list, int index, DATA new_data, smb_status *status)
 {
   *status = SMB_SUCCESS;
-  smb_ll_node *current = ll_navigate(list, index, status);
+  smb_ll_node *current = ll_seek(list, index, status);
   if (current) {
     current->data = new_data;
   } else {
@@ -306,71 +489,112 @@ int ll_length(const smb_ll *list)
 }
 
 /**
-   @brief Recursive mergesort helper function.
-   @param head Pointer to the head pointer (will be updated to reflect new list
-   after sorting).
-   @param length Length of sublist.  Expects the trailing node will not point to
-   the next sublist.
+   @brief Merge two sorted, NULL terminated runs of nodes, linked only through
+   next.  Ties go to the first run, so merging is stable.
+   @param a The earlier run.
+   @param b The later run.
+   @param cmp Comparator.
+   @returns The head of the merged run.
+ */
+static smb_ll_node *ll_sort_merge(smb_ll_node *a, smb_ll_node *b,
+                                  DATA_COMPARE cmp)
+{
+  smb_ll_node head;
+  smb_ll_node *tail = &head;
+  while (a && b) {
+    if (cmp(b->data, a->data) < 0) {
+      tail->next = b;
+      b = b->next;
+    } else {
+      tail->next = a;
+      a = a->next;
+    }
+    tail = tail->next;
+  }
+  tail->next = a ? a : b;
+  return head.next;
+}
+
+/**
+   @brief Cut the next natural run off the front of a chain of nodes.
+
+   A run is either non-descending, or strictly descending, in which case it is
+   reversed.  (Strictly, so that reversing it can't reorder equal items.)
+   @param[in,out] node The first node of the chain.  Set to the first node after
+   the run.
    @param cmp Comparator.
-   @returns The tail of the sorted list!
+   @returns The head of the run, which is now NULL terminated and sorted.
  */
-static smb_ll_node *ll_sort_rec(smb_ll_node **head, int length, DATA_COMPARE cmp)
+static smb_ll_node *ll_sort_run(smb_ll_node **node, DATA_COMPARE cmp)
 {
-  smb_ll_node *left = *head;
-  smb_ll_node *right, *tail, *next;
+  smb_ll_node *head = *node, *tail = head->next, *next, *rev;
 
-  // BASE CASE!
-  if (length <= 1) {
-    return *head;
+  if (!tail) {
+    *node = NULL;
+    return head;
   }
 
-  // Find midpoint and bisect list.
-  right = ll_node_navigate(*head, length/2);
-  right->prev->next = NULL;
-  right->prev = NULL;
-
-  // Sort each sublist.
-  ll_sort_rec(&left, length/2, cmp);
-  ll_sort_rec(&right, length-length/2, cmp);
+  if (cmp(tail->data, head->data) < 0) {
+    // Reverse the descending run as we go.
+    rev = head;
+    head->next = NULL;
+    do {
+      next = tail->next;
+      tail->next = rev;
+      rev = tail;
+      tail = next;
+    } while (tail && cmp(tail->data, rev->data) < 0);
+    *node = tail;
+    return rev;
+  }
 
-  // Pick the first element.
-  if (cmp(left->data, right->data) <= 0) {
-    *head = left;
-    tail = left;
-    left = left->next;
-  } else {
-    *head = right;
-    tail = right;
-    right = right->next;
-  }
-
-  // Merge the remaining elements.
-  while (--length) {
-    if (left == NULL) {
-      next = right;
-      right = right->next;
-    } else if (right == NULL) {
-      next = left;
-      left = left->next;
-    } else if (cmp(left->data, right->data) <= 0) {
-      next = left;
-      left = left->next;
-    } else {
-      next = right;
-      right = right->next;
-    }
-    tail->next = next;
-    next->prev = tail;
-    next->next = NULL;
-    tail = next;
+  while (tail->next && cmp(tail->next->data, tail->data) >= 0) {
+    tail = tail->next;
   }
+  *node = tail->next;
   tail->next = NULL;
-  return tail;
+  return head;
 }
 
-void ll_sort(smb_ll *list, DATA_COMPARE comp)
+void ll_sort(smb_ll *list, DATA_COMPARE cmp)
 {
-  list->tail = ll_sort_rec(&list->head, list->length, comp);
+  // pending[i] is a sorted run made of about 2^i natural runs, or NULL.  Like
+  // a binary counter, adding a run merges equal sized runs upward, so each
+  // item is merged O(log runs) times, and sorted input takes a single pass.
+  smb_ll_node *pending[sizeof(int) * 8 + 1] = {NULL};
+  smb_ll_node *node = list->head, *run, *prev;
+  int i;
+
+  if (!node) {
+    return;
+  }
+
+  while (node) {
+    run = ll_sort_run(&node, cmp);
+    for (i = 0; pending[i]; i++) {
+      run = ll_sort_merge(pending[i], run, cmp);
+      pending[i] = NULL;
+    }
+    pending[i] = run;
+  }
+
+  // Merge what's left, oldest (highest) runs first in each merge.
+  run = NULL;
+  for (i = 0; i < (int) (sizeof(pending) / sizeof(pending[0])); i++) {
+    if (pending[i]) {
+      run = run ? ll_sort_merge(pending[i], run, cmp) : pending[i];
+    }
+  }
+
+  // Only the next pointers were maintained, so fix the prev pointers.
+  list->finger = NULL;
+  list->head = run;
+  prev = NULL;
+  for (node = run; node; node = node->next) {
+    node->prev = prev;
+    prev = node;
+  }
+  list->tail = prev;
 }
 
 int ll_index_of(const smb_ll *list, DATA d, DATA_COMPARE comp)
@@ -482,6 +706,7 @@ smb_iter ll_get_iter(const smb_ll *list)
 void ll_filter(smb_ll *list, bool (*test_function)(DATA))
 {
   smb_ll_node *curr = list->head, *next;
+  list->finger = NULL;
   while (curr) {
     next = curr->next;
     if (test_function(curr->data)) {
@@ -523,133 +748,10 @@ DATA ll_foldr(smb_ll *list, DATA start_value, DATA (*reduction)(DATA,DATA))
 
 /*******************************************************************************
 
-                         Linked List Adapter Functions
-
-  These guys are used as the function pointers for the smb_list.  They really
-  don't need any documentation.
+                                 Generic List
 
 *******************************************************************************/
 
-void ll_append_adapter(smb_list *l, DATA new_data)
-{
-  smb_ll *list = (smb_ll*) (l->data);
-  ll_append(list, new_data);
-}
-
-void ll_prepend_adapter(smb_list *l, DATA new_data)
-{
-  smb_ll *list = (smb_ll*) (l->data);
-  ll_prepend(list, new_data);
-}
-
-DATA ll_get_adapter(const smb_list *l, int index, smb_status *status)
-{
-  const smb_ll *list = (const smb_ll*) (l->data);
-  return ll_get(list, index, status);
-}
-
-void ll_remove_adapter(smb_list *l, int index, smb_status *status)
-{
-  smb_ll *list = (smb_ll*) (l->data);
-  ll_remove(list, index, status);
-}
-
-void ll_insert_adapter(smb_list *l, int index, DATA new_data)
-{
-  smb_ll *list = (smb_ll*) (l->data);
-  ll_insert(list, index, new_data);
-}
-
-void ll_delete_adapter(smb_list *l)
-{
-  smb_ll *list = (smb_ll*) (l->data);
-  ll_delete(list);
-  l->data = NULL;
-}
-
-void ll_set_adapter(smb_list *l, int index, DATA new_data, smb_status *status)
-{
-  smb_ll *list = (smb_ll*) (l->data);
-  ll_set(list, index, new_data, status);
-}
-
-void ll_push_back_adapter(smb_list *l, DATA new_data)
-{
-  smb_ll *list = (smb_ll*) (l->data);
-  ll_push_back(list, new_data);
-}
-
-DATA ll_pop_back_adapter(smb_list *l, smb_status *status)
-{
-  smb_ll *list = (smb_ll*) (l->data);
-  return ll_pop_back(list, status);
-}
-
-DATA ll_peek_back_adapter(smb_list *l, smb_status *status)
-{
-  smb_ll *list = (smb_ll*) (l->data);
-  return ll_peek_back(list, status);
-}
-
-void ll_push_front_adapter(smb_list *l, DATA new_data)
-{
-  smb_ll *list = (smb_ll*) (l->data);
-  ll_push_front(list, new_data);
-}
-
-DATA ll_pop_front_adapter(smb_list *l, smb_status *status)
-{
-  smb_ll *list = (smb_ll*) (l->data);
-  return ll_pop_front(list, status);
-}
-
-DATA ll_peek_front_adapter(smb_list *l, smb_status *status)
-{
-  smb_ll *list = (smb_ll*) (l->data);
-  return ll_peek_front(list, status);
-}
-
-int ll_length_adapter(const smb_list *l)
-{
-  const smb_ll *list = (const smb_ll*) (l->data);
-  return ll_length(list);
-}
-
-int ll_index_of_adapter(const smb_list *l, DATA d, DATA_COMPARE comp)
-{
-  const smb_ll *list = (const smb_ll*) (l->data);
-  return ll_index_of(list, d, comp);
-}
-
-/**
-   @brief Populate a generic smb_list with function pointers necessary to use
-   smb_ll with it.
-
-   Note that this is a *private* function, not defined in libstephen.h for a
-   reason.  You shouldn't need the function, as there is library functionality
-   that provides it for you.
-
-   @param generic_list The smb_list to populate with function pointers.
- */
-void ll_fill_functions(smb_list *generic_list)
-{
-  generic_list->append = ll_append_adapter;
-  generic_list->prepend = ll_prepend_adapter;
-  generic_list->get = ll_get_adapter;
-  generic_list->remove = ll_remove_adapter;
-  generic_list->insert = ll_insert_adapter;
-  generic_list->delete = ll_delete_adapter;
-  generic_list->push_back = ll_push_back_adapter;
-  generic_list->pop_back = ll_pop_back_adapter;
-  generic_list->peek_back = ll_peek_back_adapter;
-  generic_list->push_front = ll_push_front_adapter;
-  generic_list->pop_front = ll_pop_front_adapter;
-  generic_list->peek_front = ll_peek_front_adapter;
-  generic_list->length = ll_length_adapter;
-  generic_list->set = ll_set_adapter;
-  generic_list->index_of = ll_index_of_adapter;
-}
-
 smb_list ll_create_list()
 {
   smb_ll *list = ll_create();
@@ -661,7 +763,7 @@ smb_list ll_cast_to_list(smb_ll *list)
   smb_list generic_list;
   generic_list.data = list;
 
-  ll_fill_functions(&generic_list);
+  generic_list.kind = SMB_LIST_LL;
 
   return generic_list;
 }
@@ -0,0 +1,339 @@
+/***************************************************************************//**
+
+  @file         oht.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Implementation of "libstephen/oht.h".
+
+  @copyright    Copyright (c) 2013-2016, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#include <string.h>
+
+#include "libstephen/oht.h"
+
+/*******************************************************************************
+
+                               Private Functions
+
+*******************************************************************************/
+
+/**
+   @brief Return the number of entries there is room for with a given number of
+   index slots.
+
+   Since every used entry (even a removed one) may occupy an index slot, this
+   also keeps the index load factor at or below HASH_TABLE_MAX_LOAD_FACTOR.
+   @param allocated Number of index slots.
+ */
+static unsigned int oht_capacity(unsigned int allocated)
+{
+  return (unsigned int) (allocated * HASH_TABLE_MAX_LOAD_FACTOR);
+}
+
+/**
+   @brief Hash a key for a table, mixing in the table's seed.
+   @param table The table.
+   @param key The key to hash.
+ */
+static unsigned int oht_hash(const smb_oht *table, DATA key)
+{
+  return ht_seed_hash(table->hash(key), table->seed);
+}
+
+/**
+   @brief Find the index slot referring to a key.
+   @param table The table.
+   @param key Key we're looking up.
+   @param hash Hash of the key.
+   @returns The index slot, or table->allocated when the key is not present.
+ */
+static unsigned int oht_lookup(const smb_oht *table, DATA key,
+                               unsigned int hash)
+{
+  unsigned int mask = table->allocated - 1;
+  unsigned int slot = hash & mask;
+  unsigned int j = 1;
+  const smb_ht_bckt *entry;
+
+  while (table->index[slot] != OHT_EMPTY) {
+    if (table->index[slot] >= 0) {
+      entry = &table->entries[table->index[slot]];
+      if (entry->hash == hash && table->equal(key, entry->key) == 0) {
+        return slot;
+      }
+    }
+    // Triangular probing, as in smb_ht.
+    slot = (slot + j) & mask;
+    j++;
+  }
+  return table->allocated;
+}
+
+/**
+   @brief Find the first index slot along a hash's probe sequence which doesn't
+   refer to an entry.
+   @param table The table.
+   @param hash Hash of the key being inserted (not already present).
+ */
+static unsigned int oht_find_insert(const smb_oht *table, unsigned int hash)
+{
+  unsigned int mask = table->allocated - 1;
+  unsigned int slot = hash & mask;
+  unsigned int j = 1;
+
+  while (table->index[slot] >= 0) {
+    slot = (slot + j) & mask;
+    j++;
+  }
+  return slot;
+}
+
+/**
+   @brief Rebuild the table with a new number of index slots.
+
+   Removed entries are squeezed out of the entry array (keeping the order of
+   the rest), and the index is rebuilt from the cached hashes.  This takes time
+   proportional to the number of entries, plus clearing the new index.
+   @param table The table.
+   @param new_size The new number of index slots (a power of two, with room for
+   every entry).
+ */
+static void oht_rebuild(smb_oht *table, unsigned int new_size)
+{
+  unsigned int i, n = 0;
+
+  for (i = 0; i < table->nentries; i++) {
+    if (table->entries[i].mark == HT_FULL) {
+      table->entries[n++] = table->entries[i];
+    }
+  }
+  table->nentries = n;
+  table->entries = smb_renew(smb_ht_bckt, table->entries,
+                             oht_capacity(new_size));
+
+  smb_free(table->index);
+  table->allocated = new_size;
+  table->index = smb_new(int, new_size);
+  memset(table->index, 0xFF, new_size * sizeof(int)); // all OHT_EMPTY
+  for (i = 0; i < n; i++) {
+    table->index[oht_find_insert(table, table->entries[i].hash)] = i;
+  }
+}
+
+/*******************************************************************************
+
+                           Public Interface Functions
+
+*******************************************************************************/
+
+void oht_init(smb_oht *table, HASH_FUNCTION hash_func, DATA_COMPARE equal)
+{
+  table->length = 0;
+  table->allocated = HASH_TABLE_INITIAL_SIZE;
+  table->nentries = 0;
+  table->hash = hash_func;
+  table->equal = equal;
+  table->seed = ht_new_seed();
+  table->index = smb_new(int, HASH_TABLE_INITIAL_SIZE);
+  memset(table->index, 0xFF, HASH_TABLE_INITIAL_SIZE * sizeof(int));
+  table->entries = smb_new(smb_ht_bckt, oht_capacity(HASH_TABLE_INITIAL_SIZE));
+}
+
+smb_oht *oht_create(HASH_FUNCTION hash_func, DATA_COMPARE equal)
+{
+  smb_oht *table = smb_new(smb_oht, 1);
+  oht_init(table, hash_func, equal);
+  return table;
+}
+
+void oht_destroy_act(smb_oht *table, DATA_ACTION deleter)
+{
+  unsigned int i;
+
+  if (deleter) {
+    for (i = 0; i < table->nentries; i++) {
+      if (table->entries[i].mark == HT_FULL) {
+        deleter(table->entries[i].value);
+      }
+    }
+  }
+  smb_free(table->index);
+  smb_free(table->entries);
+}
+
+void oht_destroy(smb_oht *table)
+{
+  oht_destroy_act(table, NULL);
+}
+
+void oht_delete_act(smb_oht *table, DATA_ACTION deleter)
+{
+  if (!table) {
+    return;
+  }
+
+  oht_destroy_act(table, deleter);
+  smb_free(table);
+}
+
+void oht_delete(smb_oht *table)
+{
+  oht_delete_act(table, NULL);
+}
+
+void oht_insert(smb_oht *table, DATA key, DATA value)
+{
+  unsigned int hash = oht_hash(table, key);
+  unsigned int slot = oht_lookup(table, key, hash);
+  unsigned int size;
+  smb_ht_bckt *entry;
+
+  if (slot < table->allocated) {
+    table->entries[table->index[slot]].value = value;
+    return;
+  }
+
+  // When the entry array is full, rebuild.  This may only squeeze out removed
+  // entries, or it may grow the table.  Either way, at least half the entries
+  // are left free, so rebuilds don't happen on every insert.
+  if (table->nentries >= oht_capacity(table->allocated)) {
+    size = table->allocated;
+    while (table->length + 1 > oht_capacity(size) / 2 &&
+           size < HASH_TABLE_MAX_SIZE) {
+      size = ht_next_size(size);
+    }
+    oht_rebuild(table, size);
+  }
+
+  table->index[oht_find_insert(table, hash)] = table->nentries;
+  entry = &table->entries[table->nentries++];
+  entry->key = key;
+  entry->value = value;
+  entry->hash = hash;
+  entry->mark = HT_FULL;
+  table->length++;
+}
+
+void oht_reserve(smb_oht *table, unsigned int n)
+{
+  unsigned int size = table->allocated;
+  while (n > oht_capacity(size) && size < HASH_TABLE_MAX_SIZE) {
+    size = ht_next_size(size);
+  }
+  if (size > table->allocated) {
+    oht_rebuild(table, size);
+  }
+}
+
+void oht_remove_act(smb_oht *table, DATA key, DATA_ACTION deleter,
+                    smb_status *status)
+{
+  unsigned int slot, size;
+  *status = SMB_SUCCESS;
+
+  slot = oht_lookup(table, key, oht_hash(table, key));
+  if (slot >= table->allocated) {
+    *status = SMB_NOT_FOUND_ERROR;
+    return;
+  }
+
+  if (deleter) {
+    deleter(table->entries[table->index[slot]].value);
+  }
+  table->entries[table->index[slot]].mark = HT_GRAVE;
+  table->index[slot] = OHT_DELETED;
+  table->length--;
+
+  // Shrink a sparse table.  This also bounds the number of removed entries
+  // that iteration has to skip to a multiple of the length.
+  size = table->allocated;
+  while (size > HASH_TABLE_INITIAL_SIZE &&
+         table->length < size * HASH_TABLE_MIN_LOAD_FACTOR) {
+    size /= 2;
+  }
+  if (size < table->allocated) {
+    oht_rebuild(table, size);
+  }
+}
+
+void oht_remove(smb_oht *table, DATA key, smb_status *status)
+{
+  oht_remove_act(table, key, NULL, status);
+}
+
+DATA oht_get(smb_oht const *table, DATA key, smb_status *status)
+{
+  unsigned int slot = oht_lookup(table, key, oht_hash(table, key));
+  *status = SMB_SUCCESS;
+
+  if (slot >= table->allocated) {
+    *status = SMB_NOT_FOUND_ERROR;
+    return PTR(NULL);
+  }
+  return table->entries[table->index[slot]].value;
+}
+
+bool oht_contains(smb_oht const *table, DATA key)
+{
+  return oht_lookup(table, key, oht_hash(table, key)) < table->allocated;
+}
+
+DATA oht_iter_next(smb_iter *iter, smb_status *status)
+{
+  *status = SMB_SUCCESS;
+  long long int i = iter->state.data_llint + 1;
+  const smb_oht *table = iter->ds;
+
+  // Skip removed entries.
+  while (i < table->nentries && table->entries[i].mark != HT_FULL) {
+    i++;
+  }
+  iter->state.data_llint = i;
+
+  if (i >= table->nentries) {
+    *status = SMB_STOP_ITERATION;
+    return LLINT(0);
+  }
+  iter->index++;
+  return table->entries[i].key;
+}
+
+bool oht_iter_has_next(smb_iter *iter)
+{
+  const smb_oht *table = iter->ds;
+  return iter->index < (int)table->length;
+}
+
+void oht_iter_destroy(smb_iter *iter)
+{
+  (void)iter; //unused
+}
+
+void oht_iter_delete(smb_iter *iter)
+{
+  oht_iter_destroy(iter);
+  free(iter);
+}
+
+smb_iter oht_get_iter(const smb_oht *table)
+{
+  smb_iter iter = {
+    // Data:
+    .ds = table,        // A reference to the data structure.
+    .state = LLINT(-1), // This tracks the position in the entry array.
+    .index = 0,         // This tracks how many keys have been returned.
+
+    // Functions
+    .next = &oht_iter_next,
+    .has_next = &oht_iter_has_next,
+    .destroy = &oht_iter_destroy,
+    .delete = &oht_iter_delete
+  };
+  return iter;
+}
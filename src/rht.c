@@ -0,0 +1,222 @@
+/***************************************************************************//**
+
+  @file         rht.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Implementation of "libstephen/rht.h".
+
+  @copyright    Copyright (c) 2013-2016, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#include <pthread.h>
+#include <string.h>
+
+#include "libstephen/rht.h"
+
+/*******************************************************************************
+
+                               Private Functions
+
+*******************************************************************************/
+
+/**
+   @brief Free retired snapshots that no reader can be using.
+
+   A reader which announced epoch e may be using any snapshot retired in epoch
+   e or later.  So, a snapshot retired in epoch t may be freed once every
+   reader is either idle or announced an epoch after t.  Must be called with
+   the lock held.
+   @param rht The table.
+ */
+static void rht_reclaim_locked(smb_rht *rht)
+{
+  smb_rht_reader *reader;
+  smb_rht_retired **link = &rht->retired, *retired;
+  unsigned long oldest = __atomic_load_n(&rht->epoch, __ATOMIC_SEQ_CST);
+  unsigned long epoch;
+
+  for (reader = rht->readers; reader; reader = reader->next) {
+    epoch = __atomic_load_n(&reader->epoch, __ATOMIC_SEQ_CST);
+    if (epoch != 0 && epoch < oldest) {
+      oldest = epoch;
+    }
+  }
+
+  while (*link) {
+    retired = *link;
+    if (retired->epoch < oldest) {
+      *link = retired->next;
+      hta_delete(retired->table);
+      smb_free(retired);
+    } else {
+      link = &retired->next;
+    }
+  }
+}
+
+/*******************************************************************************
+
+                           Public Interface Functions
+
+*******************************************************************************/
+
+void rht_init(smb_rht *rht, HTA_HASH hash_func, HTA_COMP equal,
+              unsigned int key_size, unsigned int value_size,
+              smb_hta_mode mode)
+{
+  rht->current = hta_create_mode(hash_func, equal, key_size, value_size, mode);
+  rht->epoch = 1; // zero means "not reading"
+  pthread_mutex_init(&rht->lock, NULL);
+  rht->readers = NULL;
+  rht->retired = NULL;
+}
+
+smb_rht *rht_create(HTA_HASH hash_func, HTA_COMP equal,
+                    unsigned int key_size, unsigned int value_size,
+                    smb_hta_mode mode)
+{
+  smb_rht *rht = smb_new(smb_rht, 1);
+  rht_init(rht, hash_func, equal, key_size, value_size, mode);
+  return rht;
+}
+
+void rht_destroy(smb_rht *rht)
+{
+  smb_rht_reader *reader, *next_reader;
+  smb_rht_retired *retired, *next_retired;
+
+  for (reader = rht->readers; reader; reader = next_reader) {
+    next_reader = reader->next;
+    smb_free(reader);
+  }
+  for (retired = rht->retired; retired; retired = next_retired) {
+    next_retired = retired->next;
+    hta_delete(retired->table);
+    smb_free(retired);
+  }
+  hta_delete(rht->current);
+  pthread_mutex_destroy(&rht->lock);
+}
+
+void rht_delete(smb_rht *rht)
+{
+  if (!rht) {
+    return;
+  }
+
+  rht_destroy(rht);
+  smb_free(rht);
+}
+
+smb_rht_reader *rht_reader_create(smb_rht *rht)
+{
+  smb_rht_reader *reader = smb_new(smb_rht_reader, 1);
+  reader->epoch = 0;
+  pthread_mutex_lock(&rht->lock);
+  reader->next = rht->readers;
+  rht->readers = reader;
+  pthread_mutex_unlock(&rht->lock);
+  return reader;
+}
+
+void rht_reader_delete(smb_rht *rht, smb_rht_reader *reader)
+{
+  smb_rht_reader **link;
+  pthread_mutex_lock(&rht->lock);
+  for (link = &rht->readers; *link; link = &(*link)->next) {
+    if (*link == reader) {
+      *link = reader->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&rht->lock);
+  smb_free(reader);
+}
+
+const smb_hta *rht_read_begin(smb_rht *rht, smb_rht_reader *reader)
+{
+  // The epoch must be announced before the snapshot is loaded.  Then, either a
+  // writer sees the announcement and keeps the snapshot, or the snapshot was
+  // replaced before the announcement and we load the replacement.
+  unsigned long epoch = __atomic_load_n(&rht->epoch, __ATOMIC_SEQ_CST);
+  __atomic_store_n(&reader->epoch, epoch, __ATOMIC_SEQ_CST);
+  return __atomic_load_n(&rht->current, __ATOMIC_SEQ_CST);
+}
+
+void rht_read_end(smb_rht *rht, smb_rht_reader *reader)
+{
+  (void) rht; // unused
+  __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+}
+
+void rht_get(smb_rht *rht, smb_rht_reader *reader, void *key, void *value,
+             smb_status *status)
+{
+  const smb_hta *table = rht_read_begin(rht, reader);
+  void *found = hta_get(table, key, status);
+  if (*status == SMB_SUCCESS) {
+    memcpy(value, found, table->value_size);
+  }
+  rht_read_end(rht, reader);
+}
+
+smb_hta *rht_write_begin(smb_rht *rht)
+{
+  smb_hta *copy = smb_new(smb_hta, 1);
+  pthread_mutex_lock(&rht->lock);
+  hta_copy(copy, rht->current);
+  return copy;
+}
+
+void rht_write_commit(smb_rht *rht, smb_hta *copy)
+{
+  smb_rht_retired *retired = smb_new(smb_rht_retired, 1);
+
+  // Publish the copy, then retire the old snapshot in the current epoch, and
+  // start a new epoch.  Readers which start from here on can't see the old
+  // snapshot.
+  retired->table = rht->current;
+  __atomic_store_n(&rht->current, copy, __ATOMIC_SEQ_CST);
+  retired->epoch = __atomic_fetch_add(&rht->epoch, 1, __ATOMIC_SEQ_CST);
+  retired->next = rht->retired;
+  rht->retired = retired;
+
+  rht_reclaim_locked(rht);
+  pthread_mutex_unlock(&rht->lock);
+}
+
+void rht_write_abort(smb_rht *rht, smb_hta *copy)
+{
+  pthread_mutex_unlock(&rht->lock);
+  hta_delete(copy);
+}
+
+void rht_insert(smb_rht *rht, void *key, void *value)
+{
+  smb_hta *copy = rht_write_begin(rht);
+  hta_insert(copy, key, value);
+  rht_write_commit(rht, copy);
+}
+
+void rht_remove(smb_rht *rht, void *key, smb_status *status)
+{
+  smb_hta *copy = rht_write_begin(rht);
+  hta_remove(copy, key, status);
+  if (*status == SMB_SUCCESS) {
+    rht_write_commit(rht, copy);
+  } else {
+    rht_write_abort(rht, copy);
+  }
+}
+
+void rht_reclaim(smb_rht *rht)
+{
+  pthread_mutex_lock(&rht->lock);
+  rht_reclaim_locked(rht);
+  pthread_mutex_unlock(&rht->lock);
+}
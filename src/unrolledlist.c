@@ -0,0 +1,425 @@
+/***************************************************************************//**
+
+  @file         unrolledlist.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Implementation of "libstephen/ul.h".
+
+  @copyright    Copyright (c) 2013-2016, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#include <string.h>      /* memmove   */
+
+#include "libstephen/ul.h"
+
+/*******************************************************************************
+
+                               Private Functions
+
+*******************************************************************************/
+
+/**
+   @brief Allocate an empty node and link it into the list after a node.
+   @param list The list.
+   @param after The node to link after, or NULL to make it the head.
+   @returns The new node.
+ */
+static smb_ul_node *ul_link_node(smb_ul *list, smb_ul_node *after)
+{
+  smb_ul_node *node = smb_new(smb_ul_node, 1);
+  node->count = 0;
+  node->prev = after;
+  if (after) {
+    node->next = after->next;
+    after->next = node;
+  } else {
+    node->next = list->head;
+    list->head = node;
+  }
+  if (node->next) {
+    node->next->prev = node;
+  } else {
+    list->tail = node;
+  }
+  return node;
+}
+
+/**
+   @brief Unlink a node from the list, and free it.
+ */
+static void ul_unlink_node(smb_ul *list, smb_ul_node *node)
+{
+  if (node->prev) {
+    node->prev->next = node->next;
+  } else {
+    list->head = node->next;
+  }
+  if (node->next) {
+    node->next->prev = node->prev;
+  } else {
+    list->tail = node->prev;
+  }
+  smb_free(node);
+}
+
+/**
+   @brief Find the node containing an index, walking from the closer end.
+
+   Precondition is that index is within range.
+   @param list The list.
+   @param index The index to find.
+   @param[out] offset The index's position within the node.
+   @returns The node containing the index.
+ */
+static smb_ul_node *ul_find(const smb_ul *list, int index, int *offset)
+{
+  smb_ul_node *node;
+  int remaining;
+  if (index < list->length / 2) {
+    node = list->head;
+    while (index >= node->count) {
+      index -= node->count;
+      node = node->next;
+    }
+    *offset = index;
+  } else {
+    // Count items back from the end instead.
+    node = list->tail;
+    remaining = list->length - index;
+    while (remaining > node->count) {
+      remaining -= node->count;
+      node = node->prev;
+    }
+    *offset = node->count - remaining;
+  }
+  return node;
+}
+
+/**
+   @brief Merge node's next neighbor into node, if they fit in one node.
+   @returns True if they were merged.
+ */
+static bool ul_merge_next(smb_ul *list, smb_ul_node *node)
+{
+  smb_ul_node *next = node->next;
+  if (!next || node->count + next->count > (long) SMB_UL_NODE_ITEMS) {
+    return false;
+  }
+  memcpy(node->data + node->count, next->data, next->count * sizeof(DATA));
+  node->count += next->count;
+  ul_unlink_node(list, next);
+  return true;
+}
+
+/**
+   @brief Iterator next function: return the next item.
+ */
+DATA ul_iter_next(smb_iter *iter, smb_status *status)
+{
+  const smb_ul_node *node = iter->ds;
+  DATA d;
+  *status = SMB_SUCCESS;
+  if (node && iter->state.data_llint >= node->count) {
+    node = node->next;
+    iter->ds = node;
+    iter->state.data_llint = 0;
+  }
+  if (!node) {
+    *status = SMB_STOP_ITERATION;
+    return PTR(NULL);
+  }
+  d = node->data[iter->state.data_llint++];
+  iter->index++;
+  return d;
+}
+
+/**
+   @brief Iterator has_next function: return whether there is another item.
+ */
+bool ul_iter_has_next(smb_iter *iter)
+{
+  const smb_ul_node *node = iter->ds;
+  // Nodes are never empty, so any node after this one has an item.
+  return node && (iter->state.data_llint < node->count || node->next);
+}
+
+/**
+   @brief Iterator destroy function: nothing to do.
+ */
+void ul_iter_destroy(smb_iter *iter)
+{
+  (void)iter; // unused
+}
+
+/**
+   @brief Iterator delete function: free the iterator.
+ */
+void ul_iter_delete(smb_iter *iter)
+{
+  iter->destroy(iter);
+  smb_free(iter);
+}
+
+/*******************************************************************************
+
+                          Public Interface Functions
+
+*******************************************************************************/
+
+void ul_init(smb_ul *list)
+{
+  list->head = NULL;
+  list->tail = NULL;
+  list->length = 0;
+}
+
+smb_ul *ul_create()
+{
+  smb_ul *list = smb_new(smb_ul, 1);
+  ul_init(list);
+  return list;
+}
+
+void ul_destroy(smb_ul *list)
+{
+  smb_ul_node *node = list->head, *next;
+  while (node) {
+    next = node->next;
+    smb_free(node);
+    node = next;
+  }
+  ul_init(list);
+}
+
+void ul_delete(smb_ul *list)
+{
+  ul_destroy(list);
+  smb_free(list);
+}
+
+void ul_append(smb_ul *list, DATA newData)
+{
+  smb_ul_node *node = list->tail;
+  if (!node || node->count == (long) SMB_UL_NODE_ITEMS) {
+    node = ul_link_node(list, node);
+  }
+  node->data[node->count++] = newData;
+  list->length++;
+}
+
+void ul_prepend(smb_ul *list, DATA newData)
+{
+  ul_insert(list, 0, newData);
+}
+
+DATA ul_get(const smb_ul *list, int index, smb_status *status)
+{
+  smb_ul_node *node;
+  int offset;
+  *status = SMB_SUCCESS;
+  if (index < 0 || index >= list->length) {
+    *status = SMB_INDEX_ERROR;
+    return PTR(NULL);
+  }
+  node = ul_find(list, index, &offset);
+  return node->data[offset];
+}
+
+void ul_remove(smb_ul *list, int index, smb_status *status)
+{
+  smb_ul_node *node;
+  int offset;
+  *status = SMB_SUCCESS;
+  if (index < 0 || index >= list->length) {
+    *status = SMB_INDEX_ERROR;
+    return;
+  }
+
+  node = ul_find(list, index, &offset);
+  memmove(node->data + offset, node->data + offset + 1,
+          (node->count - offset - 1) * sizeof(DATA));
+  node->count--;
+  list->length--;
+
+  if (node->count == 0) {
+    ul_unlink_node(list, node);
+  } else if (!ul_merge_next(list, node) && node->prev) {
+    ul_merge_next(list, node->prev);
+  }
+}
+
+void ul_insert(smb_ul *list, int index, DATA newData)
+{
+  smb_ul_node *node, *split;
+  int offset, half;
+
+  if (index < 0) {
+    index = 0;
+  }
+  if (index >= list->length) {
+    ul_append(list, newData);
+    return;
+  }
+
+  node = ul_find(list, index, &offset);
+  if (offset == 0 && node->prev &&
+      node->prev->count < (long) SMB_UL_NODE_ITEMS) {
+    // The end of the previous node is the same position, and has room.
+    node = node->prev;
+    offset = node->count;
+  } else if (node->count == (long) SMB_UL_NODE_ITEMS) {
+    if (offset == 0) {
+      // Start a new node before this one, so repeated prepends fill it.
+      node = ul_link_node(list, node->prev);
+    } else {
+      // Move the top half of the node into a new one after it.
+      half = SMB_UL_NODE_ITEMS / 2;
+      split = ul_link_node(list, node);
+      memcpy(split->data, node->data + half,
+             (node->count - half) * sizeof(DATA));
+      split->count = node->count - half;
+      node->count = half;
+      if (offset > half) {
+        node = split;
+        offset -= half;
+      }
+    }
+  }
+
+  memmove(node->data + offset + 1, node->data + offset,
+          (node->count - offset) * sizeof(DATA));
+  node->data[offset] = newData;
+  node->count++;
+  list->length++;
+}
+
+void ul_set(smb_ul *list, int index, DATA newData, smb_status *status)
+{
+  smb_ul_node *node;
+  int offset;
+  *status = SMB_SUCCESS;
+  if (index < 0 || index >= list->length) {
+    *status = SMB_INDEX_ERROR;
+    return;
+  }
+  node = ul_find(list, index, &offset);
+  node->data[offset] = newData;
+}
+
+void ul_push_back(smb_ul *list, DATA newData)
+{
+  ul_append(list, newData);
+}
+
+DATA ul_pop_back(smb_ul *list, smb_status *status)
+{
+  DATA d = ul_peek_back(list, status);
+  if (*status == SMB_SUCCESS) {
+    ul_remove(list, list->length - 1, status);
+  }
+  return d;
+}
+
+DATA ul_peek_back(smb_ul *list, smb_status *status)
+{
+  *status = SMB_SUCCESS;
+  if (!list->tail) {
+    *status = SMB_INDEX_ERROR;
+    return PTR(NULL);
+  }
+  return list->tail->data[list->tail->count - 1];
+}
+
+void ul_push_front(smb_ul *list, DATA newData)
+{
+  ul_prepend(list, newData);
+}
+
+DATA ul_pop_front(smb_ul *list, smb_status *status)
+{
+  DATA d = ul_peek_front(list, status);
+  if (*status == SMB_SUCCESS) {
+    ul_remove(list, 0, status);
+  }
+  return d;
+}
+
+DATA ul_peek_front(smb_ul *list, smb_status *status)
+{
+  *status = SMB_SUCCESS;
+  if (!list->head) {
+    *status = SMB_INDEX_ERROR;
+    return PTR(NULL);
+  }
+  return list->head->data[0];
+}
+
+int ul_length(const smb_ul *list)
+{
+  return list->length;
+}
+
+int ul_index_of(const smb_ul *list, DATA d, DATA_COMPARE comp)
+{
+  const smb_ul_node *node;
+  int i, base = 0;
+  for (node = list->head; node; node = node->next) {
+    for (i = 0; i < node->count; i++) {
+      if (comp == NULL) {
+        if (node->data[i].data_llint == d.data_llint) {
+          return base + i;
+        }
+      } else if (comp(node->data[i], d) == 0) {
+        return base + i;
+      }
+    }
+    base += node->count;
+  }
+  return -1;
+}
+
+smb_iter ul_get_iter(const smb_ul *list)
+{
+  // The iterator keeps its current node in ds, and its position within that
+  // node in state.
+  smb_iter iter = {
+    // Data values
+    .ds = list->head,
+    .state = (DATA) { .data_llint = 0 },
+    .index = 0,
+
+    // Functions
+    .next = &ul_iter_next,
+    .has_next = &ul_iter_has_next,
+    .destroy = &ul_iter_destroy,
+    .delete = &ul_iter_delete
+  };
+  return iter;
+}
+
+/*******************************************************************************
+
+                                 Generic List
+
+*******************************************************************************/
+
+smb_list ul_cast_to_list(smb_ul *list)
+{
+  smb_list genericList;
+  genericList.data = list;
+
+  genericList.kind = SMB_LIST_UL;
+
+  return genericList;
+}
+
+smb_list ul_create_list()
+{
+  smb_ul *list = ul_create();
+  return ul_cast_to_list(list);
+}
@@ -195,12 +195,11 @@ int data_compare_string(DATA d1, DATA d2)
  */
 int data_compare_int(DATA d1, DATA d2)
 {
-  // Since the difference between two long long ints could be more than an int,
-  // we need to store the difference and conditionally return.
-  long long int diff = d1.data_llint - d2.data_llint;
-  if (diff < 0) {
+  // Compare rather than subtract, since the difference between two long long
+  // ints could overflow.
+  if (d1.data_llint < d2.data_llint) {
     return -1;
-  } else if (diff > 0) {
+  } else if (d1.data_llint > d2.data_llint) {
     return 1;
   } else {
     return 0;
@@ -211,8 +210,8 @@ int data_compare_int(DATA d1, DATA d2)
    @brief Test whether two doubles are equal.
 
    This function compares two doubles stored in DATA.  However, it's NOT a smart
-   comparison.  It really just tests whether the binary representations
-   themselves are equal.  If you want a smart method for comparing floating
+   comparison.  It orders the doubles by value, and so only considers them equal
+   if they are exactly equal.  If you want a smart method for comparing floating
    point numbers, look elsewhere!
 
    @param d1 First double.
@@ -222,10 +221,9 @@ int data_compare_int(DATA d1, DATA d2)
  */
 int data_compare_float(DATA d1, DATA d2)
 {
-  double diff = d1.data_llint - d2.data_llint;
-  if (diff < 0) {
+  if (d1.data_dbl < d2.data_dbl) {
     return -1;
-  } else if (diff > 0) {
+  } else if (d1.data_dbl > d2.data_dbl) {
     return 1;
   } else {
     return 0;
@@ -13,6 +13,8 @@
 
 *******************************************************************************/
 
+#include <stdlib.h>
+
 #include "libstephen/al.h"
 #include "libstephen/ut.h"
 #include "tests.h"
@@ -46,6 +48,559 @@ int al_test_create_empty()
   return 0;
 }
 
+/**
+   Append enough items to grow the list many times, and check that the capacity
+   grows geometrically rather than one block at a time.
+ */
+int al_test_growth()
+{
+  smb_status status = SMB_SUCCESS;
+  int i, last = 0, reallocs = 0;
+  smb_al *list = al_create();
+
+  for (i = 0; i < 100000; i++) {
+    al_append(list, LLINT(i));
+    if (al_capacity(list) != last) {
+      last = al_capacity(list);
+      reallocs++;
+    }
+  }
+  TA_INT_EQ(al_length(list), 100000);
+  TA_INT_LT(reallocs, 20);
+  for (i = 0; i < 100000; i++) {
+    TA_LLINT_EQ(al_get(list, i, &status).data_llint, (long long int)i);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+
+  al_delete(list);
+  return 0;
+}
+
+int al_test_reserve()
+{
+  smb_status status = SMB_SUCCESS;
+  int i;
+  smb_al *list = al_create_capacity(0);
+  TA_INT_EQ(al_length(list), 0);
+  TA_INT_GE(al_capacity(list), 1);
+
+  al_reserve(list, 1000);
+  TA_INT_EQ(al_capacity(list), 1000);
+  for (i = 0; i < 1000; i++) {
+    al_append(list, LLINT(i));
+  }
+  TA_INT_EQ(al_capacity(list), 1000);
+
+  // Reserving less than the current capacity does nothing.
+  al_reserve(list, 10);
+  TA_INT_EQ(al_capacity(list), 1000);
+
+  al_append(list, LLINT(1000));
+  TA_INT_GT(al_capacity(list), 1000);
+  al_shrink_to_fit(list);
+  TA_INT_EQ(al_capacity(list), 1001);
+  for (i = 0; i <= 1000; i++) {
+    TA_LLINT_EQ(al_get(list, i, &status).data_llint, (long long int)i);
+  }
+
+  // Shrinking an empty list leaves it usable.
+  while (al_length(list) > 0) {
+    al_pop_back(list, &status);
+  }
+  al_shrink_to_fit(list);
+  al_append(list, LLINT(5));
+  TA_LLINT_EQ(al_peek_front(list, &status).data_llint, (long long int)5);
+
+  al_delete(list);
+  return 0;
+}
+
+int al_test_init_capacity()
+{
+  smb_al list;
+  al_init_capacity(&list, 64);
+  TA_INT_EQ(al_length(&list), 0);
+  TA_INT_EQ(al_capacity(&list), 64);
+  al_destroy(&list);
+  return 0;
+}
+
+/**
+   Use the list as a queue for a long time.  The items should keep getting
+   moved back to the middle of the buffer, rather than the buffer growing.
+ */
+int al_test_queue()
+{
+  smb_status status = SMB_SUCCESS;
+  long long int i, next = 0;
+  smb_al *list = al_create();
+
+  for (i = 0; i < 100000; i++) {
+    al_push_back(list, LLINT(i));
+    if (i % 3 != 0) {
+      TA_LLINT_EQ(al_pop_front(list, &status).data_llint, next);
+      TA_INT_EQ(status, SMB_SUCCESS);
+      next++;
+    }
+  }
+  TA_INT_EQ(al_length(list), 100000 - (int)next);
+  TA_INT_LT(al_capacity(list), 4 * al_length(list));
+  while (al_length(list) > 0) {
+    TA_LLINT_EQ(al_pop_front(list, &status).data_llint, next);
+    next++;
+  }
+  TA_LLINT_EQ(next, 100000LL);
+  al_pop_front(list, &status);
+  TA_INT_EQ(status, SMB_INDEX_ERROR);
+
+  al_delete(list);
+  return 0;
+}
+
+/**
+   Build a list from both ends, then check its order.
+ */
+int al_test_prepend()
+{
+  smb_status status = SMB_SUCCESS;
+  int i;
+  smb_al *list = al_create();
+
+  for (i = 0; i < 5000; i++) {
+    al_prepend(list, LLINT(-i));
+    al_append(list, LLINT(i + 1));
+  }
+  TA_INT_EQ(al_length(list), 10000);
+  for (i = 0; i < 10000; i++) {
+    TA_LLINT_EQ(al_get(list, i, &status).data_llint, (long long int)(i - 4999));
+  }
+  TA_LLINT_EQ(al_pop_back(list, &status).data_llint, 5000LL);
+  TA_LLINT_EQ(al_pop_front(list, &status).data_llint, -4999LL);
+
+  al_delete(list);
+  return 0;
+}
+
+/**
+   Insert and remove at positions on both sides of the middle, and compare
+   against a plain array.
+ */
+int al_test_insert_remove()
+{
+  smb_status status = SMB_SUCCESS;
+  long long int expect[1000];
+  int i, j, n = 0, index;
+  smb_al *list = al_create();
+
+  for (i = 0; i < 1000; i++) {
+    index = (i * 7919) % (n + 1);
+    if (i % 5 == 4) {
+      index = index % n;
+      al_remove(list, index, &status);
+      TA_INT_EQ(status, SMB_SUCCESS);
+      for (j = index; j < n - 1; j++) {
+        expect[j] = expect[j + 1];
+      }
+      n--;
+    } else {
+      al_insert(list, index, LLINT(i));
+      for (j = n; j > index; j--) {
+        expect[j] = expect[j - 1];
+      }
+      expect[index] = i;
+      n++;
+    }
+  }
+  TA_INT_EQ(al_length(list), n);
+  for (i = 0; i < n; i++) {
+    TA_LLINT_EQ(al_get(list, i, &status).data_llint, expect[i]);
+  }
+
+  al_delete(list);
+  return 0;
+}
+
+/**
+   Check that each item of the list is equal to the matching item of expect.
+ */
+static int al_test_check(const smb_al *list, const long long int *expect, int n)
+{
+  smb_status status = SMB_SUCCESS;
+  int i;
+  TA_INT_EQ(al_length(list), n);
+  for (i = 0; i < n; i++) {
+    TA_LLINT_EQ(al_get(list, i, &status).data_llint, expect[i]);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+  return 0;
+}
+
+int al_test_range()
+{
+  smb_status status = SMB_SUCCESS;
+  DATA items[100];
+  long long int expect[] = {0, 1, 100, 101, 102, 2, 3, 4, 5, 103, 104, 6, 7};
+  long long int after[] = {0, 1, 100, 104, 6, 7};
+  int i, rv;
+  smb_al *list = al_create(), *slice;
+
+  for (i = 0; i < 100; i++) {
+    items[i] = LLINT(i);
+  }
+  al_extend(list, items, 8);
+  al_extend(list, items, 0);
+  al_insert_range(list, 2, items, 0);
+  for (i = 0; i < 5; i++) {
+    items[i] = LLINT(100 + i);
+  }
+  al_insert_range(list, 2, items, 3);
+  al_insert_range(list, 9, items + 3, 2);
+  rv = al_test_check(list, expect, 13);
+  if (rv) {
+    return rv;
+  }
+
+  slice = al_slice(list, 2, 9, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  rv = al_test_check(slice, expect + 2, 9);
+  if (rv) {
+    return rv;
+  }
+  // The slice is a normal list, which can still grow at both ends.
+  al_prepend(slice, LLINT(1));
+  al_append(slice, LLINT(6));
+  rv = al_test_check(slice, expect + 1, 11);
+  if (rv) {
+    return rv;
+  }
+  al_delete(slice);
+
+  al_remove_range(list, 3, 7, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  rv = al_test_check(list, after, 6);
+  if (rv) {
+    return rv;
+  }
+
+  // Out of range requests change nothing.
+  al_remove_range(list, 4, 3, &status);
+  TA_INT_EQ(status, SMB_INDEX_ERROR);
+  al_remove_range(list, -1, 2, &status);
+  TA_INT_EQ(status, SMB_INDEX_ERROR);
+  TA_PTR_EQ(al_slice(list, 5, 2, &status), NULL);
+  TA_INT_EQ(status, SMB_INDEX_ERROR);
+  rv = al_test_check(list, after, 6);
+  if (rv) {
+    return rv;
+  }
+
+  al_remove_range(list, 0, 6, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  TA_INT_EQ(al_length(list), 0);
+
+  al_delete(list);
+  return 0;
+}
+
+/**
+   Extend and insert into a list from its own items, including when the list has
+   to grow, which replaces the buffer the items are in.
+ */
+int al_test_range_alias()
+{
+  long long int expect[50];
+  int i, rv;
+  smb_al *list = al_create_capacity(20);
+
+  for (i = 0; i < 20; i++) {
+    al_append(list, LLINT(i));
+  }
+  TA_INT_EQ(al_capacity(list), 20);
+  al_extend(list, list->data + list->start, 20);
+  TA_INT_GT(al_capacity(list), 20);
+  for (i = 0; i < 40; i++) {
+    expect[i] = i % 20;
+  }
+  rv = al_test_check(list, expect, 40);
+  if (rv) {
+    return rv;
+  }
+
+  // Insert items 10 to 19 at index 5, so that making room moves them.
+  al_insert_range(list, 5, list->data + list->start + 10, 10);
+  for (i = 0; i < 50; i++) {
+    if (i < 5) {
+      expect[i] = i;
+    } else if (i < 15) {
+      expect[i] = i + 5;
+    } else {
+      expect[i] = (i - 10) % 20;
+    }
+  }
+  rv = al_test_check(list, expect, 50);
+  if (rv) {
+    return rv;
+  }
+
+  al_delete(list);
+  return 0;
+}
+
+/**
+   A comparator which orders integers from largest to smallest.  It is not
+   data_compare_int(), so al_sort() never uses a radix sort with it.
+ */
+static int al_test_reverse_int(DATA d1, DATA d2)
+{
+  return data_compare_int(d2, d1);
+}
+
+/**
+   The comparator used by al_test_qsort_adapter().
+ */
+static DATA_COMPARE al_test_qsort_cmp;
+
+static int al_test_qsort_adapter(const void *a, const void *b)
+{
+  return al_test_qsort_cmp(*(const DATA *)a, *(const DATA *)b);
+}
+
+/**
+   Sort the items with al_sort(), and compare the result against qsort().
+ */
+static int al_test_sort_items(DATA *items, int n, DATA_COMPARE cmp)
+{
+  smb_status status = SMB_SUCCESS;
+  smb_al *list = al_create();
+  int i;
+
+  // Leave some space before the items, so the sort has to respect where the
+  // list starts.
+  al_extend(list, items, n);
+  al_prepend(list, LLINT(0));
+  al_pop_front(list, &status);
+
+  al_sort(list, cmp);
+  al_test_qsort_cmp = cmp;
+  qsort(items, n, sizeof(DATA), al_test_qsort_adapter);
+
+  TA_INT_EQ(al_length(list), n);
+  for (i = 0; i < n; i++) {
+    TA_INT_EQ(cmp(al_get(list, i, &status), items[i]), 0);
+  }
+  al_delete(list);
+  return 0;
+}
+
+/**
+   A deterministic pseudorandom number generator, so failures are repeatable.
+ */
+static unsigned long long al_test_random(unsigned long long *state)
+{
+  *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+  return *state >> 11;
+}
+
+int al_test_sort_int()
+{
+  unsigned long long state = 42;
+  DATA *items = smb_new(DATA, 20000);
+  int sizes[] = {0, 1, 2, 17, 100, 511, 512, 20000};
+  int i, n, rv = 0;
+
+  for (n = 0; n < (int)(sizeof(sizes) / sizeof(int)) && !rv; n++) {
+    for (i = 0; i < sizes[n]; i++) {
+      items[i].data_llint = (long long int) al_test_random(&state);
+      if (i % 3 == 0) {
+        items[i].data_llint = -items[i].data_llint;
+      } else if (i % 3 == 1) {
+        items[i].data_llint %= 100;
+      }
+    }
+    if (sizes[n] > 4) {
+      items[0] = LLINT(-9223372036854775807LL - 1);
+      items[1] = LLINT(9223372036854775807LL);
+    }
+    rv = al_test_sort_items(items, sizes[n], data_compare_int);
+    if (!rv) {
+      rv = al_test_sort_items(items, sizes[n], al_test_reverse_int);
+    }
+  }
+
+  smb_free(items);
+  return rv;
+}
+
+int al_test_sort_float()
+{
+  unsigned long long state = 7;
+  DATA *items = smb_new(DATA, 20000);
+  int i, rv;
+
+  for (i = 0; i < 20000; i++) {
+    items[i].data_dbl = (double) al_test_random(&state) / 1e10 - 4e5;
+  }
+  items[0].data_dbl = 0.0;
+  items[1].data_dbl = -0.0;
+  items[2].data_dbl = -1e300;
+  items[3].data_dbl = 1e-300;
+  rv = al_test_sort_items(items, 20000, data_compare_float);
+  if (!rv) {
+    rv = al_test_sort_items(items, 300, data_compare_float);
+  }
+
+  smb_free(items);
+  return rv;
+}
+
+/**
+   Inputs which are bad for simple quicksorts: sorted, reversed, all equal, and
+   organ pipe.
+ */
+int al_test_sort_patterns()
+{
+  DATA *items = smb_new(DATA, 5000);
+  int i, pattern, rv = 0;
+
+  for (pattern = 0; pattern < 4 && !rv; pattern++) {
+    for (i = 0; i < 5000; i++) {
+      if (pattern == 0) {
+        items[i] = LLINT(i);
+      } else if (pattern == 1) {
+        items[i] = LLINT(5000 - i);
+      } else if (pattern == 2) {
+        items[i] = LLINT(3);
+      } else {
+        items[i] = LLINT(i < 2500 ? i : 5000 - i);
+      }
+    }
+    rv = al_test_sort_items(items, 5000, al_test_reverse_int);
+  }
+
+  smb_free(items);
+  return rv;
+}
+
+int al_test_sort_string()
+{
+  char *words[] = {"pear", "apple", "fig", "banana", "cherry", "apple", "date",
+                   "kiwi", "grape", "lime", "mango", "lemon", "nut", "olive",
+                   "peach", "plum", "quince", "raisin", "sloe", "tangerine"};
+  DATA items[20];
+  int i;
+  for (i = 0; i < 20; i++) {
+    items[i] = PTR(words[i]);
+  }
+  return al_test_sort_items(items, 20, data_compare_string);
+}
+
+static DATA al_test_square(DATA d)
+{
+  return LLINT(d.data_llint * d.data_llint);
+}
+
+static bool al_test_is_odd(DATA d)
+{
+  return d.data_llint % 2 != 0;
+}
+
+static DATA al_test_sum(DATA d1, DATA d2)
+{
+  return LLINT(d1.data_llint + d2.data_llint);
+}
+
+int al_test_par_map()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_al *list = al_create();
+  long long int i;
+
+  for (i = 0; i < 100000; i++) {
+    al_append(list, LLINT(i - 50000));
+  }
+  al_par_map(list, al_test_square, 1000);
+  for (i = 0; i < 100000; i++) {
+    TA_LLINT_EQ(al_get(list, i, &status).data_llint, (i - 50000) * (i - 50000));
+  }
+
+  al_delete(list);
+  return 0;
+}
+
+int al_test_par_filter()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_al *list = al_create();
+  long long int i;
+
+  // Leave space before the items, to check that the filter respects it.
+  for (i = 0; i < 100001; i++) {
+    al_append(list, LLINT(i));
+  }
+  al_pop_front(list, &status);
+  al_par_filter(list, al_test_is_odd, 1000);
+  TA_INT_EQ(al_length(list), 50000);
+  for (i = 0; i < 50000; i++) {
+    TA_LLINT_EQ(al_get(list, i, &status).data_llint, 2 * i + 2);
+  }
+
+  al_par_filter(list, al_test_is_odd, 0);
+  TA_INT_EQ(al_length(list), 50000);
+  al_destroy(list);
+  al_init(list);
+  al_par_filter(list, al_test_is_odd, 1);
+  TA_INT_EQ(al_length(list), 0);
+
+  al_delete(list);
+  return 0;
+}
+
+int al_test_par_reduce()
+{
+  smb_al *list = al_create();
+  long long int i;
+
+  TA_LLINT_EQ(al_par_reduce(list, LLINT(7), al_test_sum, 1).data_llint, 7LL);
+  for (i = 1; i <= 100000; i++) {
+    al_append(list, LLINT(i));
+  }
+  TA_LLINT_EQ(al_par_reduce(list, LLINT(0), al_test_sum, 1000).data_llint,
+              5000050000LL);
+  TA_LLINT_EQ(al_par_reduce(list, LLINT(1), al_test_sum, 0).data_llint,
+              5000050001LL);
+
+  al_delete(list);
+  return 0;
+}
+
+int al_test_par_sort()
+{
+  smb_status status = SMB_SUCCESS;
+  unsigned long long state = 3;
+  int sizes[] = {0, 1, 999, 1000, 7001, 100000};
+  int i, n;
+  smb_al *list;
+
+  for (n = 0; n < (int)(sizeof(sizes) / sizeof(int)); n++) {
+    list = al_create();
+    for (i = 0; i < sizes[n]; i++) {
+      al_append(list, LLINT((long long int) al_test_random(&state) % 10000));
+    }
+    al_par_sort(list, al_test_reverse_int, 1000);
+    TA_INT_EQ(al_length(list), sizes[n]);
+    for (i = 1; i < sizes[n]; i++) {
+      TA_LLINT_GE(al_get(list, i - 1, &status).data_llint,
+                  al_get(list, i, &status).data_llint);
+    }
+    al_par_sort(list, data_compare_int, 1000);
+    for (i = 1; i < sizes[n]; i++) {
+      TA_LLINT_LE(al_get(list, i - 1, &status).data_llint,
+                  al_get(list, i, &status).data_llint);
+    }
+    al_delete(list);
+  }
+  return 0;
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 // TEST LOADER AND RUNNER
@@ -60,6 +615,57 @@ void array_list_test()
   smb_ut_test *create_empty = su_create_test("create_empty", al_test_create_empty);
   su_add_test(group, create_empty);
 
+  smb_ut_test *growth = su_create_test("growth", al_test_growth);
+  su_add_test(group, growth);
+
+  smb_ut_test *reserve = su_create_test("reserve", al_test_reserve);
+  su_add_test(group, reserve);
+
+  smb_ut_test *init_capacity = su_create_test("init_capacity",
+                                              al_test_init_capacity);
+  su_add_test(group, init_capacity);
+
+  smb_ut_test *queue = su_create_test("queue", al_test_queue);
+  su_add_test(group, queue);
+
+  smb_ut_test *prepend = su_create_test("prepend", al_test_prepend);
+  su_add_test(group, prepend);
+
+  smb_ut_test *insert_remove = su_create_test("insert_remove",
+                                              al_test_insert_remove);
+  su_add_test(group, insert_remove);
+
+  smb_ut_test *range = su_create_test("range", al_test_range);
+  su_add_test(group, range);
+
+  smb_ut_test *range_alias = su_create_test("range_alias", al_test_range_alias);
+  su_add_test(group, range_alias);
+
+  smb_ut_test *sort_int = su_create_test("sort_int", al_test_sort_int);
+  su_add_test(group, sort_int);
+
+  smb_ut_test *sort_float = su_create_test("sort_float", al_test_sort_float);
+  su_add_test(group, sort_float);
+
+  smb_ut_test *sort_patterns = su_create_test("sort_patterns",
+                                              al_test_sort_patterns);
+  su_add_test(group, sort_patterns);
+
+  smb_ut_test *sort_string = su_create_test("sort_string", al_test_sort_string);
+  su_add_test(group, sort_string);
+
+  smb_ut_test *par_map = su_create_test("par_map", al_test_par_map);
+  su_add_test(group, par_map);
+
+  smb_ut_test *par_filter = su_create_test("par_filter", al_test_par_filter);
+  su_add_test(group, par_filter);
+
+  smb_ut_test *par_reduce = su_create_test("par_reduce", al_test_par_reduce);
+  su_add_test(group, par_reduce);
+
+  smb_ut_test *par_sort = su_create_test("par_sort", al_test_par_sort);
+  su_add_test(group, par_sort);
+
   su_run_group(group);
   su_delete_group(group);
 }
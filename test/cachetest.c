@@ -0,0 +1,146 @@
+/***************************************************************************//**
+
+  @file         cachetest.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Tests for the LRU cache.
+
+  @copyright    Copyright (c) 2013-2016, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#include <stdio.h>
+
+#include "tests.h"
+#include "libstephen/ut.h"
+#include "libstephen/cache.h"
+
+#define CACHE_TEST_CAPACITY 50
+#define CACHE_TEST_KEYS 200
+
+long long cache_test_evicted = -1;
+unsigned int cache_test_evictions = 0;
+
+void cache_test_evict(DATA value)
+{
+  cache_test_evicted = value.data_llint;
+  cache_test_evictions++;
+}
+
+int cache_test_lru()
+{
+  smb_status status = SMB_SUCCESS;
+  DATA value;
+  smb_cache *cache = cache_create(3, &ht_int_hash, &data_compare_int,
+                                  &cache_test_evict);
+  cache_test_evictions = 0;
+
+  cache_put(cache, LLINT(1), LLINT(10));
+  cache_put(cache, LLINT(2), LLINT(20));
+  cache_put(cache, LLINT(3), LLINT(30));
+  TA_INT_EQ(cache->length, 3);
+
+  // Using 1 makes 2 the least recently used.
+  value = cache_get(cache, LLINT(1), &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  TA_LLINT_EQ(value.data_llint, 10);
+  cache_put(cache, LLINT(4), LLINT(40));
+  TA_INT_EQ(cache_test_evictions, 1);
+  TA_LLINT_EQ(cache_test_evicted, 20);
+  TEST_ASSERT(!cache_contains(cache, LLINT(2)));
+  cache_get(cache, LLINT(2), &status);
+  TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+
+  // Updating 3 makes it the most recently used (without evicting anything).
+  cache_put(cache, LLINT(3), LLINT(31));
+  TA_INT_EQ(cache_test_evictions, 1);
+  cache_put(cache, LLINT(5), LLINT(50));
+  TA_LLINT_EQ(cache_test_evicted, 10);
+  value = cache_get(cache, LLINT(3), &status);
+  TA_LLINT_EQ(value.data_llint, 31);
+
+  cache_remove(cache, LLINT(4), &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  cache_remove(cache, LLINT(4), &status);
+  TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+  TA_INT_EQ(cache->length, 2);
+
+  TA_INT_EQ(cache->hits, 2);
+  TA_INT_EQ(cache->misses, 1);
+  TA_INT_EQ(cache->evictions, 2);
+
+  cache_delete(cache);
+  return 0;
+}
+
+/**
+   Run a long random workload against a simple reference LRU (an array ordered
+   by recency), checking that the cache agrees about every key.
+ */
+int cache_test_reference()
+{
+  smb_status status = SMB_SUCCESS;
+  long long order[CACHE_TEST_CAPACITY], key;
+  unsigned int n = 0, i, j, found, gets = 0;
+  DATA value;
+  smb_cache cache;
+
+  cache_init(&cache, CACHE_TEST_CAPACITY, &ht_int_hash, &data_compare_int,
+             NULL);
+  srand(12345);
+  for (i = 0; i < 20000; i++) {
+    key = rand() % CACHE_TEST_KEYS;
+
+    // Find the key in the reference, and move it to the front.
+    for (found = 0; found < n && order[found] != key; found++);
+    if (found == n) {
+      if (n < CACHE_TEST_CAPACITY) {
+        n++;
+      }
+      found = n - 1;
+    }
+    for (j = found; j > 0; j--) {
+      order[j] = order[j - 1];
+    }
+    order[0] = key;
+
+    if (rand() % 2) {
+      cache_put(&cache, LLINT(key), LLINT(-key));
+    } else {
+      gets++;
+      value = cache_get(&cache, LLINT(key), &status);
+      if (status == SMB_SUCCESS) {
+        TA_LLINT_EQ(value.data_llint, -key);
+      } else {
+        cache_put(&cache, LLINT(key), LLINT(-key));
+      }
+    }
+  }
+
+  TA_INT_EQ(cache.length, n);
+  for (i = 0; i < n; i++) {
+    TEST_ASSERT(cache_contains(&cache, LLINT(order[i])));
+  }
+  TA_INT_EQ(cache.hits + cache.misses, gets);
+
+  cache_destroy(&cache);
+  return 0;
+}
+
+void cache_test(void)
+{
+  smb_ut_group *group = su_create_test_group("test/cachetest.c");
+
+  smb_ut_test *lru = su_create_test("lru", cache_test_lru);
+  su_add_test(group, lru);
+
+  smb_ut_test *reference = su_create_test("reference", cache_test_reference);
+  su_add_test(group, reference);
+
+  su_run_group(group);
+  su_delete_group(group);
+}
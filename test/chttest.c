@@ -0,0 +1,127 @@
+/***************************************************************************//**
+
+  @file         chttest.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Tests for the concurrent hash table.
+
+  @copyright    Copyright (c) 2013-2016, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#include <pthread.h>
+#include <stdio.h>
+
+#include "tests.h"
+#include "libstephen/ut.h"
+#include "libstephen/cht.h"
+
+#define CHT_TEST_THREADS 4
+#define CHT_TEST_KEYS 2000
+
+typedef struct {
+  smb_cht *table;
+  long long start;
+  int errors;
+} cht_test_arg;
+
+/**
+   Insert a range of keys, reading back each one (and keys from the other
+   threads' ranges) along the way.  Then remove every other key.
+ */
+static void *cht_test_worker(void *varg)
+{
+  cht_test_arg *arg = varg;
+  smb_status status = SMB_SUCCESS;
+  DATA value;
+  long long i;
+
+  for (i = arg->start; i < arg->start + CHT_TEST_KEYS; i++) {
+    cht_insert(arg->table, LLINT(i), LLINT(-i));
+    value = cht_get(arg->table, LLINT(i), &status);
+    if (status != SMB_SUCCESS || value.data_llint != -i) {
+      arg->errors++;
+    }
+    // Other threads' keys may or may not be there yet, but if they are, they
+    // must have the right value.
+    value = cht_get(arg->table, LLINT((i + CHT_TEST_KEYS) %
+                                      (CHT_TEST_THREADS * CHT_TEST_KEYS)),
+                    &status);
+    if (status == SMB_SUCCESS && value.data_llint !=
+        -((i + CHT_TEST_KEYS) % (CHT_TEST_THREADS * CHT_TEST_KEYS))) {
+      arg->errors++;
+    }
+  }
+
+  for (i = arg->start; i < arg->start + CHT_TEST_KEYS; i += 2) {
+    cht_remove(arg->table, LLINT(i), &status);
+    if (status != SMB_SUCCESS) {
+      arg->errors++;
+    }
+  }
+  return NULL;
+}
+
+int cht_test_threads()
+{
+  smb_status status = SMB_SUCCESS;
+  pthread_t threads[CHT_TEST_THREADS];
+  cht_test_arg args[CHT_TEST_THREADS];
+  DATA value;
+  long long i;
+  smb_cht *table = cht_create(&ht_int_hash, &data_compare_int, 0);
+
+  for (i = 0; i < CHT_TEST_THREADS; i++) {
+    args[i].table = table;
+    args[i].start = i * CHT_TEST_KEYS;
+    args[i].errors = 0;
+    pthread_create(&threads[i], NULL, cht_test_worker, &args[i]);
+  }
+  for (i = 0; i < CHT_TEST_THREADS; i++) {
+    pthread_join(threads[i], NULL);
+    TA_INT_EQ(args[i].errors, 0);
+  }
+
+  TA_INT_EQ(cht_length(table), CHT_TEST_THREADS * CHT_TEST_KEYS / 2);
+  for (i = 0; i < CHT_TEST_THREADS * CHT_TEST_KEYS; i++) {
+    value = cht_get(table, LLINT(i), &status);
+    if (i % 2 == 0) {
+      TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+    } else {
+      TA_INT_EQ(status, SMB_SUCCESS);
+      TA_LLINT_EQ(value.data_llint, -i);
+    }
+  }
+
+  cht_delete(table);
+  return 0;
+}
+
+int cht_test_segments()
+{
+  smb_cht *table = cht_create(&ht_string_hash, &data_compare_string, 5);
+  TA_INT_EQ(table->nsegments, 8);
+  cht_insert(table, PTR("key"), PTR("value"));
+  TEST_ASSERT(cht_contains(table, PTR("key")));
+  TEST_ASSERT(!cht_contains(table, PTR("other key")));
+  cht_delete(table);
+  return 0;
+}
+
+void cht_test(void)
+{
+  smb_ut_group *group = su_create_test_group("test/chttest.c");
+
+  smb_ut_test *threads = su_create_test("threads", cht_test_threads);
+  su_add_test(group, threads);
+
+  smb_ut_test *segments = su_create_test("segments", cht_test_segments);
+  su_add_test(group, segments);
+
+  su_run_group(group);
+  su_delete_group(group);
+}
@@ -14,6 +14,7 @@
 *******************************************************************************/
 
 #include <stdio.h>
+#include <string.h>
 
 #include "tests.h"
 #include "libstephen/ut.h"
@@ -236,6 +237,322 @@ int ht_test_resize()
   return 0;
 }
 
+/**
+   Insert enough sequential keys to resize several times, and check that the
+   table stays a power of two in size and that every key survives the resizes
+   (which move buckets by their cached hashes).
+ */
+int ht_test_many()
+{
+  smb_status status = SMB_SUCCESS;
+  DATA value;
+  long long i;
+  smb_ht *table = ht_create(ht_test_linear_hash, &data_compare_int);
+
+  for (i = 0; i < 1000; i++) {
+    ht_insert(table, LLINT(i), LLINT(-i));
+  }
+  TA_INT_EQ(table->length, 1000);
+  TA_INT_EQ(table->allocated & (table->allocated - 1), 0);
+
+  for (i = 0; i < 1000; i += 2) {
+    ht_remove(table, LLINT(i), &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+
+  for (i = 0; i < 1000; i++) {
+    value = ht_get(table, LLINT(i), &status);
+    if (i % 2 == 0) {
+      TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+    } else {
+      TA_INT_EQ(status, SMB_SUCCESS);
+      TA_LLINT_EQ(value.data_llint, -i);
+    }
+  }
+
+  ht_delete(table);
+  return 0;
+}
+
+/**
+   With incremental resizing, check that keys are found while they are split
+   between the old and new tables, and that removing, updating and iterating
+   all see both tables.
+ */
+int ht_test_incremental()
+{
+  smb_status status = SMB_SUCCESS;
+  DATA value;
+  long long i, j;
+  bool saw_old = false;
+  smb_ht *table = ht_create(ht_test_linear_hash, &data_compare_int);
+  ht_set_incremental(table, true);
+
+  for (i = 0; i < 500; i++) {
+    ht_insert(table, LLINT(i), LLINT(-i));
+    saw_old = saw_old || table->old_table != NULL;
+    for (j = 0; j <= i; j += 7) {
+      value = ht_get(table, LLINT(j), &status);
+      TA_INT_EQ(status, SMB_SUCCESS);
+      TA_LLINT_EQ(value.data_llint, -j);
+    }
+  }
+  TEST_ASSERT(saw_old);
+
+  // Grow once more, then update and remove while the resize is in progress.
+  while (table->old_table == NULL) {
+    ht_insert(table, LLINT(i), LLINT(-i));
+    i++;
+  }
+  ht_insert(table, LLINT(1), LLINT(100));
+  ht_remove(table, LLINT(2), &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  TEST_ASSERT(table->old_table != NULL);
+  value = ht_get(table, LLINT(1), &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  TA_LLINT_EQ(value.data_llint, 100);
+  TEST_ASSERT(!ht_contains(table, LLINT(2)));
+
+  smb_iter it = ht_get_iter(table);
+  j = 0;
+  while (it.has_next(&it)) {
+    it.next(&it, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+    j++;
+  }
+  TA_LLINT_EQ(j, (long long)table->length);
+
+  // Turning off incremental mode finishes the resize.
+  ht_set_incremental(table, false);
+  TEST_ASSERT(table->old_table == NULL);
+  TA_LLINT_EQ((long long)table->length, i - 1);
+
+  ht_delete(table);
+  return 0;
+}
+
+/**
+   Churn through many keys while keeping the live set small, and check that
+   graves are cleaned up instead of accumulating and growing the table.
+ */
+int ht_test_graves()
+{
+  smb_status status = SMB_SUCCESS;
+  long long i;
+  smb_ht *table = ht_create(ht_test_linear_hash, &data_compare_int);
+
+  for (i = 0; i < 10000; i++) {
+    ht_insert(table, LLINT(i), LLINT(-i));
+    if (i >= 10) {
+      ht_remove(table, LLINT(i - 10), &status);
+      TA_INT_EQ(status, SMB_SUCCESS);
+    }
+    TEST_ASSERT(table->graves <=
+                table->allocated * HASH_TABLE_MAX_GRAVE_FACTOR);
+  }
+
+  TA_INT_EQ(table->length, 10);
+  TA_INT_EQ(table->allocated, HASH_TABLE_INITIAL_SIZE);
+  TA_INT_GT(table->compactions, 0);
+  for (i = 9990; i < 10000; i++) {
+    TEST_ASSERT(ht_contains(table, LLINT(i)));
+  }
+
+  ht_delete(table);
+  return 0;
+}
+
+/**
+   Fill a table, then empty most of it, and check that it shrinks back down.
+ */
+int ht_test_shrink()
+{
+  smb_status status = SMB_SUCCESS;
+  DATA value;
+  long long i;
+  unsigned int peak;
+  smb_ht *table = ht_create(ht_test_linear_hash, &data_compare_int);
+
+  for (i = 0; i < 1000; i++) {
+    ht_insert(table, LLINT(i), LLINT(-i));
+  }
+  peak = table->allocated;
+
+  for (i = 0; i < 990; i++) {
+    ht_remove(table, LLINT(i), &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+
+  TA_INT_LT(table->allocated, peak);
+  TA_INT_GT(table->shrinks, 0);
+  TEST_ASSERT(table->graves <= table->allocated * HASH_TABLE_MAX_GRAVE_FACTOR);
+  for (i = 990; i < 1000; i++) {
+    value = ht_get(table, LLINT(i), &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+    TA_LLINT_EQ(value.data_llint, -i);
+  }
+
+  ht_delete(table);
+  return 0;
+}
+
+/**
+   Table sizes stop doubling at HASH_TABLE_MAX_SIZE instead of overflowing.
+ */
+int ht_test_next_size()
+{
+  TA_SIZE_EQ((size_t) ht_next_size(HASH_TABLE_INITIAL_SIZE),
+             (size_t) 2 * HASH_TABLE_INITIAL_SIZE);
+  TA_SIZE_EQ((size_t) ht_next_size(HASH_TABLE_MAX_SIZE / 2),
+             (size_t) HASH_TABLE_MAX_SIZE);
+  TA_SIZE_EQ((size_t) ht_next_size(HASH_TABLE_MAX_SIZE),
+             (size_t) HASH_TABLE_MAX_SIZE);
+  return 0;
+}
+
+/**
+   Reserve space, then bulk insert, and check that the table never has to grow
+   along the way.  Later duplicates in a batch win, like with ht_insert().
+ */
+int ht_test_insert_many()
+{
+  smb_status status = SMB_SUCCESS;
+  DATA keys[5001], values[5001], value;
+  unsigned int i, reserved;
+  smb_ht *table = ht_create(ht_test_linear_hash, &data_compare_int);
+
+  for (i = 0; i < 5000; i++) {
+    keys[i] = LLINT(i);
+    values[i] = LLINT(-(long long)i);
+  }
+  keys[5000] = LLINT(7);
+  values[5000] = LLINT(7);
+
+  ht_reserve(table, 5000);
+  reserved = table->allocated;
+  TA_INT_GE(reserved * HASH_TABLE_MAX_LOAD_FACTOR, 5000);
+
+  ht_insert_many(table, keys, values, 5001);
+  TA_INT_EQ(table->allocated, reserved);
+  TA_INT_EQ(table->length, 5000);
+
+  for (i = 0; i < 5000; i++) {
+    value = ht_get(table, LLINT(i), &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+    TA_LLINT_EQ(value.data_llint, i == 7 ? 7 : -(long long)i);
+  }
+
+  ht_delete(table);
+  return 0;
+}
+
+/**
+   Check the basic properties of ht_hash_bytes(): it depends on the content,
+   length and seed, and not on the alignment of the data.
+ */
+int ht_test_hash_bytes()
+{
+  char buf[128], copy[129];
+  unsigned int hashes[100];
+  unsigned int i, j;
+
+  for (i = 0; i < sizeof(buf); i++) {
+    buf[i] = (char) (i * 7 + 3);
+  }
+  memcpy(copy + 1, buf, sizeof(buf));
+
+  for (i = 0; i < 100; i++) {
+    hashes[i] = ht_hash_bytes(buf, i, 42);
+    TA_UINT_EQ(hashes[i], ht_hash_bytes(copy + 1, i, 42));
+    TA_UINT_NE(hashes[i], ht_hash_bytes(buf, i, 43));
+    for (j = 0; j < i; j++) {
+      TA_UINT_NE(hashes[i], hashes[j]);
+    }
+  }
+
+  // Equal strings at different addresses hash the same.
+  strcpy(buf, "first key");
+  TA_UINT_EQ(ht_string_hash(PTR(buf)), ht_string_hash(PTR(test_keys[0])));
+  TA_UINT_NE(ht_string_hash(PTR(test_keys[1])),
+             ht_string_hash(PTR(test_keys[0])));
+  return 0;
+}
+
+/**
+   Sequential integers should spread evenly across a power of two sized table
+   with ht_int_hash().
+ */
+int ht_test_int_hash()
+{
+  unsigned int counts[1024] = {0};
+  unsigned int i, max = 0;
+
+  for (i = 0; i < 1024; i++) {
+    counts[ht_int_hash(LLINT(i << 10)) & 1023]++;
+  }
+  for (i = 0; i < 1024; i++) {
+    max = counts[i] > max ? counts[i] : max;
+  }
+  TA_UINT_LT(max, 10);
+  return 0;
+}
+
+int ht_test_seed()
+{
+  smb_ht *a = ht_create(&ht_string_hash, &data_compare_string);
+  smb_ht *b = ht_create(&ht_string_hash, &data_compare_string);
+  TA_UINT_NE(a->seed, b->seed);
+  TA_UINT_NE(ht_seed_hash(1, a->seed), ht_seed_hash(1, b->seed));
+  ht_delete(a);
+  ht_delete(b);
+  return 0;
+}
+
+/**
+   With a constant hash, the i'th key inserted has probe length i, so every
+   probe statistic is known exactly.
+ */
+int ht_test_stats()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_ht_stats stats;
+  long long i;
+  smb_ht *table = ht_create(ht_test_constant_hash, &data_compare_int);
+
+  // Reserve, so that no resize changes the order of the keys.
+  ht_reserve(table, 20);
+  for (i = 0; i < 20; i++) {
+    ht_insert(table, LLINT(i), LLINT(-i));
+  }
+
+  ht_stats(table, &stats, false);
+  TA_INT_EQ(stats.length, 20);
+  TA_INT_EQ(stats.allocated, table->allocated);
+  TA_INT_EQ(stats.graves, 0);
+  TEST_ASSERT(stats.bytes >= table->allocated * sizeof(smb_ht_bckt));
+  TEST_ASSERT(stats.load_factor == 20.0 / table->allocated);
+  TA_INT_EQ(stats.max_probe, 0);
+
+  ht_stats(table, &stats, true);
+  TA_INT_EQ(stats.max_probe, 20);
+  TEST_ASSERT(stats.avg_probe == 10.5);
+  for (i = 0; i < HT_STATS_HISTOGRAM_SIZE - 1; i++) {
+    TA_INT_EQ(stats.histogram[i], 1);
+  }
+  TA_INT_EQ(stats.histogram[HT_STATS_HISTOGRAM_SIZE - 1], 5);
+
+  // Removing the first key leaves a grave, which the others still probe past.
+  ht_remove(table, LLINT(0), &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  ht_stats(table, &stats, true);
+  TA_INT_EQ(stats.graves, 1);
+  TA_INT_EQ(stats.histogram[0], 0);
+  TEST_ASSERT(stats.avg_probe == 11.0);
+
+  ht_delete(table);
+  return 0;
+}
+
 int ht_test_duplicate()
 {
   smb_status status = SMB_SUCCESS;
@@ -331,6 +648,36 @@ void hash_table_test()
   smb_ut_test *resize = su_create_test("resize", ht_test_resize);
   su_add_test(group, resize);
 
+  smb_ut_test *many = su_create_test("many", ht_test_many);
+  su_add_test(group, many);
+
+  smb_ut_test *incremental = su_create_test("incremental", ht_test_incremental);
+  su_add_test(group, incremental);
+
+  smb_ut_test *graves = su_create_test("graves", ht_test_graves);
+  su_add_test(group, graves);
+
+  smb_ut_test *shrink = su_create_test("shrink", ht_test_shrink);
+  su_add_test(group, shrink);
+
+  smb_ut_test *next_size = su_create_test("next_size", ht_test_next_size);
+  su_add_test(group, next_size);
+
+  smb_ut_test *insert_many = su_create_test("insert_many", ht_test_insert_many);
+  su_add_test(group, insert_many);
+
+  smb_ut_test *hash_bytes = su_create_test("hash_bytes", ht_test_hash_bytes);
+  su_add_test(group, hash_bytes);
+
+  smb_ut_test *int_hash = su_create_test("int_hash", ht_test_int_hash);
+  su_add_test(group, int_hash);
+
+  smb_ut_test *seed = su_create_test("seed", ht_test_seed);
+  su_add_test(group, seed);
+
+  smb_ut_test *stats = su_create_test("stats", ht_test_stats);
+  su_add_test(group, stats);
+
   smb_ut_test *duplicate = su_create_test("duplicate", ht_test_duplicate);
   su_add_test(group, duplicate);
 
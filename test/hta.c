@@ -13,7 +13,10 @@
 
 *******************************************************************************/
 
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "tests.h"
 #include "libstephen/ut.h"
@@ -46,7 +49,30 @@ unsigned int hta_test_constant_hash(void *key)
 
 unsigned int hta_test_linear_hash(void *key)
 {
-  return * (unsigned int*) key;
+  unsigned int hash;
+  memcpy(&hash, key, sizeof(hash));
+  return hash;
+}
+
+/**
+   Read an int from a key or value in a table.  Slots are packed, so it may be
+   misaligned.
+ */
+static int hta_test_int(const void *slot)
+{
+  int value;
+  memcpy(&value, slot, sizeof(value));
+  return value;
+}
+
+/**
+   Read a pointer from a key or value in a table, which may be misaligned.
+ */
+static char *hta_test_ptr(const void *slot)
+{
+  char *value;
+  memcpy(&value, slot, sizeof(value));
+  return value;
 }
 
 /**
@@ -69,7 +95,7 @@ int hta_test_insert()
     TEST_ASSERT(hta_contains(table, &hta_test_keys[i]));
     rv = (char**)hta_get(table, &hta_test_keys[i], &status);
     TA_INT_EQ(status, SMB_SUCCESS);
-    TA_PTR_EQ(hta_test_values[i], *rv);
+    TA_PTR_EQ(hta_test_values[i], hta_test_ptr(rv));
   }
 
   hta_delete(table);
@@ -93,7 +119,7 @@ int hta_test_remove()
   for (i = 0; i < TEST_PAIRS; i++) {
     rv = (char**)hta_get(table, &hta_test_keys[i], &status);
     TA_INT_EQ(status, SMB_SUCCESS);
-    TA_PTR_EQ(hta_test_values[i], *rv);
+    TA_PTR_EQ(hta_test_values[i], hta_test_ptr(rv));
     hta_remove(table, &hta_test_keys[i], &status);
     TA_INT_EQ(status, SMB_SUCCESS);
     TA_INT_EQ(table->length, TEST_PAIRS - i - 1);
@@ -168,14 +194,14 @@ int hta_test_buckets()
     key = i;
     rv = hta_get(table, &key, &status);
     TA_INT_EQ(status, SMB_SUCCESS);
-    TA_INT_EQ(*rv, (int)-i);
+    TA_INT_EQ(hta_test_int(rv), (int)-i);
   }
 
   for (i = 11; i < 19; i++) {
     key = i;
     rv = hta_get(table, &key, &status);
     TA_INT_EQ(status, SMB_SUCCESS);
-    TA_INT_EQ(*rv, (int)-i);
+    TA_INT_EQ(hta_test_int(rv), (int)-i);
   }
 
   hta_delete(table);
@@ -213,7 +239,7 @@ int hta_test_resize()
     key = i;
     rv = hta_get(table, &key, &status);
     TA_INT_EQ(status, SMB_SUCCESS);
-    TA_INT_EQ(*rv, (int)-i);
+    TA_INT_EQ(hta_test_int(rv), (int)-i);
   }
 
   hta_delete(table);
@@ -238,23 +264,644 @@ int hta_test_duplicate()
     hta_insert(table, &hta_test_keys[i], &newKey);
     rv = (char**)hta_get(table, &hta_test_keys[i], &status);
     TA_INT_EQ(status, SMB_SUCCESS);
-    TA_PTR_EQ(*rv, newKey);
+    TA_PTR_EQ(hta_test_ptr(rv), newKey);
   }
 
   for (i = 0; i < TEST_PAIRS; i++) {
     rv = (char**)hta_get(table, &hta_test_keys[i], &status);
     TA_INT_EQ(status, SMB_SUCCESS);
     if (i % 2 == 1) {
-      TA_PTR_EQ(*rv, hta_test_values[i]);
+      TA_PTR_EQ(hta_test_ptr(rv), hta_test_values[i]);
+    } else {
+      TA_PTR_EQ(hta_test_ptr(rv), newKey);
+    }
+  }
+
+  hta_delete(table);
+  return 0;
+}
+
+int hta_test_swiss_insert()
+{
+  smb_status status = SMB_SUCCESS;
+  int i;
+  char **rv;
+  smb_hta *table = hta_create_mode(&hta_string_hash, &hta_string_comp,
+                                   sizeof(char*), sizeof(char*), HTA_SWISS);
+
+  for (i = 0; i < TEST_PAIRS; i++) {
+    hta_insert(table, &hta_test_keys[i], &hta_test_values[i]);
+  }
+  TA_INT_EQ(table->length, TEST_PAIRS);
+
+  for (i = 0; i < TEST_PAIRS; i++) {
+    TEST_ASSERT(hta_contains(table, &hta_test_keys[i]));
+    rv = (char**)hta_get(table, &hta_test_keys[i], &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+    TA_PTR_EQ(hta_test_values[i], hta_test_ptr(rv));
+  }
+
+  for (i = 0; i < TEST_PAIRS; i++) {
+    hta_remove(table, &hta_test_keys[i], &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+    TEST_ASSERT(!hta_contains(table, &hta_test_keys[i]));
+  }
+  hta_remove(table, &hta_test_keys[0], &status);
+  TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+
+  hta_delete(table);
+  return 0;
+}
+
+/**
+   With a constant hash, every key lands in the same group, so this checks that
+   probing continues through full groups, and that graves left in full groups
+   don't break lookups.
+ */
+int hta_test_swiss_buckets()
+{
+  smb_status status = SMB_SUCCESS;
+  int key, value, *rv;
+  unsigned int i;
+  smb_hta *table = hta_create_mode(&hta_test_constant_hash, &hta_int_comp,
+                                   sizeof(int), sizeof(int), HTA_SWISS);
+
+  for (i = 0; i < 40; i++) {
+    key = i;
+    value = -i;
+    hta_insert(table, &key, &value);
+    TA_INT_EQ(table->length, i+1);
+  }
+
+  // Remove from the first (full) group, and from the last group.
+  for (i = 0; i < 40; i += 3) {
+    key = i;
+    hta_remove(table, &key, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+
+  for (i = 0; i < 40; i++) {
+    key = i;
+    rv = hta_get(table, &key, &status);
+    if (i % 3 == 0) {
+      TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+    } else {
+      TA_INT_EQ(status, SMB_SUCCESS);
+      TA_INT_EQ(hta_test_int(rv), (int)-i);
+    }
+  }
+
+  hta_delete(table);
+  return 0;
+}
+
+int hta_test_swiss_resize()
+{
+  smb_status status = SMB_SUCCESS;
+  int key, value, *rv;
+  int i;
+  smb_hta *table = hta_create_mode(&hta_test_linear_hash, &hta_int_comp,
+                                   sizeof(int), sizeof(int), HTA_SWISS);
+
+  for (i = 0; i < 1000; i++) {
+    key = i;
+    value = -i;
+    hta_insert(table, &key, &value);
+  }
+  TA_INT_EQ(table->length, 1000);
+  TA_INT_GT(table->allocated, 1000);
+
+  for (i = 0; i < 1000; i++) {
+    key = i;
+    rv = hta_get(table, &key, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+    TA_INT_EQ(hta_test_int(rv), -i);
+  }
+
+  hta_delete(table);
+  return 0;
+}
+
+/**
+   With a constant hash, every key shares one long run.  This is long enough
+   that probe distances no longer fit in the mark byte, and checks that
+   backward shifting on removal keeps the rest of the run reachable.
+ */
+int hta_test_robin_hood_buckets()
+{
+  smb_status status = SMB_SUCCESS;
+  int key, value, *rv;
+  unsigned int i;
+  smb_hta *table = hta_create_mode(&hta_test_constant_hash, &hta_int_comp,
+                                   sizeof(int), sizeof(int), HTA_ROBIN_HOOD);
+
+  for (i = 0; i < 400; i++) {
+    key = i;
+    value = -i;
+    hta_insert(table, &key, &value);
+    TA_INT_EQ(table->length, i+1);
+  }
+
+  for (i = 0; i < 400; i += 3) {
+    key = i;
+    hta_remove(table, &key, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+
+  for (i = 0; i < 400; i++) {
+    key = i;
+    rv = hta_get(table, &key, &status);
+    if (i % 3 == 0) {
+      TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+      status = SMB_SUCCESS;
     } else {
-      TA_PTR_EQ(*rv, newKey);
+      TA_INT_EQ(status, SMB_SUCCESS);
+      TA_INT_EQ(hta_test_int(rv), (int)-i);
+    }
+  }
+
+  hta_delete(table);
+  return 0;
+}
+
+/**
+   Fill a table to its maximum load, so that runs overlap (and some wrap around
+   the end of the table), then remove every other key, checking every key after
+   each removal.
+ */
+int hta_test_robin_hood_remove()
+{
+  smb_status status = SMB_SUCCESS;
+  int key, value, *rv;
+  int i, j, n;
+  smb_hta *table = hta_create_mode(&hta_test_linear_hash, &hta_int_comp,
+                                   sizeof(int), sizeof(int), HTA_ROBIN_HOOD);
+
+  n = (int)(table->allocated * HTA_ROBIN_HOOD_MAX_LOAD_FACTOR);
+  for (i = 0; i < n; i++) {
+    key = i;
+    value = -i;
+    hta_insert(table, &key, &value);
+  }
+  TA_INT_EQ((int) table->length, n);
+  TA_INT_EQ(table->allocated, HASH_TABLE_INITIAL_SIZE);
+
+  for (i = 0; i < n; i += 2) {
+    key = i;
+    hta_remove(table, &key, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+    for (j = 0; j < n; j++) {
+      key = j;
+      rv = hta_get(table, &key, &status);
+      if (j % 2 == 0 && j <= i) {
+        TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+        status = SMB_SUCCESS;
+      } else {
+        TA_INT_EQ(status, SMB_SUCCESS);
+        TA_INT_EQ(hta_test_int(rv), -j);
+      }
     }
   }
+  TA_INT_EQ((int) table->length, n / 2);
 
   hta_delete(table);
   return 0;
 }
 
+/**
+   With a constant hash, the i'th key inserted has probe length i in quadratic
+   and Robin Hood mode, and the keys fill groups in order in Swiss mode.
+ */
+int hta_test_stats_mode(smb_hta_mode mode)
+{
+  smb_status status = SMB_SUCCESS;
+  smb_ht_stats stats;
+  int key, value;
+  unsigned int i, max = mode == HTA_SWISS ? 2 : 20;
+  smb_hta *table = hta_create_mode(&hta_test_constant_hash, &hta_int_comp,
+                                   sizeof(int), sizeof(int), mode);
+
+  // Reserve, so that no resize changes the order of the keys.
+  hta_reserve(table, 20);
+  for (i = 0; i < 20; i++) {
+    key = i;
+    value = -i;
+    hta_insert(table, &key, &value);
+  }
+
+  hta_stats(table, &stats, false);
+  TA_INT_EQ(stats.length, 20);
+  TA_INT_EQ(stats.allocated, table->allocated);
+  TEST_ASSERT(stats.bytes >= table->allocated * (2 * sizeof(int)));
+  TA_INT_EQ(stats.max_probe, 0);
+
+  hta_stats(table, &stats, true);
+  TA_INT_EQ(stats.max_probe, max);
+  TA_INT_EQ(stats.graves, 0);
+  if (mode == HTA_SWISS) {
+    TA_INT_EQ(stats.histogram[0], HTA_GROUP_SIZE);
+    TA_INT_EQ(stats.histogram[1], 20 - HTA_GROUP_SIZE);
+  } else {
+    TEST_ASSERT(stats.avg_probe == 10.5);
+    TA_INT_EQ(stats.histogram[HT_STATS_HISTOGRAM_SIZE - 1], 5);
+  }
+
+  // Only quadratic mode leaves a grave here (in Swiss mode, the group with the
+  // key still has empty slots).
+  key = 19;
+  hta_remove(table, &key, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  hta_stats(table, &stats, true);
+  TA_INT_EQ(stats.graves, mode == HTA_QUADRATIC ? 1 : 0);
+  TA_INT_EQ(stats.max_probe, mode == HTA_SWISS ? max : max - 1);
+
+  hta_delete(table);
+  return 0;
+}
+
+int hta_test_stats()
+{
+  int rv = hta_test_stats_mode(HTA_QUADRATIC);
+  if (rv) {
+    return rv;
+  }
+  rv = hta_test_stats_mode(HTA_SWISS);
+  if (rv) {
+    return rv;
+  }
+  return hta_test_stats_mode(HTA_ROBIN_HOOD);
+}
+
+/**
+   Switch a table to the aligned layout partway through filling it, check that
+   values are aligned and everything survives, then switch it back.
+ */
+int hta_test_aligned_mode(smb_hta_mode mode)
+{
+  smb_status status = SMB_SUCCESS;
+  int key, i;
+  double value;
+  void *rv;
+  smb_hta *table = hta_create_mode(&hta_test_linear_hash, &hta_int_comp,
+                                   sizeof(int), sizeof(double), mode);
+
+  for (i = 0; i < 100; i++) {
+    key = i;
+    value = i / 2.0;
+    hta_insert(table, &key, &value);
+  }
+
+  hta_set_aligned(table, true);
+  TA_INT_EQ(table->key_offset, 0);
+  TA_INT_EQ(table->value_offset, sizeof(double));
+  TA_INT_EQ(table->slot_size, 2 * sizeof(double));
+  for (i = 100; i < 1000; i++) {
+    key = i;
+    value = i / 2.0;
+    hta_insert(table, &key, &value);
+  }
+  for (i = 0; i < 1000; i += 3) {
+    key = i;
+    hta_remove(table, &key, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+
+  for (i = 0; i < 1000; i++) {
+    key = i;
+    rv = hta_get(table, &key, &status);
+    if (i % 3 == 0) {
+      TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+      status = SMB_SUCCESS;
+    } else {
+      TA_INT_EQ(status, SMB_SUCCESS);
+      TA_INT_EQ((uintptr_t)rv % sizeof(double), 0);
+      memcpy(&value, rv, sizeof(value));
+      TEST_ASSERT(value == i / 2.0);
+    }
+  }
+
+  hta_set_aligned(table, false);
+  TA_INT_EQ(table->length, 666);
+  key = 998;
+  rv = hta_get(table, &key, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  memcpy(&value, rv, sizeof(value));
+  TEST_ASSERT(value == 499.0);
+
+  hta_delete(table);
+  return 0;
+}
+
+int hta_test_aligned()
+{
+  int rv = hta_test_aligned_mode(HTA_QUADRATIC);
+  if (rv) {
+    return rv;
+  }
+  rv = hta_test_aligned_mode(HTA_SWISS);
+  if (rv) {
+    return rv;
+  }
+  return hta_test_aligned_mode(HTA_ROBIN_HOOD);
+}
+
+typedef struct {
+  int a;
+  short b;
+  char c[6];
+} hta_test_key;
+
+/**
+   Without a hash function or comparator, keys are hashed and compared as bytes.
+ */
+int hta_test_bytewise()
+{
+  smb_status status = SMB_SUCCESS;
+  hta_test_key key;
+  int i, value, *rv;
+  smb_hta *table = hta_create(NULL, NULL, sizeof(hta_test_key), sizeof(int));
+
+  memset(&key, 0, sizeof(key));
+  for (i = 0; i < 200; i++) {
+    key.a = i;
+    key.b = -i;
+    key.c[5] = i % 7;
+    value = i;
+    hta_insert(table, &key, &value);
+  }
+  TA_INT_EQ(table->length, 200);
+
+  for (i = 0; i < 200; i++) {
+    key.a = i;
+    key.b = -i;
+    key.c[5] = i % 7;
+    rv = hta_get(table, &key, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+    TA_INT_EQ(hta_test_int(rv), i);
+    key.c[5]++;
+    TEST_ASSERT(!hta_contains(table, &key));
+  }
+
+  hta_delete(table);
+  return 0;
+}
+
+#define HTA_TEST_IMAGE "hta_image_test.bin"
+
+/**
+   Save a table (in the middle of an incremental resize) to an image, and check
+   that the mapped image has the same contents.
+ */
+int hta_test_image_mode(smb_hta_mode mode, bool aligned)
+{
+  smb_status status = SMB_SUCCESS;
+  int key, value, *rv;
+  int i;
+  smb_hta *mapped, copy;
+  smb_hta *table = hta_create_mode(&hta_test_linear_hash, &hta_int_comp,
+                                   sizeof(int), sizeof(int), mode);
+  hta_set_aligned(table, aligned);
+  hta_set_incremental(table, true);
+
+  for (i = 0; table->old_table == NULL || i < 1000; i++) {
+    key = i;
+    value = -i;
+    hta_insert(table, &key, &value);
+  }
+
+  hta_save(table, HTA_TEST_IMAGE, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  TEST_ASSERT(table->old_table != NULL);
+  mapped = hta_map(HTA_TEST_IMAGE, &hta_test_linear_hash, &hta_int_comp,
+                   &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  TA_INT_EQ(mapped->length, table->length);
+  TA_INT_EQ(mapped->seed, table->seed);
+  TA_INT_EQ(mapped->mode, mode);
+  TEST_ASSERT(mapped->old_table == NULL);
+
+  for (key = 0; key < i; key++) {
+    rv = hta_get(mapped, &key, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+    TA_INT_EQ(hta_test_int(rv), -key);
+  }
+  TEST_ASSERT(!hta_contains(mapped, &i));
+  key = 0;
+  hta_remove(mapped, &key, &status);
+  TA_INT_EQ(status, SMB_READ_ONLY_ERROR);
+  status = SMB_SUCCESS;
+  TEST_ASSERT(hta_contains(mapped, &key));
+
+  // A copy of a mapped table is an ordinary table.
+  hta_copy(&copy, mapped);
+  hta_delete(mapped);
+  hta_insert(&copy, &i, &i);
+  TA_INT_EQ(copy.length, table->length + 1);
+  key = 0;
+  TEST_ASSERT(hta_contains(&copy, &key));
+  hta_destroy(&copy);
+
+  unlink(HTA_TEST_IMAGE);
+  hta_delete(table);
+  return 0;
+}
+
+int hta_test_image()
+{
+  int rv = hta_test_image_mode(HTA_QUADRATIC, false);
+  if (rv) {
+    return rv;
+  }
+  rv = hta_test_image_mode(HTA_QUADRATIC, true);
+  if (rv) {
+    return rv;
+  }
+  rv = hta_test_image_mode(HTA_SWISS, false);
+  if (rv) {
+    return rv;
+  }
+  return hta_test_image_mode(HTA_ROBIN_HOOD, false);
+}
+
+/**
+   Overwrite the header of the test image, and return whether hta_map() then
+   rejects it with SMB_FORMAT_ERROR.
+ */
+static bool hta_test_image_rejects(const smb_hta_image_header *header)
+{
+  smb_status status = SMB_SUCCESS;
+  smb_hta *mapped;
+  FILE *f = fopen(HTA_TEST_IMAGE, "r+b");
+  if (!f || fwrite(header, sizeof(*header), 1, f) != 1) {
+    return false;
+  }
+  fclose(f);
+  mapped = hta_map(HTA_TEST_IMAGE, NULL, NULL, &status);
+  if (mapped) {
+    hta_delete(mapped);
+    return false;
+  }
+  return status == SMB_FORMAT_ERROR;
+}
+
+int hta_test_image_invalid()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_hta_image_header header, corrupt;
+  FILE *f;
+  smb_hta *table = hta_create(&hta_test_linear_hash, &hta_int_comp,
+                              sizeof(int), sizeof(int));
+
+  TEST_ASSERT(hta_map("no such file", NULL, NULL, &status) == NULL);
+  TA_INT_EQ(status, SMB_IO_ERROR);
+
+  // A truncated image.
+  hta_save(table, HTA_TEST_IMAGE, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  TEST_ASSERT(truncate(HTA_TEST_IMAGE, HTA_IMAGE_ALIGN + 10) == 0);
+  TEST_ASSERT(hta_map(HTA_TEST_IMAGE, NULL, NULL, &status) == NULL);
+  TA_INT_EQ(status, SMB_FORMAT_ERROR);
+
+  // An image from a future version.
+  hta_save(table, HTA_TEST_IMAGE, &status);
+  f = fopen(HTA_TEST_IMAGE, "r+b");
+  TEST_ASSERT(fread(&header, sizeof(header), 1, f) == 1);
+  header.version++;
+  rewind(f);
+  TEST_ASSERT(fwrite(&header, sizeof(header), 1, f) == 1);
+  fclose(f);
+  TEST_ASSERT(hta_map(HTA_TEST_IMAGE, NULL, NULL, &status) == NULL);
+  TA_INT_EQ(status, SMB_FORMAT_ERROR);
+
+  // Offsets so large that the end of their region wraps around.
+  hta_set_aligned(table, true);
+  hta_save(table, HTA_TEST_IMAGE, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  f = fopen(HTA_TEST_IMAGE, "rb");
+  TEST_ASSERT(fread(&header, sizeof(header), 1, f) == 1);
+  fclose(f);
+  TEST_ASSERT(header.ctrl_offset != 0);
+  corrupt = header;
+  corrupt.table_offset = UINT64_MAX & ~(uint64_t) (HTA_IMAGE_ALIGN - 1);
+  TEST_ASSERT(hta_test_image_rejects(&corrupt));
+  corrupt = header;
+  corrupt.ctrl_offset = UINT64_MAX - header.allocated / 2;
+  TEST_ASSERT(hta_test_image_rejects(&corrupt));
+  TEST_ASSERT(!hta_test_image_rejects(&header));
+
+  unlink(HTA_TEST_IMAGE);
+  hta_delete(table);
+  return 0;
+}
+
+/**
+   Check lookups, updates and removals while an incremental resize is in
+   progress, in each mode.
+ */
+int hta_test_incremental_mode(smb_hta_mode mode)
+{
+  smb_status status = SMB_SUCCESS;
+  int key, value, *rv;
+  int i, j;
+  bool saw_old = false;
+  smb_hta *table = hta_create_mode(&hta_test_linear_hash, &hta_int_comp,
+                                   sizeof(int), sizeof(int), mode);
+  hta_set_incremental(table, true);
+
+  for (i = 0; i < 500; i++) {
+    key = i;
+    value = -i;
+    hta_insert(table, &key, &value);
+    saw_old = saw_old || table->old_table != NULL;
+    for (j = 0; j <= i; j += 7) {
+      rv = hta_get(table, &j, &status);
+      TA_INT_EQ(status, SMB_SUCCESS);
+      TA_INT_EQ(hta_test_int(rv), -j);
+    }
+  }
+  TEST_ASSERT(saw_old);
+
+  while (table->old_table == NULL) {
+    key = i;
+    value = -i;
+    hta_insert(table, &key, &value);
+    i++;
+  }
+  key = 1;
+  value = 100;
+  hta_insert(table, &key, &value);
+  key = 2;
+  hta_remove(table, &key, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  TEST_ASSERT(!hta_contains(table, &key));
+  key = 1;
+  rv = hta_get(table, &key, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  TA_INT_EQ(hta_test_int(rv), 100);
+
+  hta_set_incremental(table, false);
+  TEST_ASSERT(table->old_table == NULL);
+  TA_INT_EQ((int) table->length, i - 1);
+
+  hta_delete(table);
+  return 0;
+}
+
+int hta_test_incremental()
+{
+  int rv = hta_test_incremental_mode(HTA_QUADRATIC);
+  if (rv) {
+    return rv;
+  }
+  rv = hta_test_incremental_mode(HTA_SWISS);
+  if (rv) {
+    return rv;
+  }
+  return hta_test_incremental_mode(HTA_ROBIN_HOOD);
+}
+
+int hta_test_insert_many_mode(smb_hta_mode mode)
+{
+  smb_status status = SMB_SUCCESS;
+  int keys[3000], values[3000], *rv;
+  unsigned int i, reserved;
+  smb_hta *table = hta_create_mode(&hta_test_linear_hash, &hta_int_comp,
+                                   sizeof(int), sizeof(int), mode);
+
+  for (i = 0; i < 3000; i++) {
+    keys[i] = i;
+    values[i] = -i;
+  }
+
+  hta_reserve(table, 3000);
+  reserved = table->allocated;
+  hta_insert_many(table, keys, values, 3000);
+  TA_INT_EQ(table->allocated, reserved);
+  TA_INT_EQ(table->length, 3000);
+
+  for (i = 0; i < 3000; i++) {
+    rv = hta_get(table, &keys[i], &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+    TA_INT_EQ(hta_test_int(rv), -(int)i);
+  }
+
+  hta_delete(table);
+  return 0;
+}
+
+int hta_test_insert_many()
+{
+  int rv = hta_test_insert_many_mode(HTA_QUADRATIC);
+  if (rv) {
+    return rv;
+  }
+  rv = hta_test_insert_many_mode(HTA_SWISS);
+  if (rv) {
+    return rv;
+  }
+  return hta_test_insert_many_mode(HTA_ROBIN_HOOD);
+}
+
 void hta_test()
 {
   smb_ut_group *group = su_create_test_group("test/hta.c");
@@ -277,6 +924,42 @@ void hta_test()
   smb_ut_test *duplicate = su_create_test("duplicate", hta_test_duplicate);
   su_add_test(group, duplicate);
 
+  smb_ut_test *swiss_insert = su_create_test("swiss_insert", hta_test_swiss_insert);
+  su_add_test(group, swiss_insert);
+
+  smb_ut_test *swiss_buckets = su_create_test("swiss_buckets", hta_test_swiss_buckets);
+  su_add_test(group, swiss_buckets);
+
+  smb_ut_test *swiss_resize = su_create_test("swiss_resize", hta_test_swiss_resize);
+  su_add_test(group, swiss_resize);
+
+  smb_ut_test *robin_hood_buckets = su_create_test("robin_hood_buckets", hta_test_robin_hood_buckets);
+  su_add_test(group, robin_hood_buckets);
+
+  smb_ut_test *robin_hood_remove = su_create_test("robin_hood_remove", hta_test_robin_hood_remove);
+  su_add_test(group, robin_hood_remove);
+
+  smb_ut_test *stats = su_create_test("stats", hta_test_stats);
+  su_add_test(group, stats);
+
+  smb_ut_test *aligned = su_create_test("aligned", hta_test_aligned);
+  su_add_test(group, aligned);
+
+  smb_ut_test *bytewise = su_create_test("bytewise", hta_test_bytewise);
+  su_add_test(group, bytewise);
+
+  smb_ut_test *image = su_create_test("image", hta_test_image);
+  su_add_test(group, image);
+
+  smb_ut_test *image_invalid = su_create_test("image_invalid", hta_test_image_invalid);
+  su_add_test(group, image_invalid);
+
+  smb_ut_test *incremental = su_create_test("incremental", hta_test_incremental);
+  su_add_test(group, incremental);
+
+  smb_ut_test *insert_many = su_create_test("insert_many", hta_test_insert_many);
+  su_add_test(group, insert_many);
+
   su_run_group(group);
   su_delete_group(group);
 }
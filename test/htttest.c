@@ -0,0 +1,141 @@
+/***************************************************************************//**
+
+  @file         htttest.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Tests for the generated hash tables.
+
+  @copyright    Copyright (c) 2013-2016, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#include <stdio.h>
+
+#include "tests.h"
+#include "libstephen/ut.h"
+#include "libstephen/htt.h"
+
+SMB_HTT_INIT(iimap, long long, long long, smb_htt_int_hash, smb_htt_int_equal)
+SMB_HTT_INIT(strmap, const char *, void *, smb_htt_str_hash, smb_htt_str_equal)
+
+int htt_test_int()
+{
+  smb_status status = SMB_SUCCESS;
+  long long i;
+  smb_htt_iimap *table = htt_iimap_create();
+
+  for (i = 0; i < 5000; i++) {
+    htt_iimap_insert(table, i * 7, -i);
+  }
+  TA_INT_EQ(table->length, 5000);
+  TA_INT_GT(table->allocated, 10000);
+
+  // Overwrite every other value, then remove every third key.
+  for (i = 0; i < 5000; i += 2) {
+    htt_iimap_insert(table, i * 7, i);
+  }
+  TA_INT_EQ(table->length, 5000);
+  for (i = 0; i < 5000; i += 3) {
+    htt_iimap_remove(table, i * 7, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+  htt_iimap_remove(table, 0, &status);
+  TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+
+  for (i = 0; i < 5000; i++) {
+    long long value = htt_iimap_get(table, i * 7, &status);
+    if (i % 3 == 0) {
+      TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+      TEST_ASSERT(!htt_iimap_contains(table, i * 7));
+    } else {
+      TA_INT_EQ(status, SMB_SUCCESS);
+      TA_LLINT_EQ(value, i % 2 == 0 ? i : -i);
+    }
+    TEST_ASSERT(!htt_iimap_contains(table, i * 7 + 1));
+  }
+
+  htt_iimap_delete(table);
+  return 0;
+}
+
+/**
+   Churn through keys while keeping the table small, so that graves build up
+   and have to be cleared by rehashing.
+ */
+int htt_test_graves()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_htt_iimap table;
+  long long i;
+
+  htt_iimap_init(&table);
+  for (i = 0; i < 10000; i++) {
+    htt_iimap_insert(&table, i, i);
+    if (i >= 10) {
+      htt_iimap_remove(&table, i - 10, &status);
+      TA_INT_EQ(status, SMB_SUCCESS);
+    }
+  }
+  TA_INT_EQ(table.length, 10);
+  TA_INT_EQ(table.allocated, HASH_TABLE_INITIAL_SIZE);
+  for (i = 9990; i < 10000; i++) {
+    TEST_ASSERT(htt_iimap_contains(&table, i));
+  }
+
+  htt_iimap_destroy(&table);
+  return 0;
+}
+
+int htt_test_string()
+{
+  smb_status status = SMB_SUCCESS;
+  char buf[2][16];
+  int value = 5;
+  unsigned int i, count = 0;
+  smb_htt_strmap *table = htt_strmap_create();
+
+  htt_strmap_reserve(table, 100);
+  TA_INT_EQ(table->allocated, 256);
+
+  // Lookups compare the strings, not the pointers.
+  sprintf(buf[0], "key");
+  sprintf(buf[1], "key");
+  htt_strmap_insert(table, buf[0], &value);
+  htt_strmap_insert(table, "other key", NULL);
+  TA_PTR_EQ(htt_strmap_get(table, buf[1], &status), &value);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  TA_PTR_EQ(htt_strmap_get(table, "missing", &status), NULL);
+  TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+
+  for (i = 0; i < table->allocated; i++) {
+    if (SMB_HTT_FULL(table, i)) {
+      count++;
+    }
+  }
+  TA_INT_EQ(count, 2);
+  TA_INT_EQ(table->allocated, 256);
+
+  htt_strmap_delete(table);
+  return 0;
+}
+
+void htt_test(void)
+{
+  smb_ut_group *group = su_create_test_group("test/htttest.c");
+
+  smb_ut_test *int_keys = su_create_test("int_keys", htt_test_int);
+  su_add_test(group, int_keys);
+
+  smb_ut_test *graves = su_create_test("graves", htt_test_graves);
+  su_add_test(group, graves);
+
+  smb_ut_test *string = su_create_test("string", htt_test_string);
+  su_add_test(group, string);
+
+  su_run_group(group);
+  su_delete_group(group);
+}
@@ -18,6 +18,7 @@
 #include "libstephen/list.h"
 #include "libstephen/ll.h"
 #include "libstephen/al.h"
+#include "libstephen/ul.h"
 
 // Setup and tear down declarations.
 
@@ -178,6 +179,31 @@ void ll_cleanup(void)
   ll_delete(test_data);
 }
 
+/**
+   @brief Return an unrolled list iterator.
+   @param Number of elements in the list.
+   @return An iterator.
+ */
+smb_iter get_ul_iter(int size)
+{
+  test_data = ul_create();
+
+  for (int i = 0; i < size; i++) {
+    DATA d = { .data_llint = 100 * i };
+    ul_append(test_data, d);
+  }
+
+  return ul_get_iter(test_data);
+}
+
+/**
+   @brief Clean up unrolled list.
+ */
+void ul_cleanup(void)
+{
+  ul_delete(test_data);
+}
+
 /*******************************************************************************
 
                                   Test Running
@@ -227,4 +253,8 @@ void iter_test(void)
   get_iter = &get_ll_iter;
   cleanup = &ll_cleanup;
   run_tests("ll: test/itertest.c");
+
+  get_iter = &get_ul_iter;
+  cleanup = &ul_cleanup;
+  run_tests("ul: test/itertest.c");
 }
@@ -75,6 +75,100 @@ int ll_test_sort_empty()
   return 0;
 }
 
+/**
+   Number of comparisons made by ll_test_key_compare().
+ */
+static int ll_test_comparisons;
+
+/**
+   Compare items by key (the value divided by 1000), ignoring the rest, which
+   holds the item's original position.
+ */
+static int ll_test_key_compare(DATA d1, DATA d2)
+{
+  ll_test_comparisons++;
+  return data_compare_int(LLINT(d1.data_llint / 1000),
+                          LLINT(d2.data_llint / 1000));
+}
+
+/**
+   Sort a list of n keys, given by key(i), and check that it is sorted, stable,
+   and correctly linked in both directions.
+ */
+static int ll_test_sort_keys(int n, long long (*key)(int))
+{
+  smb_ll *list = ll_create();
+  smb_ll_node *node, *prev = NULL;
+  int i, count = 0;
+
+  for (i = 0; i < n; i++) {
+    ll_append(list, LLINT(key(i) * 1000 + i));
+  }
+  ll_test_comparisons = 0;
+  ll_sort(list, ll_test_key_compare);
+
+  for (node = list->head; node; node = node->next) {
+    TA_PTR_EQ(node->prev, prev);
+    if (prev) {
+      TA_LLINT_LE(prev->data.data_llint / 1000, node->data.data_llint / 1000);
+      if (prev->data.data_llint / 1000 == node->data.data_llint / 1000) {
+        // Equal keys keep their original order.
+        TA_LLINT_LT(prev->data.data_llint % 1000, node->data.data_llint % 1000);
+      }
+    }
+    prev = node;
+    count++;
+  }
+  TA_PTR_EQ(list->tail, prev);
+  TA_INT_EQ(count, n);
+
+  ll_delete(list);
+  return 0;
+}
+
+static long long ll_test_key_ascending(int i) { return i; }
+static long long ll_test_key_descending(int i) { return 1000 - i; }
+static long long ll_test_key_steps(int i) { return 200 - i / 7; }
+static long long ll_test_key_scrambled(int i) { return (i * 7919) % 37; }
+static long long ll_test_key_sawtooth(int i) { return i % 50; }
+
+int ll_test_sort_stable()
+{
+  int rv;
+  rv = ll_test_sort_keys(999, ll_test_key_scrambled);
+  if (rv) {
+    return rv;
+  }
+  rv = ll_test_sort_keys(999, ll_test_key_steps);
+  if (rv) {
+    return rv;
+  }
+  rv = ll_test_sort_keys(999, ll_test_key_sawtooth);
+  if (rv) {
+    return rv;
+  }
+  return ll_test_sort_keys(1, ll_test_key_scrambled);
+}
+
+/**
+   Sorted and reversed input are each one run, so they take linear time.
+ */
+int ll_test_sort_runs()
+{
+  int rv;
+  rv = ll_test_sort_keys(999, ll_test_key_ascending);
+  if (rv) {
+    return rv;
+  }
+  TA_INT_EQ(ll_test_comparisons, 998);
+  rv = ll_test_sort_keys(999, ll_test_key_descending);
+  if (rv) {
+    return rv;
+  }
+  TA_INT_EQ(ll_test_comparisons, 998);
+  return 0;
+}
+
 static bool is_even(DATA d) {
   return d.data_llint % 2 == 0;
 }
@@ -231,6 +325,209 @@ int ll_test_foldr(void)
   return 0;
 }
 
+/**
+   Use a list as a queue.  Once the pool has enough nodes, removed nodes should
+   be reused, so the pool never grows again.
+ */
+int ll_test_pool_reuse(void)
+{
+  smb_status status = SMB_SUCCESS;
+  smb_ll *list = ll_create();
+  smb_ll_node *slabs;
+  long long i, next = 0;
+
+  ll_reserve(list, 100);
+  TA_INT_EQ(list->pool->available, 100);
+  slabs = list->pool->slabs;
+  for (i = 0; i < 100000; i++) {
+    ll_push_back(list, LLINT(i));
+    if (ll_length(list) == 100) {
+      while (ll_length(list) > 50) {
+        TA_LLINT_EQ(ll_pop_front(list, &status).data_llint, next);
+        next++;
+      }
+    }
+  }
+  TA_PTR_EQ(list->pool->slabs, slabs);
+  TA_INT_EQ(list->pool->available + ll_length(list), 100);
+
+  ll_delete(list);
+  return 0;
+}
+
+/**
+   Nodes taken from a fresh pool are laid out in the order they were added.
+ */
+int ll_test_pool_locality(void)
+{
+  smb_ll *list = ll_create();
+  smb_ll_node *node;
+  int i;
+
+  ll_reserve(list, 1000);
+  for (i = 0; i < 1000; i++) {
+    ll_append(list, LLINT(i));
+  }
+  for (node = list->head; node->next; node = node->next) {
+    TA_PTR_EQ(node->next, node + 1);
+  }
+
+  ll_delete(list);
+  return 0;
+}
+
+/**
+   Two lists sharing a pool: destroying one gives its nodes to the other.
+ */
+int ll_test_pool_shared(void)
+{
+  smb_status status = SMB_SUCCESS;
+  smb_ll_pool pool;
+  smb_ll *first, *second;
+  smb_ll_node *slabs;
+  int i;
+
+  ll_pool_init(&pool);
+  first = ll_create_shared(&pool);
+  second = ll_create_shared(&pool);
+  for (i = 0; i < 500; i++) {
+    ll_append(first, LLINT(i));
+  }
+  slabs = pool.slabs;
+  ll_delete(first);
+  TA_INT_GE(pool.available, 500);
+
+  for (i = 0; i < 500; i++) {
+    ll_prepend(second, LLINT(i));
+  }
+  TA_PTR_EQ(pool.slabs, slabs);
+  TA_INT_EQ(ll_length(second), 500);
+  TA_LLINT_EQ(ll_get(second, 0, &status).data_llint, 499LL);
+  TA_LLINT_EQ(ll_get(second, 499, &status).data_llint, 0LL);
+
+  ll_delete(second);
+  ll_pool_destroy(&pool);
+  return 0;
+}
+
+/**
+   Check that the finger, if set, points at the node with its index.
+ */
+static int ll_test_check_finger(const smb_ll *list)
+{
+  const smb_ll_node *node = list->head;
+  int i;
+  if (!list->finger) {
+    return 0;
+  }
+  TA_INT_GE(list->finger_index, 0);
+  TA_INT_LT(list->finger_index, list->length);
+  for (i = 0; i < list->finger_index; i++) {
+    node = node->next;
+  }
+  TA_PTR_EQ(list->finger, node);
+  return 0;
+}
+
+/**
+   Indexed access through the generic interface leaves the finger at the index
+   it used, so a loop by index only steps one node each time.
+ */
+int ll_test_finger_sequential()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_ll *list = ll_create();
+  smb_list generic = ll_cast_to_list(list);
+  int i;
+
+  for (i = 0; i < 10000; i++) {
+    ll_append(list, LLINT(i));
+  }
+  for (i = 0; i < 10000; i++) {
+    TA_LLINT_EQ(list_get(&generic, i, &status).data_llint, (long long) i);
+    TA_PTR_NE(list->finger, NULL);
+    TA_INT_EQ(list->finger_index, i);
+  }
+  for (i = 9999; i >= 0; i -= 2) {
+    list_set(&generic, i, LLINT(-i), &status);
+    TA_INT_EQ(list->finger_index, i);
+  }
+  // Remove every other item going forward: each removal starts at the finger.
+  for (i = 0; i < 5000; i++) {
+    list_remove(&generic, i, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+  for (i = 0; i < 5000; i++) {
+    TA_LLINT_EQ(ll_get(list, i, &status).data_llint, (long long) -(2 * i + 1));
+  }
+
+  list_delete(&generic);
+  return 0;
+}
+
+/**
+   Mix every kind of change with indexed access, checking the contents and the
+   finger after each step.
+ */
+int ll_test_finger_mixed()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_ll *list = ll_create();
+  long long expect[3000];
+  int i, j, n = 0, index, op, rv;
+
+  for (i = 0; i < 3000; i++) {
+    index = n ? (i * 7919) % n : 0;
+    op = (i * 31) % 7;
+    if (n == 0 || op == 0) {
+      ll_insert(list, index, LLINT(i));
+      for (j = n; j > index; j--) {
+        expect[j] = expect[j - 1];
+      }
+      expect[index] = i;
+      n++;
+    } else if (op == 1) {
+      ll_prepend(list, LLINT(i));
+      for (j = n; j > 0; j--) {
+        expect[j] = expect[j - 1];
+      }
+      expect[0] = i;
+      n++;
+    } else if (op == 2) {
+      ll_remove(list, index, &status);
+      for (j = index; j < n - 1; j++) {
+        expect[j] = expect[j + 1];
+      }
+      n--;
+    } else if (op == 3) {
+      TA_LLINT_EQ(ll_pop_front(list, &status).data_llint, expect[0]);
+      for (j = 0; j < n - 1; j++) {
+        expect[j] = expect[j + 1];
+      }
+      n--;
+    } else if (op == 4) {
+      TA_LLINT_EQ(ll_pop_back(list, &status).data_llint, expect[n - 1]);
+      n--;
+    } else if (op == 5) {
+      ll_append(list, LLINT(i));
+      expect[n++] = i;
+    } else {
+      TA_LLINT_EQ(ll_get(list, index, &status).data_llint, expect[index]);
+    }
+    TA_INT_EQ(ll_length(list), n);
+    rv = ll_test_check_finger(list);
+    if (rv) {
+      return rv;
+    }
+  }
+  for (i = 0; i < n; i++) {
+    TA_LLINT_EQ(ll_get(list, i, &status).data_llint, expect[i]);
+  }
+
+  ll_delete(list);
+  return 0;
+}
+
 void linked_list_test()
 {
   // Use the smbunit test framework.  Load tests and run them.
@@ -248,6 +545,12 @@ void linked_list_test()
   smb_ut_test *sort_empty = su_create_test("sort_empty", ll_test_sort_empty);
   su_add_test(group, sort_empty);
 
+  smb_ut_test *sort_stable = su_create_test("sort_stable", ll_test_sort_stable);
+  su_add_test(group, sort_stable);
+
+  smb_ut_test *sort_runs = su_create_test("sort_runs", ll_test_sort_runs);
+  su_add_test(group, sort_runs);
+
   smb_ut_test *filter_empty = su_create_test("filter_empty", ll_test_filter_empty);
   su_add_test(group, filter_empty);
 
@@ -275,6 +578,21 @@ void linked_list_test()
   smb_ut_test *foldr = su_create_test("foldr", ll_test_foldr);
   su_add_test(group, foldr);
 
+  smb_ut_test *pool_reuse = su_create_test("pool_reuse", ll_test_pool_reuse);
+  su_add_test(group, pool_reuse);
+
+  smb_ut_test *pool_locality = su_create_test("pool_locality", ll_test_pool_locality);
+  su_add_test(group, pool_locality);
+
+  smb_ut_test *pool_shared = su_create_test("pool_shared", ll_test_pool_shared);
+  su_add_test(group, pool_shared);
+
+  smb_ut_test *finger_sequential = su_create_test("finger_sequential", ll_test_finger_sequential);
+  su_add_test(group, finger_sequential);
+
+  smb_ut_test *finger_mixed = su_create_test("finger_mixed", ll_test_finger_mixed);
+  su_add_test(group, finger_mixed);
+
   su_run_group(group);
   su_delete_group(group);
 }
@@ -19,6 +19,7 @@
 #include "libstephen/list.h"
 #include "libstephen/ll.h"
 #include "libstephen/al.h"
+#include "libstephen/ul.h"
 #include "libstephen/ut.h"
 #include "tests.h"
 
@@ -45,17 +46,17 @@ int test_append()
   for (d.data_llint = 0; d.data_llint < 200; d.data_llint++) {
     // Put a small, 200 item load on it.  This tests appending on
     // empty and general appending.
-    list.append(&list, d);
-    TA_LLINT_EQ((long long)list.length(&list), d.data_llint + 1);
+    list_append(&list, d);
+    TA_LLINT_EQ((long long)list_length(&list), d.data_llint + 1);
 
     // Test that the data is correct.
-    for (int i = 0; i < list.length(&list); i++) {
-      TA_LLINT_EQ(list.get(&list, i, &status).data_llint, (long long) i);
+    for (int i = 0; i < list_length(&list); i++) {
+      TA_LLINT_EQ(list_get(&list, i, &status).data_llint, (long long) i);
       TA_INT_EQ(status, SMB_SUCCESS);
     }
   }
 
-  list.delete(&list);
+  list_delete(&list);
   return 0;
 }
 
@@ -67,16 +68,16 @@ int test_prepend()
 
   // Test prepend about 200 times...
   for (d.data_llint = 0; d.data_llint < 200; d.data_llint++) {
-    list.prepend(&list, d);
-    TA_LLINT_EQ((long long)list.length(&list), d.data_llint + 1);
+    list_prepend(&list, d);
+    TA_LLINT_EQ((long long)list_length(&list), d.data_llint + 1);
 
-    for (int i = 0; i < list.length(&list); i++) {
-      TA_LLINT_EQ(list.get(&list, i, &status).data_llint, d.data_llint - i);
+    for (int i = 0; i < list_length(&list); i++) {
+      TA_LLINT_EQ(list_get(&list, i, &status).data_llint, d.data_llint - i);
       TA_INT_EQ(status, SMB_SUCCESS);
     }
   }
 
-  list.delete(&list);
+  list_delete(&list);
   return 0;
 }
 
@@ -89,38 +90,38 @@ int test_set()
 
   // Create the data
   for (d.data_llint = 0 ; d.data_llint < length; d.data_llint++) {
-    list.append(&list, d);
+    list_append(&list, d);
   }
 
   // Verify the data
   for (d.data_llint = 0 ; d.data_llint < length; d.data_llint++) {
-    TA_LLINT_EQ(list.get(&list, d.data_llint, &status).data_llint, d.data_llint);
+    TA_LLINT_EQ(list_get(&list, d.data_llint, &status).data_llint, d.data_llint);
     TA_INT_EQ(status, SMB_SUCCESS);
   }
 
   // Test that the length is correct
-  TA_INT_EQ(list.length(&list), length);
+  TA_INT_EQ(list_length(&list), length);
 
   // Test set
-  for (int i = 0; i < list.length(&list); i++) {
+  for (int i = 0; i < list_length(&list); i++) {
     d.data_llint = length - i;
-    list.set(&list, i, d, &status);
+    list_set(&list, i, d, &status);
     TA_INT_EQ(status, SMB_SUCCESS);
-    TA_LLINT_EQ(list.get(&list, i, &status).data_llint, d.data_llint);
+    TA_LLINT_EQ(list_get(&list, i, &status).data_llint, d.data_llint);
     TA_INT_EQ(status, SMB_SUCCESS);
   }
 
   // Test that the length is still correct
-  TA_INT_EQ(list.length(&list), length);
+  TA_INT_EQ(list_length(&list), length);
 
-  list.set(&list, list.length(&list), d, &status);
+  list_set(&list, list_length(&list), d, &status);
   TA_INT_EQ(status, SMB_INDEX_ERROR);
 
   status = SMB_SUCCESS;
-  list.get(&list, list.length(&list), &status);
+  list_get(&list, list_length(&list), &status);
   TA_INT_EQ(status, SMB_INDEX_ERROR);
 
-  list.delete(&list);
+  list_delete(&list);
   return 0;
 }
 
@@ -133,39 +134,39 @@ int test_remove()
 
   // Create the data
   for (d.data_llint = 0 ; d.data_llint < length; d.data_llint++) {
-    list.append(&list, d);
+    list_append(&list, d);
   }
 
   // Verify the data
   for (d.data_llint = 0 ; d.data_llint < length; d.data_llint++) {
-    TA_LLINT_EQ(list.get(&list, d.data_llint, &status).data_llint, d.data_llint);
+    TA_LLINT_EQ(list_get(&list, d.data_llint, &status).data_llint, d.data_llint);
     TA_INT_EQ(status, SMB_SUCCESS);
   }
 
   // Remove first element
-  list.remove(&list, 0, &status);
+  list_remove(&list, 0, &status);
   TA_INT_EQ(status, SMB_SUCCESS);
-  TA_INT_EQ(list.length(&list), length - 1);
-  TA_LLINT_EQ(list.get(&list, 0, &status).data_llint, (long long) 1);
+  TA_INT_EQ(list_length(&list), length - 1);
+  TA_LLINT_EQ(list_get(&list, 0, &status).data_llint, (long long) 1);
   TA_INT_EQ(status, SMB_SUCCESS);
 
   // Remove middle element
-  list.remove(&list, 10, &status); // list[10] == 11 before
+  list_remove(&list, 10, &status); // list[10] == 11 before
   TA_INT_EQ(status, SMB_SUCCESS);
-  TA_INT_EQ(list.length(&list), length - 2);
-  TA_LLINT_EQ(list.get(&list, 10, &status).data_llint, (long long) 12);
+  TA_INT_EQ(list_length(&list), length - 2);
+  TA_LLINT_EQ(list_get(&list, 10, &status).data_llint, (long long) 12);
   TA_INT_EQ(status, SMB_SUCCESS);
 
   // Remove last element
-  list.remove(&list, list.length(&list) - 1, &status);
+  list_remove(&list, list_length(&list) - 1, &status);
   TA_INT_EQ(status, SMB_SUCCESS);
-  TA_INT_EQ(list.length(&list), length - 3);
+  TA_INT_EQ(list_length(&list), length - 3);
 
   // Remove invalid element
-  list.remove(&list, list.length(&list), &status);
+  list_remove(&list, list_length(&list), &status);
   TA_INT_EQ(status, SMB_INDEX_ERROR);
   status = SMB_SUCCESS;
-  list.remove(&list, -1, &status);
+  list_remove(&list, -1, &status);
   TA_INT_EQ(status, SMB_INDEX_ERROR);
   status = SMB_SUCCESS;
 
@@ -173,12 +174,12 @@ int test_remove()
   int value = 1;
   for (int i = 0; i < length - 3; i++) {
     if (i == 10) value++;
-    TA_LLINT_EQ(list.get(&list, i, &status).data_llint, (long long)value);
+    TA_LLINT_EQ(list_get(&list, i, &status).data_llint, (long long)value);
     TA_INT_EQ(status, SMB_SUCCESS);
     value++;
   }
 
-  list.delete(&list);
+  list_delete(&list);
   return 0;
 }
 
@@ -191,63 +192,63 @@ int test_insert()
 
   // Create the data
   for (d.data_llint = 0 ; d.data_llint < length; d.data_llint++) {
-    list.append(&list, d);
+    list_append(&list, d);
   }
 
   // Verify the data
   for (d.data_llint = 0 ; d.data_llint < length; d.data_llint++) {
-    TA_LLINT_EQ(list.get(&list, d.data_llint, &status).data_llint, d.data_llint);
+    TA_LLINT_EQ(list_get(&list, d.data_llint, &status).data_llint, d.data_llint);
     TA_INT_EQ(status, SMB_SUCCESS);
   }
 
   // Here are the insertions for the test:
   d.data_llint = 100;
-  list.insert(&list, 0, d);
-  TA_INT_EQ(list.length(&list), length + 1);
+  list_insert(&list, 0, d);
+  TA_INT_EQ(list_length(&list), length + 1);
 
   d.data_llint = 101;
-  list.insert(&list, 10, d);
-  TA_INT_EQ(list.length(&list), length + 2);
+  list_insert(&list, 10, d);
+  TA_INT_EQ(list_length(&list), length + 2);
 
   d.data_llint = 102;
-  list.insert(&list, list.length(&list), d);
-  TA_INT_EQ(list.length(&list), length + 3);
+  list_insert(&list, list_length(&list), d);
+  TA_INT_EQ(list_length(&list), length + 3);
 
 
   d.data_llint = 101;
-  list.insert(&list, -1, d);
-  TA_INT_EQ(list.length(&list), length + 4);
+  list_insert(&list, -1, d);
+  TA_INT_EQ(list_length(&list), length + 4);
 
   d.data_llint = 102;
-  list.insert(&list, list.length(&list) + 1, d);
-  TA_INT_EQ(list.length(&list), length + 5);
+  list_insert(&list, list_length(&list) + 1, d);
+  TA_INT_EQ(list_length(&list), length + 5);
 
   int value = 0;
 
-  for (int i = 0; i < list.length(&list); i++) {
+  for (int i = 0; i < list_length(&list); i++) {
     if (i == 0) {
-      TA_LLINT_EQ(list.get(&list, i, &status).data_llint, (long long)101);
+      TA_LLINT_EQ(list_get(&list, i, &status).data_llint, (long long)101);
       TA_INT_EQ(status, SMB_SUCCESS);
     } else if (i == 1) {
-      TA_LLINT_EQ(list.get(&list, i, &status).data_llint, (long long)100);
+      TA_LLINT_EQ(list_get(&list, i, &status).data_llint, (long long)100);
       TA_INT_EQ(status, SMB_SUCCESS);
     } else if (i == 11) {
-      TA_LLINT_EQ(list.get(&list, i, &status).data_llint, (long long) 101);
+      TA_LLINT_EQ(list_get(&list, i, &status).data_llint, (long long) 101);
       TA_INT_EQ(status, SMB_SUCCESS);
-    } else if (i == list.length(&list) - 2) {
-      TA_LLINT_EQ(list.get(&list, i, &status).data_llint, (long long) 102);
+    } else if (i == list_length(&list) - 2) {
+      TA_LLINT_EQ(list_get(&list, i, &status).data_llint, (long long) 102);
       TA_INT_EQ(status, SMB_SUCCESS);
-    } else if (i == list.length(&list) - 1) {
-      TA_LLINT_EQ(list.get(&list, i, &status).data_llint, (long long) 102);
+    } else if (i == list_length(&list) - 1) {
+      TA_LLINT_EQ(list_get(&list, i, &status).data_llint, (long long) 102);
       TA_INT_EQ(status, SMB_SUCCESS);
     } else {
-      TA_LLINT_EQ(list.get(&list, i, &status).data_llint, (long long) value);
+      TA_LLINT_EQ(list_get(&list, i, &status).data_llint, (long long) value);
       TA_INT_EQ(status, SMB_SUCCESS);
       value++;
     }
   }
 
-  list.delete(&list);
+  list_delete(&list);
   return 0;
 }
 
@@ -260,28 +261,28 @@ int test_front(void)
 
   // Push test data to get 0, 1, 2, 3, 4
   for (d.data_llint = length-1; d.data_llint >= 0; d.data_llint--) {
-    list.push_front(&list, d);
+    list_push_front(&list, d);
   }
 
   // Test that peek works correctly with data.
-  TA_LLINT_EQ(list.peek_front(&list, &status).data_llint, (long long) 0);
+  TA_LLINT_EQ(list_peek_front(&list, &status).data_llint, (long long) 0);
   TA_INT_EQ(status, SMB_SUCCESS);
 
   // Check that pop works correctly.
   for (d.data_llint = 0; d.data_llint < length; d.data_llint++) {
-    TA_LLINT_EQ(list.pop_front(&list, &status).data_llint, d.data_llint);
+    TA_LLINT_EQ(list_pop_front(&list, &status).data_llint, d.data_llint);
     TA_INT_EQ(status, SMB_SUCCESS);
   }
 
   // Check that peek and pop will fail correctly.
-  list.peek_front(&list, &status);
+  list_peek_front(&list, &status);
   TA_INT_EQ(status, SMB_INDEX_ERROR);
   status = SMB_SUCCESS;
-  list.pop_front(&list, &status);
+  list_pop_front(&list, &status);
   TA_INT_EQ(status, SMB_INDEX_ERROR);
 
   // Cleanup
-  list.delete(&list);
+  list_delete(&list);
   return 0;
 }
 
@@ -294,28 +295,28 @@ int test_back(void)
 
   // Push test data to get 0, 1, 2, 3, 4
   for (d.data_llint = 0; d.data_llint < length; d.data_llint++) {
-    list.push_back(&list, d);
+    list_push_back(&list, d);
   }
 
   // Test that peek works correctly with data.
-  TA_LLINT_EQ(list.peek_back(&list, &status).data_llint, (long long)4);
+  TA_LLINT_EQ(list_peek_back(&list, &status).data_llint, (long long)4);
   TA_INT_EQ(status, SMB_SUCCESS);
 
   // Check that pop works correctly.
   for (d.data_llint = length-1; d.data_llint >= 0; d.data_llint--) {
-    TA_LLINT_EQ(list.pop_back(&list, &status).data_llint, d.data_llint);
+    TA_LLINT_EQ(list_pop_back(&list, &status).data_llint, d.data_llint);
     TA_INT_EQ(status, SMB_SUCCESS);
   }
 
   // Check that peek and pop will fail correctly.
-  list.peek_back(&list, &status);
+  list_peek_back(&list, &status);
   TA_INT_EQ(status, SMB_INDEX_ERROR);
   status = SMB_SUCCESS;
-  list.pop_back(&list, &status);
+  list_pop_back(&list, &status);
   TA_INT_EQ(status, SMB_INDEX_ERROR);
 
   // Cleanup
-  list.delete(&list);
+  list_delete(&list);
   return 0;
 }
 
@@ -335,29 +336,44 @@ int test_index_of(void)
   d.data_ptr = t1;
 
   // Check that the string won't be found in an empty list.
-  TA_INT_EQ(list.index_of(&list, d, &data_compare_string), -1);
+  TA_INT_EQ(list_index_of(&list, d, &data_compare_string), -1);
 
   // Now add the copy to the list.
   d2.data_ptr = t2;
-  list.append(&list, d2);
+  list_append(&list, d2);
 
   // Now assert that the string will be found in the list.
-  TA_INT_EQ(list.index_of(&list, d, &data_compare_string), 0);
+  TA_INT_EQ(list_index_of(&list, d, &data_compare_string), 0);
 
   smb_free(t2);
-  list.pop_back(&list, &status);
+  list_pop_back(&list, &status);
 
   // Push test data to get 0, 1, 2, 3, 4, ..., 20
   for (d.data_llint = 0; d.data_llint < length; d.data_llint++) {
-    list.push_back(&list, d);
+    list_push_back(&list, d);
   }
 
   // Check that it finds the data.
   for (d.data_llint = 0; d.data_llint < length; d.data_llint++) {
-    TA_LLINT_EQ((long long)list.index_of(&list, d, NULL), d.data_llint);
+    TA_LLINT_EQ((long long)list_index_of(&list, d, NULL), d.data_llint);
   }
 
-  list.delete(&list);
+  list_delete(&list);
+  return 0;
+}
+
+/**
+   The generic list is just a tagged pointer, and deleting through it clears the
+   pointer.
+ */
+int test_handle(void)
+{
+  smb_list list = get_list();
+
+  TA_SIZE_LE(sizeof(smb_list), 2 * sizeof(void*));
+  TA_PTR_NE(list.data, NULL);
+  list_delete(&list);
+  TA_PTR_EQ(list.data, NULL);
   return 0;
 }
 
@@ -403,6 +419,9 @@ void run_list_tests(char *desc)
   smb_ut_test *index_of = su_create_test("index_of", test_index_of);
   su_add_test(group, index_of);
 
+  smb_ut_test *handle = su_create_test("handle", test_handle);
+  su_add_test(group, handle);
+
   su_run_group(group);
   su_delete_group(group);
 }
@@ -417,4 +436,7 @@ void list_test(void)
 
   get_list = &al_create_list;
   run_list_tests("al: test/listtest.c");
+
+  get_list = &ul_create_list;
+  run_list_tests("ul: test/listtest.c");
 }
@@ -29,8 +29,14 @@ int main(int argc, char ** argv)
   sl_set_level(NULL, LEVEL_INFO);
   linked_list_test();
   array_list_test();
+  unrolled_list_test();
   hash_table_test();
   hta_test();
+  cache_test();
+  cht_test();
+  htt_test();
+  oht_test();
+  rht_test();
   bit_field_test();
   iter_test();
   list_test();
@@ -0,0 +1,183 @@
+/***************************************************************************//**
+
+  @file         ohttest.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Tests for the ordered hash table.
+
+  @copyright    Copyright (c) 2013-2016, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#include <stdio.h>
+
+#include "tests.h"
+#include "libstephen/ut.h"
+#include "libstephen/oht.h"
+
+unsigned int oht_test_deletions = 0;
+
+void oht_test_deleter(DATA value)
+{
+  (void) value; // unused
+  oht_test_deletions++;
+}
+
+int oht_test_insert()
+{
+  smb_status status = SMB_SUCCESS;
+  long long i;
+  DATA value;
+  smb_oht *table = oht_create(&ht_int_hash, &data_compare_int);
+
+  for (i = 0; i < 1000; i++) {
+    oht_insert(table, LLINT(i), LLINT(-i));
+  }
+  TA_INT_EQ(table->length, 1000);
+
+  for (i = 0; i < 1000; i += 2) {
+    oht_remove(table, LLINT(i), &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+  }
+  oht_remove(table, LLINT(0), &status);
+  TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+
+  for (i = 0; i < 1000; i++) {
+    value = oht_get(table, LLINT(i), &status);
+    if (i % 2 == 0) {
+      TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+      TEST_ASSERT(!oht_contains(table, LLINT(i)));
+    } else {
+      TA_INT_EQ(status, SMB_SUCCESS);
+      TA_LLINT_EQ(value.data_llint, -i);
+    }
+  }
+
+  oht_delete(table);
+  return 0;
+}
+
+/**
+   Keys are iterated in the order they were first inserted.  Updating a key
+   keeps its place, but removing and reinserting it moves it to the end.
+ */
+int oht_test_order()
+{
+  smb_status status = SMB_SUCCESS;
+  long long i, expected[] = {1, 2, 4, 5, 6, 7, 8, 9, 0};
+  DATA key;
+  smb_oht *table = oht_create(&ht_int_hash, &data_compare_int);
+  smb_iter it;
+
+  for (i = 0; i < 10; i++) {
+    oht_insert(table, LLINT(i), LLINT(i));
+  }
+  oht_insert(table, LLINT(5), LLINT(50));
+  oht_remove(table, LLINT(3), &status);
+  oht_remove(table, LLINT(0), &status);
+  oht_insert(table, LLINT(0), LLINT(0));
+
+  it = oht_get_iter(table);
+  for (i = 0; it.has_next(&it); i++) {
+    key = it.next(&it, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+    TA_LLINT_EQ(key.data_llint, expected[i]);
+  }
+  TA_INT_EQ(i, 9);
+  it.next(&it, &status);
+  TA_INT_EQ(status, SMB_STOP_ITERATION);
+  it.destroy(&it);
+
+  // The order survives rebuilds.
+  oht_reserve(table, 1000);
+  TEST_ASSERT(table->allocated >= 2000);
+  TA_INT_EQ(table->nentries, 9);
+  it = oht_get_iter(table);
+  for (i = 0; it.has_next(&it); i++) {
+    key = it.next(&it, &status);
+    TA_LLINT_EQ(key.data_llint, expected[i]);
+  }
+  it.destroy(&it);
+
+  oht_delete(table);
+  return 0;
+}
+
+/**
+   Churn through many keys with a small live set.  The table shouldn't grow,
+   and the entry array should be squeezed instead.
+ */
+int oht_test_churn()
+{
+  smb_status status = SMB_SUCCESS;
+  long long i;
+  smb_oht *table = oht_create(&ht_int_hash, &data_compare_int);
+
+  for (i = 0; i < 10000; i++) {
+    oht_insert(table, LLINT(i), LLINT(i));
+    if (i >= 5) {
+      oht_remove(table, LLINT(i - 5), &status);
+      TA_INT_EQ(status, SMB_SUCCESS);
+    }
+  }
+  TA_INT_EQ(table->length, 5);
+  TA_INT_EQ(table->allocated, HASH_TABLE_INITIAL_SIZE);
+  TEST_ASSERT(table->nentries <= HASH_TABLE_INITIAL_SIZE);
+  for (i = 9995; i < 10000; i++) {
+    TEST_ASSERT(oht_contains(table, LLINT(i)));
+  }
+
+  // Shrinking after a burst also bounds the entries left behind.
+  for (i = 0; i < 5000; i++) {
+    oht_insert(table, LLINT(i), LLINT(i));
+  }
+  for (i = 0; i < 5000; i++) {
+    oht_remove(table, LLINT(i), &status);
+  }
+  TA_INT_EQ(table->length, 5);
+  TA_INT_EQ(table->allocated, HASH_TABLE_INITIAL_SIZE);
+
+  oht_delete(table);
+  return 0;
+}
+
+int oht_test_destroy_act()
+{
+  smb_status status = SMB_SUCCESS;
+  long long i;
+  smb_oht *table = oht_create(&ht_int_hash, &data_compare_int);
+
+  oht_test_deletions = 0;
+  for (i = 0; i < 100; i++) {
+    oht_insert(table, LLINT(i), LLINT(i));
+  }
+  oht_remove_act(table, LLINT(7), &oht_test_deleter, &status);
+  TA_INT_EQ(oht_test_deletions, 1);
+  oht_delete_act(table, &oht_test_deleter);
+  TA_INT_EQ(oht_test_deletions, 100);
+  return 0;
+}
+
+void oht_test(void)
+{
+  smb_ut_group *group = su_create_test_group("test/ohttest.c");
+
+  smb_ut_test *insert = su_create_test("insert", oht_test_insert);
+  su_add_test(group, insert);
+
+  smb_ut_test *order = su_create_test("order", oht_test_order);
+  su_add_test(group, order);
+
+  smb_ut_test *churn = su_create_test("churn", oht_test_churn);
+  su_add_test(group, churn);
+
+  smb_ut_test *destroy_act = su_create_test("destroy_act", oht_test_destroy_act);
+  su_add_test(group, destroy_act);
+
+  su_run_group(group);
+  su_delete_group(group);
+}
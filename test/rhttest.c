@@ -0,0 +1,177 @@
+/***************************************************************************//**
+
+  @file         rhttest.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Tests for the read-mostly hash table.
+
+  @copyright    Copyright (c) 2013-2016, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "tests.h"
+#include "libstephen/ut.h"
+#include "libstephen/rht.h"
+
+#define RHT_TEST_READERS 4
+#define RHT_TEST_KEYS 64
+#define RHT_TEST_WRITES 500
+
+typedef struct {
+  smb_rht *table;
+  int done;
+  int errors;
+  int reads;
+} rht_test_arg;
+
+int rht_test_basic()
+{
+  smb_status status = SMB_SUCCESS;
+  smb_rht *table = rht_create(&hta_int_hash, &hta_int_comp, sizeof(int),
+                              sizeof(int), HTA_QUADRATIC);
+  smb_rht_reader *reader = rht_reader_create(table);
+  const smb_hta *snapshot;
+  int key, value;
+
+  for (key = 0; key < 100; key++) {
+    value = -key;
+    rht_insert(table, &key, &value);
+  }
+  for (key = 0; key < 100; key++) {
+    rht_get(table, reader, &key, &value, &status);
+    TA_INT_EQ(status, SMB_SUCCESS);
+    TA_INT_EQ(value, -key);
+  }
+
+  // A snapshot is unaffected by writes made while it is being read.
+  snapshot = rht_read_begin(table, reader);
+  key = 5;
+  rht_remove(table, &key, &status);
+  TA_INT_EQ(status, SMB_SUCCESS);
+  TEST_ASSERT(hta_contains(snapshot, &key));
+  TA_INT_EQ(snapshot->length, 100);
+  rht_read_end(table, reader);
+
+  rht_get(table, reader, &key, &value, &status);
+  TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+  status = SMB_SUCCESS;
+  rht_remove(table, &key, &status);
+  TA_INT_EQ(status, SMB_NOT_FOUND_ERROR);
+
+  // Once the reader is done, nothing retired is kept around.
+  rht_reclaim(table);
+  TEST_ASSERT(table->retired == NULL);
+
+  rht_reader_delete(table, reader);
+  rht_delete(table);
+  return 0;
+}
+
+/**
+   Repeatedly read every key, checking that each snapshot is consistent: the
+   writer always sets every key to the same value in a single write.
+ */
+static void *rht_test_reader(void *varg)
+{
+  rht_test_arg *arg = varg;
+  smb_status status = SMB_SUCCESS;
+  smb_rht_reader *reader = rht_reader_create(arg->table);
+  const smb_hta *snapshot;
+  int key, first, value;
+  void *slot;
+
+  while (!__atomic_load_n(&arg->done, __ATOMIC_ACQUIRE)) {
+    snapshot = rht_read_begin(arg->table, reader);
+    // Values are in packed slots, so they're copied out rather than
+    // dereferenced, since they may be misaligned.
+    memcpy(&first, hta_get(snapshot, &(int){0}, &status), sizeof(first));
+    for (key = 1; key < RHT_TEST_KEYS; key++) {
+      slot = hta_get(snapshot, &key, &status);
+      if (status == SMB_SUCCESS) {
+        memcpy(&value, slot, sizeof(value));
+      }
+      if (status != SMB_SUCCESS || value != first) {
+        arg->errors++;
+        status = SMB_SUCCESS;
+      }
+    }
+    rht_read_end(arg->table, reader);
+    arg->reads++;
+  }
+
+  rht_reader_delete(arg->table, reader);
+  return NULL;
+}
+
+int rht_test_threads_mode(smb_hta_mode mode)
+{
+  pthread_t threads[RHT_TEST_READERS];
+  rht_test_arg args[RHT_TEST_READERS];
+  smb_rht *table = rht_create(&hta_int_hash, &hta_int_comp, sizeof(int),
+                              sizeof(int), mode);
+  smb_hta *copy;
+  int i, key;
+
+  copy = rht_write_begin(table);
+  for (key = 0; key < RHT_TEST_KEYS; key++) {
+    hta_insert(copy, &key, &(int){0});
+  }
+  rht_write_commit(table, copy);
+
+  for (i = 0; i < RHT_TEST_READERS; i++) {
+    args[i].table = table;
+    args[i].done = 0;
+    args[i].errors = 0;
+    args[i].reads = 0;
+    pthread_create(&threads[i], NULL, rht_test_reader, &args[i]);
+  }
+
+  for (i = 1; i <= RHT_TEST_WRITES; i++) {
+    copy = rht_write_begin(table);
+    for (key = 0; key < RHT_TEST_KEYS; key++) {
+      hta_insert(copy, &key, &i);
+    }
+    rht_write_commit(table, copy);
+  }
+
+  for (i = 0; i < RHT_TEST_READERS; i++) {
+    __atomic_store_n(&args[i].done, 1, __ATOMIC_RELEASE);
+    pthread_join(threads[i], NULL);
+    TA_INT_EQ(args[i].errors, 0);
+  }
+
+  rht_reclaim(table);
+  TEST_ASSERT(table->retired == NULL);
+  TEST_ASSERT(table->readers == NULL);
+  rht_delete(table);
+  return 0;
+}
+
+int rht_test_threads()
+{
+  int rv = rht_test_threads_mode(HTA_QUADRATIC);
+  if (rv) return rv;
+  return rht_test_threads_mode(HTA_SWISS);
+}
+
+void rht_test(void)
+{
+  smb_ut_group *group = su_create_test_group("test/rhttest.c");
+
+  smb_ut_test *basic = su_create_test("basic", rht_test_basic);
+  su_add_test(group, basic);
+
+  smb_ut_test *threads = su_create_test("threads", rht_test_threads);
+  su_add_test(group, threads);
+
+  su_run_group(group);
+  su_delete_group(group);
+}
@@ -23,6 +23,11 @@ void linked_list_test();
  */
 void array_list_test();
 
+/**
+   Run the unrolled list tests
+ */
+void unrolled_list_test(void);
+
 /**
    Run the hash table tests
  */
@@ -33,6 +38,31 @@ void hash_table_test();
 */
 void hta_test();
 
+/**
+   Run the LRU cache tests
+*/
+void cache_test(void);
+
+/**
+   Run the concurrent hash table tests
+*/
+void cht_test(void);
+
+/**
+   Run the type specialized hash table tests
+*/
+void htt_test(void);
+
+/**
+   Run the ordered hash table tests
+*/
+void oht_test(void);
+
+/**
+   Run the read-mostly hash table tests
+*/
+void rht_test(void);
+
 /**
    Run the bit field tests
  */
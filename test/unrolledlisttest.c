@@ -0,0 +1,147 @@
+/***************************************************************************//**
+
+  @file         unrolledlisttest.c
+
+  @author       Stephen Brennan
+
+  @date         Created Sunday, 18 October 2026
+
+  @brief        Tests for the unrolled list.  The list interface is also tested
+                through listtest.c and itertest.c.
+
+  @copyright    Copyright (c) 2013-2016, Stephen Brennan.  Released under the
+                Revised BSD License.  See the LICENSE.txt file for details.
+
+*******************************************************************************/
+
+#include "libstephen/ul.h"
+#include "libstephen/ut.h"
+#include "tests.h"
+
+/**
+   Check the list's nodes: none are empty, their counts add up to the length,
+   and the links agree in both directions.
+ */
+static int ul_test_check_nodes(const smb_ul *list)
+{
+  const smb_ul_node *node, *prev = NULL;
+  int total = 0;
+  for (node = list->head; node; node = node->next) {
+    TA_PTR_EQ(node->prev, prev);
+    TA_INT_GT((int) node->count, 0);
+    TA_INT_LE((int) node->count, (int) SMB_UL_NODE_ITEMS);
+    total += node->count;
+    prev = node;
+  }
+  TA_PTR_EQ(list->tail, prev);
+  TA_INT_EQ(total, list->length);
+  return 0;
+}
+
+int ul_test_node_size(void)
+{
+  TA_SIZE_EQ(sizeof(smb_ul_node), (size_t) SMB_UL_NODE_SIZE);
+  return 0;
+}
+
+/**
+   Appending or prepending fills each node before starting another.
+ */
+int ul_test_fill(void)
+{
+  smb_status status = SMB_SUCCESS;
+  smb_ul *list = ul_create();
+  const smb_ul_node *node;
+  int i, rv, nodes = 0;
+
+  for (i = 0; i < 1000; i++) {
+    ul_append(list, LLINT(i));
+    ul_prepend(list, LLINT(-i - 1));
+  }
+  for (node = list->head; node; node = node->next) {
+    nodes++;
+  }
+  // Only the first and last nodes may be partly full.
+  TA_INT_LE(nodes, 2000 / (int) SMB_UL_NODE_ITEMS + 2);
+  for (i = 0; i < 2000; i++) {
+    TA_LLINT_EQ(ul_get(list, i, &status).data_llint, (long long) i - 1000);
+  }
+  rv = ul_test_check_nodes(list);
+  if (rv) {
+    return rv;
+  }
+
+  ul_delete(list);
+  return 0;
+}
+
+/**
+   Insert and remove at scattered positions, comparing against a plain array,
+   and checking the nodes after each step.
+ */
+int ul_test_insert_remove(void)
+{
+  smb_status status = SMB_SUCCESS;
+  smb_ul *list = ul_create();
+  long long expect[2000];
+  int i, j, n = 0, index, rv;
+  smb_iter it;
+
+  for (i = 0; i < 3000; i++) {
+    index = (i * 7919) % (n + 1);
+    if (n > 0 && (i % 3 == 2 || i > 2000)) {
+      index = index % n;
+      ul_remove(list, index, &status);
+      TA_INT_EQ(status, SMB_SUCCESS);
+      for (j = index; j < n - 1; j++) {
+        expect[j] = expect[j + 1];
+      }
+      n--;
+    } else {
+      ul_insert(list, index, LLINT(i));
+      for (j = n; j > index; j--) {
+        expect[j] = expect[j - 1];
+      }
+      expect[index] = i;
+      n++;
+    }
+    rv = ul_test_check_nodes(list);
+    if (rv) {
+      return rv;
+    }
+    if (i % 100 == 0 || i > 2990) {
+      it = ul_get_iter(list);
+      for (j = 0; j < n; j++) {
+        TA_INT_EQ(it.has_next(&it), true);
+        TA_LLINT_EQ(it.next(&it, &status).data_llint, expect[j]);
+      }
+      TA_INT_EQ(it.has_next(&it), false);
+      it.destroy(&it);
+    }
+  }
+  TA_INT_EQ(n, 0);
+  TA_PTR_EQ(list->head, NULL);
+
+  ul_remove(list, 0, &status);
+  TA_INT_EQ(status, SMB_INDEX_ERROR);
+  ul_delete(list);
+  return 0;
+}
+
+void unrolled_list_test(void)
+{
+  smb_ut_group *group = su_create_test_group("test/unrolledlisttest.c");
+
+  smb_ut_test *node_size = su_create_test("node_size", ul_test_node_size);
+  su_add_test(group, node_size);
+
+  smb_ut_test *fill = su_create_test("fill", ul_test_fill);
+  su_add_test(group, fill);
+
+  smb_ut_test *insert_remove = su_create_test("insert_remove",
+                                              ul_test_insert_remove);
+  su_add_test(group, insert_remove);
+
+  su_run_group(group);
+  su_delete_group(group);
+}